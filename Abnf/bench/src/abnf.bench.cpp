@@ -0,0 +1,108 @@
+#include <benchmark/benchmark.h>
+#include <abnf/abnf.hpp>
+#include <string>
+
+using namespace abnf;
+
+// ============================================================================
+// Membership
+// ============================================================================
+
+static void BM_MatchCoreRule(benchmark::State &state)
+{
+    const ABNF rule = ABNF::alpha() | ABNF::digit();
+    std::string input(static_cast<size_t>(state.range(0)), '\0');
+    for (size_t i = 0; i < input.size(); ++i)
+    {
+        input[i] = static_cast<char>(i);
+    }
+
+    for (auto _ : state)
+    {
+        size_t matched = 0;
+        for (char ch : input)
+        {
+            matched += rule(ch) ? 1 : 0;
+        }
+        benchmark::DoNotOptimize(matched);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input.size()));
+}
+BENCHMARK(BM_MatchCoreRule)->RangeMultiplier(8)->Range(64, 64 << 10);
+
+// ============================================================================
+// Set Operations
+// ============================================================================
+
+static void BM_Union(benchmark::State &state)
+{
+    const ABNF a = ABNF::alpha();
+    const ABNF b = ABNF::digit();
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(a | b);
+    }
+}
+BENCHMARK(BM_Union);
+
+static void BM_Intersection(benchmark::State &state)
+{
+    const ABNF a = ABNF::vchar();
+    const ABNF b = ABNF::hexdig();
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(a & b);
+    }
+}
+BENCHMARK(BM_Intersection);
+
+static void BM_Complement(benchmark::State &state)
+{
+    const ABNF a = ABNF::wsp();
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(~a);
+    }
+}
+BENCHMARK(BM_Complement);
+
+static void BM_Count(benchmark::State &state)
+{
+    const ABNF a = ABNF::vchar() | ABNF::wsp();
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(a.count());
+    }
+}
+BENCHMARK(BM_Count);
+
+// ============================================================================
+// Construction
+// ============================================================================
+
+static void BM_FromString(benchmark::State &state)
+{
+    const std::string chars = "abcdefghijklmnopqrstuvwxyz0123456789-._~";
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(ABNF::fromString(chars));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * chars.size()));
+}
+BENCHMARK(BM_FromString);
+
+static void BM_CoreRules(benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(ABNF::alpha());
+        benchmark::DoNotOptimize(ABNF::digit());
+        benchmark::DoNotOptimize(ABNF::vchar());
+    }
+}
+BENCHMARK(BM_CoreRules);
@@ -0,0 +1,772 @@
+#include <benchmark/benchmark.h>
+#include <fsm/fsm.hpp>
+#include <fsm/algebra.hpp>
+#include <fsm/dawg.hpp>
+#include <fsm/keywords.hpp>
+#include <fsm/matcher.hpp>
+#include <fsm/search.hpp>
+#include <abnf/abnf.hpp>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace fsm;
+using namespace abnf;
+
+// ============================================================================
+// Grammars
+// ============================================================================
+
+namespace
+{
+    std::shared_ptr<FSM> buildDigits()
+    {
+        return FSM::Builder("digits")
+            .setDebugFlags(DebugFlags::NONE)
+            .addState("START", StateType::START)
+            .addState("DIGITS", StateType::ACCEPT)
+            .setStartState("START")
+            .addAcceptState("DIGITS")
+            .addTransition("START", "DIGITS", ABNF::digit())
+            .addTransition("DIGITS", "DIGITS", ABNF::digit())
+            .build();
+    }
+
+    std::shared_ptr<FSM> buildEmail()
+    {
+        return FSM::Builder("simple_email")
+            .setDebugFlags(DebugFlags::NONE)
+            .addState("START", StateType::START)
+            .addState("LOCAL")
+            .addState("AT")
+            .addState("DOMAIN", StateType::ACCEPT)
+            .setStartState("START")
+            .addAcceptState("DOMAIN")
+            .addTransition("START", "LOCAL", ABNF::alpha())
+            .addTransition("LOCAL", "LOCAL", ABNF::alpha() | ABNF::digit() | ABNF::literal('.'))
+            .addTransition("LOCAL", "AT", ABNF::literal('@'))
+            .addTransition("AT", "DOMAIN", ABNF::alpha())
+            .addTransition("DOMAIN", "DOMAIN", ABNF::alpha() | ABNF::literal('.'))
+            .build();
+    }
+
+    // ("a" / "ab")* "c": every "a" is a choice point for the backtracking engine.
+    std::shared_ptr<FSM> buildAmbiguous()
+    {
+        return FSM::Builder("ambiguous")
+            .setDebugFlags(DebugFlags::NONE)
+            .addState("START", StateType::START)
+            .addState("A")
+            .addState("ACCEPT", StateType::ACCEPT)
+            .setStartState("START")
+            .addAcceptState("ACCEPT")
+            .addTransition("START", "START", ABNF::literal('a'), Transition::PRIORITY_HIGH)
+            .addTransition("START", "A", ABNF::literal('a'), Transition::PRIORITY_LOW)
+            .addTransition("A", "START", ABNF::literal('b'))
+            .addTransition("START", "ACCEPT", ABNF::literal('c'))
+            .build();
+    }
+
+    std::string makeDigits(size_t size)
+    {
+        std::string input(size, '0');
+        for (size_t i = 0; i < size; ++i)
+        {
+            input[i] = static_cast<char>('0' + i % 10);
+        }
+        return input;
+    }
+
+    std::string makeEmail(size_t size)
+    {
+        std::string input = "user@";
+        while (input.size() < size)
+        {
+            input += "example.";
+        }
+        input.resize(size);
+        input.back() = 'x';
+        return input;
+    }
+
+    void setBytes(benchmark::State &state, size_t bytes_per_iteration)
+    {
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes_per_iteration));
+    }
+}
+
+// ============================================================================
+// validate()
+// ============================================================================
+
+static void BM_ValidateDigits(benchmark::State &state)
+{
+    auto fsm = buildDigits();
+    fsm->setSIMDEnabled(false);
+    const std::string input = makeDigits(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(fsm->validate(input));
+    }
+    setBytes(state, input.size());
+}
+BENCHMARK(BM_ValidateDigits)->RangeMultiplier(8)->Range(64, 64 << 10);
+
+static void BM_ValidateDigitsSIMD(benchmark::State &state)
+{
+    auto fsm = buildDigits();
+    fsm->setSIMDEnabled(true);
+    const std::string input = makeDigits(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(fsm->validate(input));
+    }
+    setBytes(state, input.size());
+}
+BENCHMARK(BM_ValidateDigitsSIMD)->RangeMultiplier(8)->Range(64, 64 << 10);
+
+static void BM_ValidateEmail(benchmark::State &state)
+{
+    auto fsm = buildEmail();
+    const std::string input = makeEmail(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(fsm->validate(input));
+    }
+    setBytes(state, input.size());
+}
+BENCHMARK(BM_ValidateEmail)->RangeMultiplier(8)->Range(64, 64 << 10);
+
+static void BM_ValidateReject(benchmark::State &state)
+{
+    auto fsm = buildEmail();
+    const std::string input = "user!example.com";
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(fsm->validate(input));
+    }
+    setBytes(state, input.size());
+}
+BENCHMARK(BM_ValidateReject);
+
+// A payload that enters a state with no way to accept on its first byte.
+static void BM_ValidateRejectDeadState(benchmark::State &state)
+{
+    auto fsm = FSM::Builder("guarded")
+                   .setDebugFlags(DebugFlags::NONE)
+                   .addState("START", StateType::START)
+                   .addState("DIGITS", StateType::ACCEPT)
+                   .addState("TRAP")
+                   .setStartState("START")
+                   .addAcceptState("DIGITS")
+                   .addTransition("START", "DIGITS", ABNF::digit())
+                   .addTransition("DIGITS", "DIGITS", ABNF::digit())
+                   .addTransition("START", "TRAP", ABNF::alpha())
+                   .addTransition("TRAP", "TRAP", ABNF::alpha())
+                   .build();
+    const std::string input(static_cast<size_t>(state.range(0)), 'x');
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(fsm->validate(input));
+    }
+    setBytes(state, input.size());
+}
+BENCHMARK(BM_ValidateRejectDeadState)->Arg(64 << 10);
+
+// Eight digits exactly, fed a long run of digits: rejected on length alone.
+static void BM_ValidateRejectOversized(benchmark::State &state)
+{
+    FSM::Builder builder("fixed8");
+    builder.setDebugFlags(DebugFlags::NONE).addState("D0", StateType::START).setStartState("D0");
+    for (int i = 1; i <= 8; ++i)
+    {
+        builder.addState("D" + std::to_string(i))
+            .addTransition("D" + std::to_string(i - 1), "D" + std::to_string(i), ABNF::digit());
+    }
+    auto fsm = builder.addAcceptState("D8").build();
+    const std::string input = makeDigits(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(fsm->validate(input));
+    }
+    setBytes(state, input.size());
+}
+BENCHMARK(BM_ValidateRejectOversized)->Arg(64 << 10);
+
+// A four-byte magic number followed by an opaque body the machine accepts whole.
+static std::shared_ptr<FSM> buildMagicPrefix()
+{
+    return FSM::Builder("magic")
+        .setDebugFlags(DebugFlags::NONE)
+        .addState("S0", StateType::START)
+        .addState("S1")
+        .addState("S2")
+        .addState("S3")
+        .addState("BODY", StateType::ACCEPT)
+        .setStartState("S0")
+        .addAcceptState("BODY")
+        .addTransition("S0", "S1", ABNF::literal('G'))
+        .addTransition("S1", "S2", ABNF::literal('I'))
+        .addTransition("S2", "S3", ABNF::literal('F'))
+        .addTransition("S3", "BODY", ABNF::literal('8'))
+        .addTransition("BODY", "BODY", ABNF::octet())
+        .build();
+}
+
+static void BM_ValidateAcceptSink(benchmark::State &state)
+{
+    auto fsm = buildMagicPrefix();
+    const std::string input = "GIF8" + std::string(static_cast<size_t>(state.range(0)), 'x');
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(fsm->validate(input));
+    }
+    setBytes(state, input.size());
+}
+BENCHMARK(BM_ValidateAcceptSink)->Arg(1 << 20);
+
+static void BM_FastMatcherAcceptSink(benchmark::State &state)
+{
+    auto fsm = buildMagicPrefix();
+    FastMatcher matcher(*fsm);
+    const std::string input = "GIF8" + std::string(static_cast<size_t>(state.range(0)), 'x');
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(matcher.validate(input));
+    }
+    setBytes(state, input.size());
+}
+BENCHMARK(BM_FastMatcherAcceptSink)->Arg(1 << 20);
+
+static void BM_FastMatcherEmail(benchmark::State &state)
+{
+    auto fsm = buildEmail();
+    FastMatcher matcher(*fsm);
+    const std::string input = makeEmail(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(matcher.validate(input));
+    }
+    setBytes(state, input.size());
+}
+BENCHMARK(BM_FastMatcherEmail)->RangeMultiplier(8)->Range(64, 64 << 10);
+
+static void BM_FastMatcherEmailComb(benchmark::State &state)
+{
+    auto fsm = buildEmail();
+    FastMatcher matcher(std::make_shared<const CompiledFSM>(*fsm, CompiledFSM::TableLayout::COMB));
+    const std::string input = makeEmail(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(matcher.validate(input));
+    }
+    setBytes(state, input.size());
+}
+BENCHMARK(BM_FastMatcherEmailComb)->RangeMultiplier(8)->Range(64, 64 << 10);
+
+// Short inputs are dominated by per-run setup rather than the scan.
+static void BM_ValidateTiny(benchmark::State &state)
+{
+    auto fsm = buildEmail();
+    const std::string input = "ab@cd.efgh";
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(fsm->validate(input));
+    }
+    setBytes(state, input.size());
+}
+BENCHMARK(BM_ValidateTiny);
+
+static void BM_FastMatcherTiny(benchmark::State &state)
+{
+    auto fsm = buildEmail();
+    FastMatcher matcher(*fsm);
+    const std::string input = "ab@cd.efgh";
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(matcher.validate(input));
+    }
+    setBytes(state, input.size());
+}
+BENCHMARK(BM_FastMatcherTiny);
+
+// ============================================================================
+// Keyword Sets
+// ============================================================================
+
+static const std::vector<std::string> &httpMethods()
+{
+    static const std::vector<std::string> methods = {"GET", "HEAD", "POST", "PUT", "DELETE",
+                                                     "CONNECT", "OPTIONS", "TRACE", "PATCH"};
+    return methods;
+}
+
+// A trie over the methods, one state per prefix
+static std::shared_ptr<FSM> buildMethods()
+{
+    auto fsm = std::make_shared<FSM>("http_method");
+    const StateID start = fsm->addState("", StateType::START);
+    fsm->setStartState(start);
+
+    std::map<std::string, StateID> prefixes{{"", start}};
+    for (const std::string &method : httpMethods())
+    {
+        for (size_t i = 1; i <= method.size(); ++i)
+        {
+            const std::string prefix = method.substr(0, i);
+            if (!prefixes.count(prefix))
+            {
+                prefixes[prefix] = fsm->addState(prefix);
+                fsm->addTransition(prefixes[method.substr(0, i - 1)], prefixes[prefix], ABNF::literal(method[i - 1]));
+            }
+        }
+        fsm->addAcceptState(prefixes[method]);
+    }
+    return fsm;
+}
+
+static void BM_FastMatcherMethods(benchmark::State &state)
+{
+    auto fsm = buildMethods();
+    FastMatcher matcher(*fsm);
+    const auto &methods = httpMethods();
+
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(matcher.validate(methods[i++ % methods.size()]));
+    }
+}
+BENCHMARK(BM_FastMatcherMethods);
+
+static void BM_KeywordSetMethods(benchmark::State &state)
+{
+    const KeywordSet set(*buildMethods());
+    const auto &methods = httpMethods();
+
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(set.find(methods[i++ % methods.size()]));
+    }
+}
+BENCHMARK(BM_KeywordSetMethods);
+
+static void BM_ValidateMethods(benchmark::State &state)
+{
+    auto fsm = buildMethods();
+    fsm->setEngine(static_cast<FSM::Engine>(state.range(0)));
+    const auto &methods = httpMethods();
+
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(fsm->validate(methods[i++ % methods.size()]));
+    }
+    state.SetLabel(FSM::engineToString(fsm->getEngine()));
+}
+BENCHMARK(BM_ValidateMethods)
+    ->Arg(static_cast<int>(FSM::Engine::TABLE))
+    ->Arg(static_cast<int>(FSM::Engine::KEYWORDS));
+
+// ============================================================================
+// Word Lists
+// ============================================================================
+
+// Pseudo-random stems with common endings, sorted: a dictionary-shaped list
+static const std::vector<std::string> &dictionary()
+{
+    static const std::vector<std::string> words = []
+    {
+        std::set<std::string> unique;
+        uint64_t seed = 0x9e3779b97f4a7c15ULL;
+        while (unique.size() < 200000)
+        {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            std::string stem;
+            for (uint64_t bits = seed >> 20, length = 3 + (seed >> 60) % 6; stem.size() < length; bits /= 26)
+            {
+                stem.push_back(static_cast<char>('a' + bits % 26));
+            }
+            for (const char *ending : {"", "s", "ed", "ing"})
+            {
+                unique.insert(stem + ending);
+            }
+        }
+        return std::vector<std::string>(unique.begin(), unique.end());
+    }();
+    return words;
+}
+
+static void BM_DawgBuild(benchmark::State &state)
+{
+    const auto &words = dictionary();
+
+    for (auto _ : state)
+    {
+        Dawg::Builder builder;
+        for (const std::string &word : words)
+        {
+            builder.add(word);
+        }
+        benchmark::DoNotOptimize(builder.build());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * words.size()));
+}
+BENCHMARK(BM_DawgBuild)->Unit(benchmark::kMillisecond);
+
+static void BM_DawgValidate(benchmark::State &state)
+{
+    const auto &words = dictionary();
+    Dawg::Builder builder;
+    for (const std::string &word : words)
+    {
+        builder.add(word);
+    }
+    const Dawg dawg = builder.build();
+
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(dawg.validate(words[i]));
+        i = (i + 7919) % words.size();
+    }
+    state.SetLabel(dawg.toString());
+}
+BENCHMARK(BM_DawgValidate);
+
+// ============================================================================
+// Combined Constraints
+// ============================================================================
+
+// Anything containing ".." - has to read the whole input to reject
+static std::shared_ptr<FSM> buildDenylist()
+{
+    const ABNF not_dot = ABNF(uint8_t{0x00}, uint8_t{0x2D}) | ABNF(uint8_t{0x2F}, uint8_t{0xFF});
+    return FSM::Builder("denylist")
+        .addState("SCAN", StateType::START)
+        .addState("DOT")
+        .addState("DOTS", StateType::ACCEPT)
+        .setStartState("SCAN")
+        .addAcceptState("DOTS")
+        .addTransition("SCAN", "SCAN", not_dot)
+        .addTransition("SCAN", "DOT", ABNF::literal('.'))
+        .addTransition("DOT", "SCAN", not_dot)
+        .addTransition("DOT", "DOTS", ABNF::literal('.'))
+        .addTransition("DOTS", "DOTS", ABNF::octet())
+        .build();
+}
+
+static void BM_TwoMatchers(benchmark::State &state)
+{
+    auto email = buildEmail();
+    auto denylist = buildDenylist();
+    FastMatcher allow(*email);
+    FastMatcher deny(*denylist);
+    const std::string input = makeEmail(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(allow.validate(input) && !deny.validate(input));
+    }
+    setBytes(state, input.size());
+}
+BENCHMARK(BM_TwoMatchers)->RangeMultiplier(8)->Range(64, 64 << 10);
+
+static void BM_CombinedMatcher(benchmark::State &state)
+{
+    auto combined = difference(*buildEmail(), *buildDenylist());
+    FastMatcher matcher(*combined);
+    const std::string input = makeEmail(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(matcher.validate(input));
+    }
+    setBytes(state, input.size());
+}
+BENCHMARK(BM_CombinedMatcher)->RangeMultiplier(8)->Range(64, 64 << 10);
+
+// ============================================================================
+// Search
+// ============================================================================
+
+// Words with a number every few tokens
+static std::string makeText(size_t size)
+{
+    static const char *tokens[] = {"alpha ", "beta ", "12 ", "gamma ", "delta ", "2024 ", "epsilon ", "7 "};
+    std::string text;
+    for (size_t i = 0; text.size() < size; ++i)
+    {
+        text += tokens[i % 8];
+    }
+    text.resize(size);
+    return text;
+}
+
+static void BM_SearchAll(benchmark::State &state)
+{
+    Searcher numbers(*buildDigits());
+    const std::string text = makeText(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(numbers.findAll(text));
+    }
+    setBytes(state, text.size());
+}
+BENCHMARK(BM_SearchAll)->RangeMultiplier(8)->Range(64, 64 << 10);
+
+static void BM_SearchContains(benchmark::State &state)
+{
+    Searcher numbers(*buildDigits());
+    // One number, at the very end
+    std::string text = makeText(static_cast<size_t>(state.range(0)));
+    for (char &ch : text)
+    {
+        ch = ch >= '0' && ch <= '9' ? 'x' : ch;
+    }
+    text.back() = '0';
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(numbers.contains(text));
+    }
+    setBytes(state, text.size());
+}
+BENCHMARK(BM_SearchContains)->Arg(64 << 10);
+
+// "a" / 1*"a" "b" over a run of a's: each "a" matches on its own, but the
+// longest-match scan after it runs on looking for a "b". Time per byte
+// should stay flat as the run grows.
+static void BM_SearchLongRun(benchmark::State &state)
+{
+    auto fsm = FSM::Builder("run_then_b")
+                   .setDebugFlags(DebugFlags::NONE)
+                   .addState("S", StateType::START)
+                   .addState("A", StateType::ACCEPT)
+                   .addState("L")
+                   .addState("E", StateType::ACCEPT)
+                   .setStartState("S")
+                   .addAcceptState("A")
+                   .addAcceptState("E")
+                   .addTransition("S", "A", ABNF::literal('a'))
+                   .addTransition("A", "L", ABNF::literal('a'))
+                   .addTransition("A", "E", ABNF::literal('b'))
+                   .addTransition("L", "L", ABNF::literal('a'))
+                   .addTransition("L", "E", ABNF::literal('b'))
+                   .build();
+    Searcher searcher(*fsm);
+    const std::string text(static_cast<size_t>(state.range(0)), 'a');
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(searcher.count(text));
+    }
+    setBytes(state, text.size());
+}
+BENCHMARK(BM_SearchLongRun)->RangeMultiplier(4)->Range(20 << 10, 320 << 10)->Unit(benchmark::kMillisecond);
+
+// ============================================================================
+// Counting
+// ============================================================================
+
+static void BM_SearchCount(benchmark::State &state)
+{
+    Searcher numbers(*buildDigits());
+    const std::string text = makeText(16 << 20);
+    const auto threads = static_cast<unsigned>(state.range(0));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(threads == 1 ? numbers.count(text) : numbers.countParallel(text, threads));
+    }
+    setBytes(state, text.size());
+}
+BENCHMARK(BM_SearchCount)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// "aa" over a run of a's, sized so some chunks start at odd offsets. A
+// chunk's own search pairs the a's the other way round there, so stitching
+// relies on the chunk's second track instead of re-searching it serially.
+static void BM_SearchCountPeriodic(benchmark::State &state)
+{
+    auto fsm = FSM::Builder("pairs")
+                   .setDebugFlags(DebugFlags::NONE)
+                   .addState("START", StateType::START)
+                   .addState("A")
+                   .addState("AA", StateType::ACCEPT)
+                   .setStartState("START")
+                   .addAcceptState("AA")
+                   .addTransition("START", "A", ABNF::literal('a'))
+                   .addTransition("A", "AA", ABNF::literal('a'))
+                   .build();
+    Searcher pairs(*fsm);
+    const std::string text((16 << 20) + 3, 'a');
+    const auto threads = static_cast<unsigned>(state.range(0));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(threads == 1 ? pairs.count(text) : pairs.countParallel(text, threads));
+    }
+    setBytes(state, text.size());
+}
+BENCHMARK(BM_SearchCountPeriodic)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_CountRecords(benchmark::State &state)
+{
+    const CompiledFSM compiled(*buildMethods());
+    std::string lines;
+    for (size_t i = 0; lines.size() < (16 << 20); ++i)
+    {
+        lines += httpMethods()[i % httpMethods().size()];
+        lines += i % 3 == 0 ? " /index.html\n" : "\n";
+    }
+    const auto threads = static_cast<unsigned>(state.range(0));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(countRecords(compiled, lines, '\n', threads));
+    }
+    setBytes(state, lines.size());
+}
+BENCHMARK(BM_CountRecords)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// ============================================================================
+// feed()
+// ============================================================================
+
+static void BM_FeedChunks(benchmark::State &state)
+{
+    auto fsm = buildDigits();
+    const std::string input = makeDigits(64 << 10);
+    const size_t chunk = static_cast<size_t>(state.range(0));
+
+    for (auto _ : state)
+    {
+        fsm->reset();
+        for (size_t offset = 0; offset < input.size(); offset += chunk)
+        {
+            fsm->feed(std::string_view(input).substr(offset, chunk));
+        }
+        benchmark::DoNotOptimize(fsm->endOfStream());
+    }
+    setBytes(state, input.size());
+}
+BENCHMARK(BM_FeedChunks)->Arg(1)->Arg(16)->Arg(256)->Arg(4096);
+
+// ============================================================================
+// validateWithBacktracking()
+// ============================================================================
+
+static void BM_BacktrackingAmbiguous(benchmark::State &state)
+{
+    auto fsm = buildAmbiguous();
+    std::string input;
+    while (input.size() + 3 <= static_cast<size_t>(state.range(0)))
+    {
+        input += "aab";
+    }
+    input += "c";
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(fsm->validateWithBacktracking(input));
+    }
+    setBytes(state, input.size());
+}
+BENCHMARK(BM_BacktrackingAmbiguous)->RangeMultiplier(4)->Range(16, 4 << 10);
+
+// ============================================================================
+// Captures
+// ============================================================================
+
+static void BM_ValidateWithCaptures(benchmark::State &state)
+{
+    auto fsm = FSM::Builder("key_value")
+                   .setDebugFlags(DebugFlags::NONE)
+                   .addState("START", StateType::START)
+                   .addState("KEY")
+                   .addState("VALUE", StateType::ACCEPT)
+                   .setStartState("START")
+                   .addAcceptState("VALUE")
+                   .addTransition("START", "KEY", ABNF::alpha())
+                   .addTransition("KEY", "KEY", ABNF::alpha())
+                   .addTransition("KEY", "VALUE", ABNF::literal('='))
+                   .addTransition("VALUE", "VALUE", ABNF::digit())
+                   .build();
+
+    FSM *raw = fsm.get();
+    for (const auto &id : fsm->getStates())
+    {
+        if (id.name == "KEY")
+        {
+            fsm->setStateEntryCallback(id, [raw](const StateContext &)
+                                       { raw->beginCapture("key"); });
+            fsm->setStateExitCallback(id, [raw](const StateContext &)
+                                      { raw->endCapture("key"); });
+        }
+    }
+
+    const std::string input = std::string(static_cast<size_t>(state.range(0)), 'k') + "=12345";
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(fsm->validate(input));
+    }
+    setBytes(state, input.size());
+}
+BENCHMARK(BM_ValidateWithCaptures)->RangeMultiplier(8)->Range(8, 4 << 10);
+
+// ============================================================================
+// Composition
+// ============================================================================
+
+static void BM_ComposeEmbedded(benchmark::State &state)
+{
+    auto number = buildDigits();
+
+    for (auto _ : state)
+    {
+        FSM::Builder builder("dotted");
+        builder.addState("S0", StateType::START).setStartState("S0");
+
+        std::string from = "S0";
+        for (int64_t i = 0; i < state.range(0); ++i)
+        {
+            const std::string num = "N" + std::to_string(i);
+            const std::string dot = "D" + std::to_string(i);
+            builder.addTransition(from, num, number);
+            builder.addTransition(num, dot, ABNF::literal('.'));
+            from = dot;
+        }
+        builder.addAcceptState(from);
+
+        benchmark::DoNotOptimize(builder.build());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ComposeEmbedded)->Arg(4)->Arg(16)->Arg(64);
+
+static void BM_CompileTable(benchmark::State &state)
+{
+    auto fsm = buildEmail();
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(CompiledFSM(*fsm));
+    }
+}
+BENCHMARK(BM_CompileTable);
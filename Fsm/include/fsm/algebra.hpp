@@ -0,0 +1,61 @@
+#ifndef FSM_ALGEBRA_HPP
+#define FSM_ALGEBRA_HPP
+
+#include <fsm/fsm.hpp>
+#include <memory>
+
+namespace fsm
+{
+    // ============================================================================
+    // Language Operations
+    // ============================================================================
+    //
+    // Combine deterministic machines into one, so that several constraints
+    // ("a valid URI and not on the denylist") cost a single pass over the
+    // input with a single table:
+    //
+    //   auto allowed = difference(*uri, *denylist);
+    //   FastMatcher matcher(*allowed);
+    //
+    // Each operand is read through its compiled table, so first-match
+    // priorities and end-of-input epsilon edges count exactly as in
+    // validate(). The operands are run side by side over a shared set of
+    // byte classes (product construction), and the result is minimized. The
+    // result is a new machine with states q0 (start), q1, ... and one ABNF
+    // transition per target. Callbacks, actions and captures are not carried
+    // over.
+    //
+    // Operands with sub-machine calls or equal-priority overlaps (see
+    // FSM::getAmbiguities()) throw std::invalid_argument.
+    //
+    // `union` is a keyword, so union is unite().
+
+    [[nodiscard]] std::shared_ptr<FSM> intersect(const FSM &a, const FSM &b);
+    [[nodiscard]] std::shared_ptr<FSM> unite(const FSM &a, const FSM &b);
+    [[nodiscard]] std::shared_ptr<FSM> difference(const FSM &a, const FSM &b); // in a, not in b
+    [[nodiscard]] std::shared_ptr<FSM> complement(const FSM &a);               // every byte string a rejects
+
+    // The smallest deterministic machine for the same language
+    [[nodiscard]] std::shared_ptr<FSM> minimize(const FSM &a);
+
+    // ============================================================================
+    // Search Automata
+    // ============================================================================
+    //
+    // Both are built by subset construction, which can grow exponentially
+    // in the worst case; past MAX_SUBSET_STATES they throw
+    // std::invalid_argument instead. Searcher (<fsm/search.hpp>) uses them to
+    // find match ends going forward and match starts going backward.
+
+    constexpr size_t MAX_SUBSET_STATES = 1 << 16;
+
+    // Every byte string whose reversal a accepts
+    [[nodiscard]] std::shared_ptr<FSM> reverse(const FSM &a);
+
+    // Every byte string that ends with a match of a. Run over a text, it is
+    // in an accepting state exactly where some match ends.
+    [[nodiscard]] std::shared_ptr<FSM> unanchored(const FSM &a);
+
+} // namespace fsm
+
+#endif // FSM_ALGEBRA_HPP
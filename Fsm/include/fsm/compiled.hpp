@@ -0,0 +1,300 @@
+#ifndef FSM_COMPILED_HPP
+#define FSM_COMPILED_HPP
+
+#include <fsm/fsm.hpp>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace fsm
+{
+    // ============================================================================
+    // CompiledFSM - Dense Transition Table
+    // ============================================================================
+    //
+    // Flattens an FSM into a states x byte-classes table. Each cell holds the
+    // target of the first ABNF transition (in priority order) that matches the
+    // class, so lookups reproduce FSM::validate() exactly. States and
+    // transitions are copied out as cold data for debug and callback dispatch.
+    //
+    // Cells are stored in the narrowest unsigned type that can index every
+    // state, with the type's maximum as the dead cell: machines under 255
+    // states get a byte table, under 65535 a 16-bit one.
+    //
+    // Large sparse machines use a comb layout instead of the dense rectangle
+    // (row displacement with a check array, as in classic lexer generators):
+    // each state keeps a default edge, and only cells that differ from it are
+    // packed into one shared vector at a per-state base offset. A lookup is
+    // still one probe plus one compare.
+    //
+    // Either way a (state, class) pair resolves to a slot; next cells, edges
+    // and actions are all indexed by slot. Scanning loops are templated on a
+    // view of the layout and cell type, picked once per call with withTable().
+    // Edges are narrowed the same way, by transition count; they are cold
+    // data read only by hooks and transition events.
+
+    class CompiledFSM
+    {
+    public:
+        using StateIndex = uint32_t;
+        using EdgeIndex = uint32_t;
+
+        static constexpr StateIndex DEAD_STATE = UINT32_MAX;
+        static constexpr EdgeIndex NO_EDGE = UINT32_MAX;
+
+        // Bytes per table cell
+        enum class TableWidth : uint8_t
+        {
+            BITS_8 = 1,
+            BITS_16 = 2,
+            BITS_32 = 4
+        };
+
+        enum class TableLayout : uint8_t
+        {
+            AUTO, // comb when the dense table is large and mostly defaults
+            DENSE,
+            COMB
+        };
+
+        // AUTO never compresses tables below this size.
+        static constexpr size_t COMB_MIN_DENSE_BYTES = 256 << 10;
+
+        template <typename Cell>
+        static constexpr Cell DEAD_CELL = std::numeric_limits<Cell>::max();
+
+        template <typename CellType>
+        struct DenseView
+        {
+            using Cell = CellType;
+
+            const Cell *cells;
+            size_t class_count;
+
+            [[nodiscard]] size_t slot(StateIndex state, uint8_t byte_class) const
+            {
+                return static_cast<size_t>(state) * class_count + byte_class;
+            }
+        };
+
+        template <typename CellType>
+        struct CombView
+        {
+            using Cell = CellType;
+
+            const Cell *cells;
+            const Cell *check;
+            const uint32_t *base;
+            size_t default_slots; // first per-state default slot
+
+            [[nodiscard]] size_t slot(StateIndex state, uint8_t byte_class) const
+            {
+                const size_t packed = static_cast<size_t>(base[state]) + byte_class;
+                return check[packed] == static_cast<Cell>(state) ? packed : default_slots + state;
+            }
+        };
+
+        explicit CompiledFSM(const FSM &fsm, TableLayout layout = TableLayout::AUTO);
+
+        // Hot data
+        [[nodiscard]] StateIndex getStartState() const { return start_state_; }
+        [[nodiscard]] size_t getStateCount() const { return state_ids_.size(); }
+        [[nodiscard]] size_t getClassCount() const { return class_count_; }
+        [[nodiscard]] const uint8_t *getClassMap() const { return class_map_.data(); }
+        [[nodiscard]] TableWidth getTableWidth() const { return width_; }
+        [[nodiscard]] TableLayout getTableLayout() const { return layout_; }
+        [[nodiscard]] size_t getSlotCount() const { return slot_count_; }
+
+        // Dense cells; null unless the layout is dense and Cell matches getTableWidth().
+        template <typename Cell>
+        [[nodiscard]] const Cell *getTable() const;
+
+        // Calls fn(view) with a DenseView or CombView over the actual cell type.
+        template <typename Fn>
+        decltype(auto) withTable(Fn &&fn) const
+        {
+            switch (width_)
+            {
+            case TableWidth::BITS_8:
+                return withLayout(table8_, std::forward<Fn>(fn));
+            case TableWidth::BITS_16:
+                return withLayout(table16_, std::forward<Fn>(fn));
+            default:
+                return withLayout(table32_, std::forward<Fn>(fn));
+            }
+        }
+
+        [[nodiscard]] uint8_t getByteClass(unsigned char byte) const { return class_map_[byte]; }
+
+        [[nodiscard]] size_t slot(StateIndex state, unsigned char byte) const;
+        [[nodiscard]] StateIndex next(StateIndex state, unsigned char byte) const;
+
+        // Maps a narrow cell to a StateIndex, turning its dead cell into DEAD_STATE.
+        template <typename Cell>
+        [[nodiscard]] static StateIndex widen(Cell cell)
+        {
+            return cell == DEAD_CELL<Cell> ? DEAD_STATE : static_cast<StateIndex>(cell);
+        }
+
+        [[nodiscard]] TableWidth getEdgeWidth() const { return edge_width_; }
+        [[nodiscard]] const Transition::TransitionID *getTransitionIDs() const { return transition_ids_.data(); }
+
+        // NO_EDGE and DEAD_STATE share UINT32_MAX, so widen() restores both.
+        [[nodiscard]] EdgeIndex edgeAt(size_t slot) const
+        {
+            switch (edge_width_)
+            {
+            case TableWidth::BITS_8:
+                return widen(edges8_[slot]);
+            case TableWidth::BITS_16:
+                return widen(edges16_[slot]);
+            default:
+                return edges32_[slot];
+            }
+        }
+
+        [[nodiscard]] EdgeIndex edge(StateIndex state, unsigned char byte) const
+        {
+            return edgeAt(slot(state, byte));
+        }
+
+        // Action IDs are only materialised when at least one transition has one.
+        [[nodiscard]] bool hasActions() const { return !actions_.empty(); }
+        [[nodiscard]] const Transition::ActionID *getActions() const { return actions_.data(); }
+        [[nodiscard]] const uint8_t *getActionStates() const { return action_states_.data(); }
+
+        [[nodiscard]] Transition::ActionID action(StateIndex state, unsigned char byte) const
+        {
+            return actions_.empty() ? Transition::NO_ACTION : actions_[slot(state, byte)];
+        }
+
+        [[nodiscard]] bool isAcceptState(StateIndex state) const { return accept_[state] != 0; }
+        [[nodiscard]] bool isAcceptingAtEnd(StateIndex state) const { return accept_at_end_[state] != 0; }
+
+        // Accept states no byte can leave (see FSM::isAcceptSink()); a scan that
+        // reaches one can stop.
+        [[nodiscard]] bool hasAcceptSinks() const { return has_accept_sinks_; }
+        [[nodiscard]] bool isAcceptSink(StateIndex state) const { return accept_sinks_[state] != 0; }
+        [[nodiscard]] const uint8_t *getAcceptSinks() const { return accept_sinks_.data(); }
+
+        // Accepted input lengths, copied from FSM::getLengthBounds().
+        [[nodiscard]] const FSM::LengthBounds &getLengthBounds() const { return length_bounds_; }
+
+        // End of input follows epsilon edges the same way FSM::validate() does.
+        [[nodiscard]] const std::vector<EdgeIndex> &getEpsilonChain(StateIndex state) const
+        {
+            return epsilon_chains_[state];
+        }
+        [[nodiscard]] StateIndex getFinalState(StateIndex state) const { return final_states_[state]; }
+
+        // Cold data
+        [[nodiscard]] const std::string &getName() const { return name_; }
+        [[nodiscard]] const StateID &getStateID(StateIndex state) const { return state_ids_[state]; }
+        [[nodiscard]] const State &getState(StateIndex state) const { return states_[state]; }
+        [[nodiscard]] StateIndex indexOf(StateID id) const;
+        [[nodiscard]] const Transition &getTransition(EdgeIndex edge) const { return transitions_[edge]; }
+        [[nodiscard]] size_t getTransitionCount() const { return transitions_.size(); }
+        [[nodiscard]] StateIndex getTarget(EdgeIndex edge) const { return targets_[edge]; }
+
+        [[nodiscard]] bool hasCallbacks() const { return has_callbacks_; }
+        [[nodiscard]] size_t getTableBytes() const;
+        [[nodiscard]] std::string toString() const;
+
+    private:
+        std::string name_;
+
+        std::array<uint8_t, 256> class_map_{};
+        size_t class_count_ = 1;
+
+        // Next cells by slot, plus the owning state of each packed comb slot.
+        template <typename Cell>
+        struct CellTable
+        {
+            std::vector<Cell> cells;
+            std::vector<Cell> check;
+        };
+
+        TableWidth width_ = TableWidth::BITS_32;
+        TableLayout layout_ = TableLayout::DENSE;
+        CellTable<uint8_t> table8_;
+        CellTable<uint16_t> table16_;
+        CellTable<StateIndex> table32_;
+        std::vector<uint32_t> base_; // comb row offsets by state
+        size_t slot_count_ = 0;
+        TableWidth edge_width_ = TableWidth::BITS_32;
+        std::vector<uint8_t> edges8_; // by slot, in edge_width_
+        std::vector<uint16_t> edges16_;
+        std::vector<EdgeIndex> edges32_;
+        std::vector<Transition::ActionID> actions_;
+        std::vector<uint8_t> action_states_;
+        std::vector<uint8_t> accept_;
+        std::vector<uint8_t> accept_at_end_;
+        std::vector<uint8_t> accept_sinks_;
+        bool has_accept_sinks_ = false;
+        FSM::LengthBounds length_bounds_;
+        std::vector<StateIndex> final_states_;
+        std::vector<std::vector<EdgeIndex>> epsilon_chains_;
+        StateIndex start_state_ = DEAD_STATE;
+
+        std::vector<StateID> state_ids_;
+        std::unordered_map<StateID, StateIndex, StateID::Hash> index_of_;
+        std::vector<State> states_;
+        std::vector<Transition> transitions_;
+        std::vector<StateIndex> targets_;
+        std::vector<Transition::TransitionID> transition_ids_;
+        bool has_callbacks_ = false;
+
+        void buildByteClasses(const std::vector<const Transition *> &rules);
+        using RowFiller = std::function<void(StateIndex, EdgeIndex *)>;
+        std::vector<StateIndex> buildComb(const RowFiller &fill_row, std::vector<EdgeIndex> &edges);
+        void narrowTable(const std::vector<StateIndex> &cells, const std::vector<StateIndex> &check);
+        void narrowEdges(const std::vector<EdgeIndex> &edges);
+
+        template <typename Cell, typename Fn>
+        decltype(auto) withLayout(const CellTable<Cell> &table, Fn &&fn) const
+        {
+            if (layout_ == TableLayout::COMB)
+            {
+                return fn(CombView<Cell>{table.cells.data(), table.check.data(), base_.data(),
+                                         table.check.size()});
+            }
+            return fn(DenseView<Cell>{table.cells.data(), class_count_});
+        }
+    };
+
+    inline size_t CompiledFSM::slot(StateIndex state, unsigned char byte) const
+    {
+        return withTable([&](const auto &view)
+                         { return view.slot(state, class_map_[byte]); });
+    }
+
+    inline CompiledFSM::StateIndex CompiledFSM::next(StateIndex state, unsigned char byte) const
+    {
+        return withTable([&](const auto &view)
+                         { return widen(view.cells[view.slot(state, class_map_[byte])]); });
+    }
+
+    template <>
+    inline const uint8_t *CompiledFSM::getTable<uint8_t>() const
+    {
+        return layout_ == TableLayout::DENSE && width_ == TableWidth::BITS_8 ? table8_.cells.data() : nullptr;
+    }
+
+    template <>
+    inline const uint16_t *CompiledFSM::getTable<uint16_t>() const
+    {
+        return layout_ == TableLayout::DENSE && width_ == TableWidth::BITS_16 ? table16_.cells.data() : nullptr;
+    }
+
+    template <>
+    inline const CompiledFSM::StateIndex *CompiledFSM::getTable<CompiledFSM::StateIndex>() const
+    {
+        return layout_ == TableLayout::DENSE && width_ == TableWidth::BITS_32 ? table32_.cells.data() : nullptr;
+    }
+
+} // namespace fsm
+
+#endif // FSM_COMPILED_HPP
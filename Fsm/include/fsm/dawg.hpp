@@ -0,0 +1,189 @@
+#ifndef FSM_DAWG_HPP
+#define FSM_DAWG_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace fsm
+{
+    // ============================================================================
+    // Dawg - Minimal Acyclic Automaton for Word Lists
+    // ============================================================================
+    //
+    // Allowlists of hundreds of thousands of words are too big for
+    // FSM::Builder: one named state per prefix builds a trie that repeats
+    // every shared suffix. Dawg::Builder takes the words in sorted order and
+    // minimizes as it goes (Daciuk et al., "Incremental Construction of
+    // Minimal Acyclic Finite-State Automata"), so only the minimal automaton
+    // is ever held in full.
+    //
+    // The compiled form is one array of 32-bit cells. A state is a count
+    // cell followed by its edges, sorted by label:
+    //
+    //   edge = label << 24 | target-accepts << 23 | target cell index
+    //
+    // That is four bytes per edge plus four per state, addressed by index,
+    // so the same bytes work in memory, on disk and through mmap():
+    //
+    //   std::ofstream("words.dawg", std::ios::binary) << dawg;  // or save()
+    //   const void *p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    //   Dawg words = Dawg::view(p, size);                       // no copy
+
+    class Dawg
+    {
+    public:
+        using Cell = uint32_t;
+
+        static constexpr size_t MAX_CELLS = size_t{1} << 23;
+        static constexpr uint32_t FORMAT_VERSION = 1;
+
+        class Builder
+        {
+        public:
+            Builder();
+
+            // Words must arrive in strictly increasing byte order; anything
+            // else throws std::invalid_argument.
+            Builder &add(std::string_view word);
+            [[nodiscard]] Dawg build();
+
+        private:
+            struct Node
+            {
+                bool accepting = false;
+                std::vector<std::pair<uint8_t, uint32_t>> edges; // sorted by label
+            };
+
+            struct Pending
+            {
+                uint32_t parent;
+                uint32_t child;
+            };
+
+            std::vector<Node> nodes_;
+            std::vector<uint32_t> free_nodes_;
+            std::vector<Pending> unchecked_; // path of the previous word not yet minimized
+            std::unordered_map<std::string, uint32_t> register_;
+            std::string previous_;
+            size_t word_count_ = 0;
+            bool started_ = false;
+
+            uint32_t newNode();
+            void minimize(size_t depth);
+        };
+
+        Dawg() = default;
+        Dawg(const Dawg &other);
+        Dawg(Dawg &&other) noexcept;
+        Dawg &operator=(Dawg other) noexcept;
+
+        // Zero-copy view of serialized bytes (from save() or a file mapped
+        // with mmap()). The memory must be 4-byte aligned and outlive the
+        // Dawg. Throws std::invalid_argument if it is not a valid DAWG.
+        [[nodiscard]] static Dawg view(const void *data, size_t size);
+
+        // Copies serialized bytes; validated the same way as view().
+        [[nodiscard]] static Dawg load(std::istream &in);
+        void save(std::ostream &out) const;
+
+        [[nodiscard]] bool validate(std::string_view input) const noexcept;
+        [[nodiscard]] bool contains(std::string_view input) const noexcept { return validate(input); }
+
+        [[nodiscard]] size_t getWordCount() const { return word_count_; }
+        [[nodiscard]] size_t getStateCount() const { return state_count_; }
+        [[nodiscard]] size_t getEdgeCount() const { return cell_count_ - state_count_; }
+        [[nodiscard]] size_t getBytes() const; // serialized size
+        [[nodiscard]] bool isView() const { return owned_.empty() && cell_count_ != 0; }
+
+        // Every word in byte order
+        [[nodiscard]] std::vector<std::string> getWords() const;
+        [[nodiscard]] std::string toString() const;
+
+    private:
+        struct Header
+        {
+            char magic[8];
+            uint32_t version;
+            uint32_t byte_order; // BYTE_ORDER_MARK as written
+            uint32_t cell_count;
+            uint32_t state_count;
+            uint32_t word_count;
+            uint32_t root_accepts;
+        };
+
+        static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+        static constexpr Cell LABEL_SHIFT = 24;
+        static constexpr Cell ACCEPTS_BIT = Cell{1} << 23;
+        static constexpr Cell TARGET_MASK = ACCEPTS_BIT - 1;
+
+        std::vector<Cell> owned_;
+        const Cell *cells_ = nullptr;
+        size_t cell_count_ = 0;
+        size_t state_count_ = 0;
+        size_t word_count_ = 0;
+        bool root_accepts_ = false;
+
+        void attach(const Header &header, const Cell *cells);
+        void collectWords(Cell state, std::string &prefix, std::vector<std::string> &out) const;
+    };
+
+    std::ostream &operator<<(std::ostream &out, const Dawg &dawg);
+
+    inline bool Dawg::validate(std::string_view input) const noexcept
+    {
+        if (cell_count_ == 0)
+        {
+            return false;
+        }
+
+        Cell state = 0;
+        bool accepts = root_accepts_;
+        for (char ch : input)
+        {
+            const Cell *edges = cells_ + state + 1;
+            const Cell *end = edges + cells_[state];
+            const Cell label = static_cast<unsigned char>(ch);
+
+            // Labels are the top byte, so sorted labels mean sorted cells.
+            const Cell *edge = edges;
+            if (end - edges <= 8)
+            {
+                while (edge != end && (*edge >> LABEL_SHIFT) < label)
+                {
+                    ++edge;
+                }
+            }
+            else
+            {
+                while (end - edge > 1)
+                {
+                    const Cell *mid = edge + (end - edge) / 2;
+                    if ((*mid >> LABEL_SHIFT) <= label)
+                    {
+                        edge = mid;
+                    }
+                    else
+                    {
+                        end = mid;
+                    }
+                }
+            }
+
+            if (edge == end || (*edge >> LABEL_SHIFT) != label)
+            {
+                return false;
+            }
+            accepts = (*edge & ACCEPTS_BIT) != 0;
+            state = *edge & TARGET_MASK;
+        }
+        return accepts;
+    }
+
+} // namespace fsm
+
+#endif // FSM_DAWG_HPP
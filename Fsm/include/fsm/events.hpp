@@ -0,0 +1,137 @@
+#ifndef FSM_EVENTS_HPP
+#define FSM_EVENTS_HPP
+
+#include <fsm/compiled.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+namespace fsm
+{
+    // ============================================================================
+    // Event
+    // ============================================================================
+
+    enum class EventMode : uint8_t
+    {
+        ACTIONS,    // one event per transition tagged with an ActionID
+        TRANSITIONS // one event per transition taken
+    };
+
+    struct Event
+    {
+        uint64_t position;
+        uint32_t id;    // ActionID or TransitionID, depending on EventMode
+        uint32_t state; // CompiledFSM index of the state entered
+    };
+
+    // ============================================================================
+    // EventRing - Single-Producer/Single-Consumer Ring Buffer
+    // ============================================================================
+    //
+    // Storage is owned by the caller. The scanner thread publishes events in
+    // batches; a consumer thread may drain concurrently without locks.
+
+    class EventRing
+    {
+    public:
+        EventRing(Event *storage, size_t capacity);
+
+        EventRing(const EventRing &) = delete;
+        EventRing &operator=(const EventRing &) = delete;
+
+        // Consumer side
+        bool pop(Event &event) noexcept;
+
+        template <typename Consumer>
+        size_t drain(Consumer &&consumer);
+
+        // Producer side
+        bool push(const Event &event) noexcept;
+
+        [[nodiscard]] size_t capacity() const noexcept { return mask_ + 1; }
+        [[nodiscard]] size_t size() const noexcept;
+        [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+        [[nodiscard]] bool full() const noexcept { return size() == capacity(); }
+
+    private:
+        friend class EventScanner;
+
+        Event *storage_;
+        size_t mask_;
+
+        alignas(64) std::atomic<size_t> head_{0}; // next slot to read
+        alignas(64) std::atomic<size_t> tail_{0}; // next slot to write
+    };
+
+    template <typename Consumer>
+    size_t EventRing::drain(Consumer &&consumer)
+    {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        const size_t tail = tail_.load(std::memory_order_acquire);
+
+        for (size_t i = head; i != tail; ++i)
+        {
+            consumer(storage_[i & mask_]);
+        }
+
+        head_.store(tail, std::memory_order_release);
+        return tail - head;
+    }
+
+    // ============================================================================
+    // EventScanner
+    // ============================================================================
+    //
+    // Runs a CompiledFSM and appends events to an EventRing instead of calling
+    // back into user code. scan() stops before the byte whose event would not
+    // fit, so the caller drains the ring and resumes with the unconsumed rest.
+
+    enum class ScanStatus
+    {
+        CHUNK_CONSUMED,
+        BUFFER_FULL,
+        ACCEPTED,
+        REJECTED
+    };
+
+    struct ScanResult
+    {
+        ScanStatus status;
+        size_t consumed;
+    };
+
+    class EventScanner
+    {
+    public:
+        using StateIndex = CompiledFSM::StateIndex;
+
+        explicit EventScanner(const FSM &fsm, EventMode mode = EventMode::ACTIONS);
+        explicit EventScanner(std::shared_ptr<const CompiledFSM> compiled,
+                              EventMode mode = EventMode::ACTIONS);
+
+        ScanResult scan(std::string_view chunk, EventRing &ring);
+        ScanResult finish(EventRing &ring);
+        void reset();
+
+        [[nodiscard]] size_t getPosition() const { return position_; }
+        [[nodiscard]] StateIndex getCurrentIndex() const { return state_; }
+        [[nodiscard]] EventMode getMode() const { return mode_; }
+        [[nodiscard]] const CompiledFSM &getCompiled() const { return *compiled_; }
+
+    private:
+        std::shared_ptr<const CompiledFSM> compiled_;
+        EventMode mode_;
+        StateIndex state_ = CompiledFSM::DEAD_STATE;
+        size_t position_ = 0;
+        bool rejected_ = false;
+
+        template <EventMode MODE, typename View>
+        ScanResult scanImpl(const View &table, std::string_view chunk, EventRing &ring);
+    };
+
+} // namespace fsm
+
+#endif // FSM_EVENTS_HPP
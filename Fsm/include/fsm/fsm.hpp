@@ -2,13 +2,19 @@
 #define FSM_HPP
 
 #include <abnf/abnf.hpp>
+#include <array>
+#include <bitset>
 #include <cstdint>
 #include <functional>
 #include <iostream>
+#include <limits>
 #include <memory>
+#include <memory_resource>
 #include <optional>
+#include <stdexcept>
 #include <string>
 #include <string_view>
+#include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -25,6 +31,15 @@ namespace fsm
     struct TransitionContext;
     struct StateContext;
     class FSM;
+    class MetricsRegistry;
+    class MetricsShard;
+    struct Profile;
+    class RingTracer;
+    class CountingResource;
+    struct ProductionPolicy;
+    template <typename Policy>
+    class Matcher;
+    class KeywordSet;
 
     // ============================================================================
     // Debug Flags (Bit Manipulation)
@@ -213,6 +228,15 @@ namespace fsm
             : name(n), start_position(pos) {}
     };
 
+    // Run-time form of a capture: an interned name and a span of the input.
+    // The value is only copied out when a CaptureGroup is requested.
+    struct CaptureSpan
+    {
+        uint32_t name;
+        size_t start_position;
+        size_t end_position;
+    };
+
     // ============================================================================
     // Streaming State
     // ============================================================================
@@ -223,7 +247,8 @@ namespace fsm
         PROCESSING,
         WAITING_FOR_INPUT,
         COMPLETE,
-        ERROR
+        ERROR,
+        ACCEPTED // in an accept sink: any further input is accepted, stop feeding
     };
 
     // ============================================================================
@@ -250,21 +275,23 @@ namespace fsm
 
     struct ChoicePoint
     {
-        StateID state;
+        uint32_t state; // StateID::id
         size_t position;
-        std::vector<const class Transition *> remaining;
+        std::pmr::vector<const class Transition *> remaining;
 
-        std::vector<CaptureGroup> captures_snapshot;
-        std::vector<ActiveCapture> active_captures_snapshot;
+        std::pmr::vector<CaptureSpan> captures_snapshot;
+        std::pmr::vector<CaptureSpan> active_captures_snapshot;
         size_t input_position_snapshot;
 
-        ChoicePoint(StateID s, size_t pos,
-                    const std::vector<const class Transition *> &trans,
-                    const std::vector<CaptureGroup> &caps,
-                    const std::vector<ActiveCapture> &active,
-                    size_t input_pos)
-            : state(s), position(pos), remaining(trans),
-              captures_snapshot(caps), active_captures_snapshot(active),
+        // Snapshots are allocated from `resource`, like the rest of the run state.
+        ChoicePoint(uint32_t s, size_t pos,
+                    std::pmr::vector<const class Transition *> trans,
+                    const std::pmr::vector<CaptureSpan> &caps,
+                    const std::pmr::vector<CaptureSpan> &active,
+                    size_t input_pos,
+                    std::pmr::memory_resource *resource)
+            : state(s), position(pos), remaining(std::move(trans)),
+              captures_snapshot(caps, resource), active_captures_snapshot(active, resource),
               input_position_snapshot(input_pos) {}
     };
 
@@ -305,7 +332,7 @@ namespace fsm
     // Transition
     // ============================================================================
 
-    enum class TransitionType
+    enum class TransitionType : uint8_t
     {
         ABNF_RULE,
         FSM_INSTANCE,
@@ -316,6 +343,9 @@ namespace fsm
     {
     public:
         using TransitionID = uint32_t;
+        using ActionID = uint16_t;
+
+        static constexpr ActionID NO_ACTION = 0;
 
         static constexpr int PRIORITY_LOWEST = 0;
         static constexpr int PRIORITY_LOW = 25;
@@ -328,6 +358,7 @@ namespace fsm
         StateID to;
         TransitionType type;
         TransitionCallback on_transition;
+        ActionID action = NO_ACTION;
 
         std::optional<ABNF> rule;
         std::shared_ptr<FSM> embedded_fsm;
@@ -365,7 +396,8 @@ namespace fsm
             INVALID_TRANSITION,
             AMBIGUOUS_TRANSITION,
             NO_START_STATE,
-            UNREACHABLE_STATES
+            UNREACHABLE_STATES,
+            LENGTH_OUT_OF_RANGE
         };
 
         struct ValidationError
@@ -381,6 +413,28 @@ namespace fsm
             [[nodiscard]] std::string toString() const;
         };
 
+        // Where a failure was detected; selects the wording of the rendered message.
+        enum class ErrorSite : uint8_t
+        {
+            VALIDATE,
+            STREAM,
+            BACKTRACK,
+            PUSHDOWN
+        };
+
+        // Allocation-free record of the last failure. getLastError() renders it
+        // into a ValidationError only when asked.
+        struct ErrorRecord
+        {
+            ErrorType type = ErrorType::NO_MATCHING_TRANSITION;
+            ErrorSite site = ErrorSite::VALIDATE;
+            char character = '\0';
+            uint32_t state = 0;           // StateID::id in `machine`
+            uint32_t detail = 0;          // call depth or depth limit (PUSHDOWN)
+            size_t position = 0;
+            const FSM *machine = nullptr; // sub-machine for PUSHDOWN, else this
+        };
+
         struct TraceEntry
         {
             size_t step;
@@ -401,6 +455,7 @@ namespace fsm
             size_t epsilon_transitions = 0;
             uint64_t validation_time_ns = 0;
             std::chrono::microseconds processing_time{0};
+            size_t allocations = 0; // per validate(), needs a CountingResource
 
             void reset();
             [[nodiscard]] std::string toString() const;
@@ -451,11 +506,51 @@ namespace fsm
             StateID from, StateID to, std::shared_ptr<FSM> embedded_fsm,
             int priority = Transition::PRIORITY_NORMAL);
 
+        // Sub-machine calls are kept shared instead of being inlined; they are
+        // only executed by validatePushdown(). A recursive transition calls the
+        // machine that is currently executing it.
+        Transition::TransitionID addSubMachineTransition(StateID from, StateID to,
+                                                         std::shared_ptr<FSM> sub_machine,
+                                                         int priority = Transition::PRIORITY_NORMAL);
+        Transition::TransitionID addRecursiveTransition(StateID from, StateID to,
+                                                        int priority = Transition::PRIORITY_NORMAL);
+
         // Input Processing
         bool validate(std::string_view input);
         [[nodiscard]] bool isInAcceptState() const;
         void reset();
 
+        // Execution Engines
+        //
+        // validate() runs one of these. AUTO takes the fastest engine that
+        // gives the same answer as the machine's definition:
+        //   PUSHDOWN      sub-machine calls are present
+        //   BACKTRACKING  two edges of equal priority overlap (see getAmbiguities())
+        //   INTERPRETER   state or transition callbacks are set
+        //   KEYWORDS      as TABLE, but at most KEYWORD_ENGINE_LIMIT strings are
+        //                 accepted; one perfect-hash probe (see KeywordSet)
+        //   TABLE         otherwise; a compiled table walked by a FastMatcher
+        // TABLE and KEYWORDS fall back to the interpreter while tracing,
+        // metrics, a registry or a tracer are attached. Forcing TABLE on a
+        // machine that is not deterministic fails with AMBIGUOUS_TRANSITION;
+        // forcing KEYWORDS on one whose language is too large runs the table.
+        enum class Engine : uint8_t
+        {
+            AUTO,
+            TABLE,
+            INTERPRETER,
+            BACKTRACKING,
+            PUSHDOWN,
+            KEYWORDS
+        };
+
+        static constexpr size_t KEYWORD_ENGINE_LIMIT = 1024;
+
+        void setEngine(Engine engine);
+        [[nodiscard]] Engine getEngine() const;
+        [[nodiscard]] Engine getSelectedEngine() const; // what AUTO resolves to
+        static const char *engineToString(Engine engine) noexcept;
+
         // Streaming Input (Phase 2. 4)
         StreamState feed(char ch);
         StreamState feed(std::string_view chunk);
@@ -475,9 +570,24 @@ namespace fsm
         void setMaxBacktrackDepth(size_t depth);
         [[nodiscard]] size_t getMaxBacktrackDepth() const;
 
+        // Pushdown Execution (Sub-machine Calls)
+        bool validatePushdown(std::string_view input);
+        void setMaxCallDepth(size_t depth);
+        [[nodiscard]] size_t getMaxCallDepth() const;
+        [[nodiscard]] size_t getCallDepth() const;
+
+        static constexpr size_t DEFAULT_MAX_CALL_DEPTH = 256;
+
         // Error Reporting
         [[nodiscard]] std::optional<ValidationError> getLastError() const;
 
+        // Allocation-free error codes for hot reject paths
+        [[nodiscard]] bool hasError() const noexcept { return has_error_; }
+        [[nodiscard]] ErrorType getErrorType() const noexcept { return error_.type; }
+        [[nodiscard]] size_t getErrorPosition() const noexcept { return error_.position; }
+        [[nodiscard]] const ErrorRecord &getErrorRecord() const noexcept { return error_; }
+        static const char *errorTypeToString(ErrorType type) noexcept;
+
         // Debug Support
         void setDebugConfig(const DebugConfig &config);
         [[nodiscard]] DebugConfig &getDebugConfig();
@@ -488,16 +598,110 @@ namespace fsm
         [[nodiscard]] std::string toDot() const;
         void exportDot(const std::string &filename) const;
 
-        [[nodiscard]] const std::vector<TraceEntry> &getTrace() const;
+        [[nodiscard]] std::vector<TraceEntry> getTrace() const;
+        // The trace in place, without copying it off memory_resource_
+        [[nodiscard]] const std::pmr::vector<TraceEntry> &getTraceView() const;
         void clearTrace();
 
+        // Bounded binary tracing (see fsm/tracing.hpp); independent of TRACE_TRANSITIONS
+        void setTracer(std::shared_ptr<RingTracer> tracer);
+        [[nodiscard]] const std::shared_ptr<RingTracer> &getTracer() const;
+
         [[nodiscard]] const Metrics &getMetrics() const;
         void resetMetrics();
 
+        // Shared per-thread counters (see fsm/instrumentation.hpp)
+        void setMetricsRegistry(std::shared_ptr<MetricsRegistry> registry);
+        [[nodiscard]] const std::shared_ptr<MetricsRegistry> &getMetricsRegistry() const;
+
+        // Runtime Memory
+        // All per-match state (input copy, captures, choice points, trace,
+        // scratch) allocates from this resource; the default is the global
+        // default resource. Switching resources discards that state, so an
+        // arena can be released as soon as the FSM has been moved off it (see
+        // ScopedMemoryResource). A CountingResource also reports allocations
+        // per validate() in Metrics when COLLECT_METRICS is set.
+        void setMemoryResource(std::pmr::memory_resource *resource);
+        [[nodiscard]] std::pmr::memory_resource *getMemoryResource() const;
+
+        // Profile-Guided Ordering
+        // Hot transitions are tried first wherever that cannot change which
+        // transition matches; compiled tables place hot states together.
+        void applyProfile(const Profile &profile);
+        void clearProfile();
+        [[nodiscard]] bool hasProfile() const;
+        [[nodiscard]] uint64_t getProfiledVisits(StateID state) const;
+        [[nodiscard]] uint64_t getProfiledHits(Transition::TransitionID transition_id) const;
+
         // Validation
         [[nodiscard]] bool isValid() const;
         [[nodiscard]] std::vector<std::string> validateStructure() const;
 
+        // Static Analysis
+        //
+        // A state is unreachable when no transition path leads to it from the
+        // start state, and dead when no path leads from it to an accept state.
+        // validate(), feed() and the compiled matchers reject the moment an
+        // edge into a dead state would be taken instead of scanning the rest
+        // of the input.
+        [[nodiscard]] std::vector<StateID> getUnreachableStates() const;
+        [[nodiscard]] std::vector<StateID> getDeadStates() const;
+        [[nodiscard]] bool isDeadState(StateID state) const;
+        size_t pruneUnreachableStates();
+
+        // An accept sink is an accept state that every byte keeps inside the
+        // set of accept sinks (e.g. a final `*OCTET`), with no epsilon edges
+        // or callbacks. Once one is entered the verdict is fixed: validate()
+        // returns true without reading the rest of the input and feed()
+        // reports StreamState::ACCEPTED and ignores further chunks.
+        [[nodiscard]] std::vector<StateID> getAcceptSinkStates() const;
+        [[nodiscard]] bool isAcceptSink(StateID state) const;
+
+        // Two ABNF edges of one state overlap when a byte matches both and
+        // they lead to different places; two epsilon edges of one state always
+        // do. The edge earlier in priority order wins. When the priorities
+        // differ that is taken as intended, and logged with VERBOSE_ERRORS;
+        // when they are equal the machine is not deterministic. Epsilon
+        // overlaps are listed but never make it so: every engine follows the
+        // first epsilon edge.
+        struct Ambiguity
+        {
+            StateID state;
+            Transition::TransitionID first;  // taken by first-match engines
+            Transition::TransitionID second;
+            TransitionType type;             // ABNF_RULE or EPSILON
+            uint16_t shared_bytes = 0;       // bytes both edges match
+            bool resolved_by_priority = false;
+            bool shadowed = false;           // second matches no byte that earlier edges leave
+
+            [[nodiscard]] std::string toString() const;
+        };
+
+        [[nodiscard]] std::vector<Ambiguity> getAmbiguities() const;
+        [[nodiscard]] bool isDeterministic() const;
+
+        // Lengths of accepted inputs, read off the transition graph with
+        // priorities ignored, so the range can be wider than the language's
+        // but never narrower. validate() and feed() reject lengths outside it
+        // with LENGTH_OUT_OF_RANGE before scanning, so no callbacks run; only
+        // when callbacks put validate() on the interpreter is the input read
+        // anyway. Sub-machine calls make it unbounded.
+        struct LengthBounds
+        {
+            static constexpr size_t UNBOUNDED = std::numeric_limits<size_t>::max();
+
+            size_t min = 0;
+            size_t max = UNBOUNDED;
+            bool finite = false;      // no accepting path loops
+            bool empty = false;       // nothing is accepted; min and max are 0
+            size_t count = UNBOUNDED; // accepted strings, at most; UNBOUNDED if infinite
+
+            [[nodiscard]] bool admits(size_t length) const { return empty || (length >= min && length <= max); }
+            [[nodiscard]] std::string toString() const;
+        };
+
+        [[nodiscard]] LengthBounds getLengthBounds() const;
+
         // Introspection
         [[nodiscard]] size_t getStateCount() const;
         [[nodiscard]] size_t getTransitionCount() const;
@@ -513,6 +717,7 @@ namespace fsm
         void setStateExitCallback(StateID state, StateExitCallback callback);
         void setTransitionCallback(Transition::TransitionID transition_id,
                                    TransitionCallback callback);
+        void setTransitionAction(Transition::TransitionID transition_id, Transition::ActionID action);
         void setUserData(void *data);
         void *getUserData() const;
 
@@ -538,42 +743,172 @@ namespace fsm
         std::vector<Transition> transitions_;
         std::unordered_map<StateID, std::vector<Transition *>, StateID::Hash> transition_map_;
 
+        // Hot/cold split: the interpreter scans packed edges, one 8-byte
+        // record per transition, and only touches the full Transition once an
+        // edge is taken. Edges are grouped by source state in the order
+        // transitionsFrom() returns them; ABNF rules share a deduplicated
+        // 256-bit character set table.
+        struct RuntimeEdge
+        {
+            uint32_t transition; // index into transitions_
+            uint16_t charset;    // index into charsets_ (ABNF rules)
+            TransitionType type;
+            uint8_t flags;
+
+            static constexpr uint8_t HAS_CALLBACK = 0b00000001;
+            static constexpr uint8_t TARGET_DEAD = 0b00000010;
+            static constexpr uint8_t TARGET_SINK = 0b00000100;
+        };
+
+        using CharSet = std::array<uint64_t, 4>;
+
+        struct EdgeSpan
+        {
+            const RuntimeEdge *first;
+            const RuntimeEdge *last;
+
+            [[nodiscard]] const RuntimeEdge *begin() const { return first; }
+            [[nodiscard]] const RuntimeEdge *end() const { return last; }
+        };
+
+        std::vector<RuntimeEdge> runtime_edges_;
+        std::vector<uint32_t> edge_offsets_; // by StateID::id; edges of s are [s, s + 1)
+        std::vector<CharSet> charsets_;
+        std::vector<uint8_t> live_states_;  // by StateID::id: an accept state is reachable
+        std::vector<uint8_t> accept_sinks_; // by StateID::id
+        bool accept_sink_reached_ = false;  // set by processCharImpl()
+
+        void findAcceptSinks();
+        LengthBounds analyzeLengths() const;
+        LengthBounds length_bounds_;
+        bool rejectLength(std::string_view input);
+
+        std::vector<Ambiguity> findAmbiguities() const;
+        void selectEngine();
+
+        Engine engine_ = Engine::AUTO;
+        Engine selected_engine_ = Engine::TABLE;
+        std::vector<Ambiguity> unresolved_;                       // equal-priority overlaps
+        std::shared_ptr<Matcher<ProductionPolicy>> table_matcher_; // built on first TABLE run
+        std::shared_ptr<KeywordSet> keywords_;                     // built on first KEYWORDS run
+
+        Engine engineForRun();
+        bool validateTable(std::string_view input);
+        bool validateKeywords(std::string_view input);
+
+        // Both by StateID::id
+        struct Reachability
+        {
+            std::vector<uint8_t> reachable; // from the start state
+            std::vector<uint8_t> live;      // can reach an accept state
+        };
+
+        Reachability analyzeReachability() const;
+
         StateID start_state_;
         std::unordered_set<StateID, StateID::Hash> accept_states_;
         StateID current_state_;
 
         DebugConfig debug_config_;
-        std::vector<TraceEntry> trace_;
-        std::optional<ValidationError> last_error_;
+        mutable bool trace_stale_ = false; // reset() defers clearing to the next read or append
+        bool has_error_ = false;
+        ErrorRecord error_;
         Metrics metrics_;
+        std::shared_ptr<MetricsRegistry> metrics_registry_;
+        MetricsShard *metrics_shard_ = nullptr; // calling thread's shard, refreshed by reset()
+        std::shared_ptr<RingTracer> tracer_;
+        bool trace_sampled_ = false; // current validation is sampled, refreshed by reset()
+        uint32_t trace_validation_ = 0;
+        std::vector<uint64_t> profile_state_visits_;
+        std::vector<uint64_t> profile_transition_hits_;
 
         uint32_t next_state_id_;
         uint32_t next_transition_id_;
 
         void *user_data_ = nullptr;
 
-        std::vector<CaptureGroup> captures_;
-        std::vector<ActiveCapture> active_captures_;
+        // Names are interned once per FSM. Each name's slot points at its
+        // first capture of the current generation; clearCaptures() just
+        // starts a new generation.
+        struct CaptureSlot
+        {
+            uint32_t generation;
+            uint32_t index;
+        };
+
+        uint32_t capture_generation_ = 1;
+        mutable std::vector<CaptureGroup> capture_groups_; // rendered by getAllCaptures()
+        mutable bool capture_groups_stale_ = false;
         size_t current_input_position_ = 0;
-        std::string current_input_;
+        std::pmr::memory_resource *memory_resource_ = std::pmr::get_default_resource();
+        CountingResource *allocation_counter_ = nullptr;
 
         // Streaming
         StreamState stream_state_ = StreamState::READY;
         bool streaming_mode_ = false;
 
         // Backtracking
-        std::stack<ChoicePoint> choice_stack_;
+        size_t choice_depth_ = 0;
         BacktrackingStats backtracking_stats_;
         size_t max_backtrack_depth_ = 0;
 
+        // Pushdown
+        struct CallFrame
+        {
+            const FSM *machine;
+            StateID return_state;
+        };
+
+        struct CallFirstSet
+        {
+            std::bitset<256> bytes;
+            bool accepts_empty = false; // the callee can return without consuming input
+        };
+
+        using FirstSets = std::unordered_map<const FSM *, CallFirstSet>;
+
+        size_t max_call_depth_ = DEFAULT_MAX_CALL_DEPTH;
+        FirstSets call_first_sets_;
+
+        // Per-match buffers, all on memory_resource_. A pmr container keeps
+        // the resource it was built with (even across assignment), so
+        // setMemoryResource() replaces the whole set.
+        struct RunBuffers
+        {
+            explicit RunBuffers(std::pmr::memory_resource *resource);
+
+            std::pmr::string current_input;
+            std::pmr::vector<uint32_t> epsilon_visited; // scratch for processEpsilonTransitions()
+            mutable std::pmr::vector<TraceEntry> trace;
+            std::pmr::vector<std::pmr::string> capture_names;
+            std::pmr::vector<CaptureSlot> capture_slots;
+            std::pmr::vector<CaptureSpan> captures;
+            std::pmr::vector<CaptureSpan> active_captures;
+            std::pmr::vector<ChoicePoint> choice_stack; // slots above choice_depth_ are kept for reuse
+            std::pmr::vector<const Transition *> valid_transitions; // scratch for getValidTransitions()
+            std::pmr::vector<CallFrame> call_stack;
+            std::pmr::vector<StateID> pushdown_chain; // scratch for pushdownEpsilonChain()
+        };
+
+        std::optional<RunBuffers> run_{std::in_place, std::pmr::get_default_resource()};
+
         // SIMD
         bool simd_enabled_ = true;
 
         void processEpsilonTransitions(size_t position);
-        void recordCharInCaptures(char ch);
         void updateCapturePosition(size_t pos);
+        uint32_t internCaptureName(const std::string &name);
+        const CaptureSpan *findCapture(const std::string &name) const;
+        void stampCaptureSlots();
+        CaptureGroup renderCapture(const CaptureSpan &span) const;
+        TraceEntry &appendTrace(const StateID &from, const StateID &to, char ch,
+                                Transition::TransitionID transition_id, const std::string &description);
 
         bool processCharImpl(char ch, size_t position);
+        bool validateInput(std::string_view input);
+        void fail(ErrorType type, ErrorSite site, size_t position, char ch, uint32_t state,
+                  const FSM *machine = nullptr, uint32_t detail = 0) noexcept;
+        void recordOutcome(size_t bytes, bool accepted);
         void sortTransitionsByPriority();
         void logTransition(const TraceEntry &entry);
         void logStateChange(StateID from, StateID to);
@@ -585,16 +920,35 @@ namespace fsm
             std::vector<Transition::TransitionID> new_transitions;
         };
 
-        MergeResult mergeStatesAndTransitions(StateID from_state, StateID to_state, const FSM &embedded);
+        MergeResult mergeStatesAndTransitions(StateID from_state, StateID to_state,
+                                              const std::shared_ptr<FSM> &embedded);
         void rebuildTransitionMap();
+        void buildRuntimeEdges();
+        const std::vector<Transition *> &transitionsFrom(const StateID &state) const;
+        EdgeSpan edgesFrom(uint32_t state) const;
+        EdgeSpan edgeRange(uint32_t state) const; // edgesFrom() without the rebuild check
+
+        bool edgeMatches(const RuntimeEdge &edge, char ch) const
+        {
+            const auto byte = static_cast<unsigned char>(ch);
+            return (charsets_[edge.charset][byte >> 6] >> (byte & 63)) & 1;
+        }
+        void orderByProfile(std::vector<Transition *> &transitions, const FirstSets &first_sets) const;
         bool transition_map_dirty_ = true;
 
         // Backtracking helpers
-        std::vector<const Transition *> getValidTransitions(char ch);
-        bool shouldCreateChoicePoint(const std::vector<const Transition *> &valid_transitions) const;
-        void saveChoicePoint(const std::vector<const Transition *> &alternatives, size_t position);
+        const std::pmr::vector<const Transition *> &getValidTransitions(char ch);
+        bool shouldCreateChoicePoint(const std::pmr::vector<const Transition *> &valid_transitions) const;
+        void saveChoicePoint(const std::pmr::vector<const Transition *> &valid_transitions, size_t position);
+        ChoicePoint &topChoicePoint() { return run_->choice_stack[choice_depth_ - 1]; }
         bool backtrack();
         void restoreFromChoicePoint(const ChoicePoint &cp);
+
+        // Pushdown helpers
+        void collectCallFirstSets(const FSM *machine);
+        static FirstSets computeCallFirstSets(const FSM *root);
+        bool pushdownStep(const FSM *&machine, char ch, size_t position);
+        const std::pmr::vector<StateID> &pushdownEpsilonChain(const FSM *machine, StateID state);
     };
 
     // ============================================================================
@@ -628,6 +982,11 @@ namespace fsm
 
         Builder &addEpsilonTransition(const std::string &from, const std::string &to);
 
+        Builder &callSubMachine(const std::string &from, const std::string &to,
+                                std::shared_ptr<FSM> fsm, int priority = Transition::PRIORITY_NORMAL);
+        Builder &callSelf(const std::string &from, const std::string &to,
+                          int priority = Transition::PRIORITY_NORMAL);
+
         Builder &setDebugFlags(DebugFlags flags);
         Builder &enableDebugFlag(DebugFlags flag);
         Builder &disableDebugFlag(DebugFlags flag);
@@ -639,8 +998,23 @@ namespace fsm
         Builder &onStateEntry(const std::string &state_name, StateEntryCallback callback);
         Builder &onStateExit(const std::string &state_name, StateExitCallback callback);
         Builder &onTransition(TransitionCallback callback);
+        Builder &withAction(Transition::ActionID action);
         Builder &withUserData(void *data);
 
+        // 0 is Transition::NO_ACTION, so a zero enumerator would be dropped
+        // by the matchers; it throws std::invalid_argument instead. Start
+        // action enums at 1.
+        template <typename Enum, typename = std::enable_if_t<std::is_enum<Enum>::value>>
+        Builder &withAction(Enum action)
+        {
+            const auto id = static_cast<Transition::ActionID>(action);
+            if (id == Transition::NO_ACTION)
+            {
+                throw std::invalid_argument("Action enumerator 0 is reserved for Transition::NO_ACTION");
+            }
+            return withAction(id);
+        }
+
         Builder &markChoicePoint(const std::string &state_name);
 
         [[nodiscard]] std::shared_ptr<FSM> build();
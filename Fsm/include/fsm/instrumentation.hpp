@@ -0,0 +1,172 @@
+#ifndef FSM_INSTRUMENTATION_HPP
+#define FSM_INSTRUMENTATION_HPP
+
+#include <fsm/fsm.hpp>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace fsm
+{
+    // ============================================================================
+    // MetricsRegistry - Per-Thread Sharded Counters
+    // ============================================================================
+    //
+    // Each thread that records into a registry gets its own shard, so the hot
+    // path is a plain relaxed load/store on memory no other thread writes.
+    // snapshot() sums the shards on demand. States are indexed by StateID::id
+    // and transitions by TransitionID, so counts stay valid across engines.
+
+    constexpr size_t ERROR_TYPE_COUNT =
+        static_cast<size_t>(FSM::ErrorType::LENGTH_OUT_OF_RANGE) + 1;
+
+    class alignas(64) MetricsShard
+    {
+    public:
+        MetricsShard(size_t state_slots, size_t transition_slots);
+
+        MetricsShard(const MetricsShard &) = delete;
+        MetricsShard &operator=(const MetricsShard &) = delete;
+
+        void recordValidation(size_t bytes) noexcept
+        {
+            bump(validations_);
+            bump(bytes_, bytes);
+        }
+
+        void recordReject(FSM::ErrorType type) noexcept
+        {
+            bump(rejects_[static_cast<size_t>(type)]);
+        }
+
+        // Counts every step that lands in the state, self-loops included.
+        void recordStateVisit(uint32_t state_id) noexcept
+        {
+            if (state_id < state_slots_)
+            {
+                bump(state_visits_[state_id]);
+            }
+        }
+
+        void recordTransition(Transition::TransitionID transition_id) noexcept
+        {
+            if (transition_id < transition_slots_)
+            {
+                bump(transition_hits_[transition_id]);
+            }
+        }
+
+    private:
+        friend class MetricsRegistry;
+
+        // Only the owning thread writes, so no read-modify-write is needed.
+        static void bump(std::atomic<uint64_t> &counter, uint64_t n = 1) noexcept
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+
+        std::atomic<uint64_t> validations_{0};
+        std::atomic<uint64_t> bytes_{0};
+        std::array<std::atomic<uint64_t>, ERROR_TYPE_COUNT> rejects_{};
+
+        size_t state_slots_;
+        size_t transition_slots_;
+        std::unique_ptr<std::atomic<uint64_t>[]> state_visits_;
+        std::unique_ptr<std::atomic<uint64_t>[]> transition_hits_;
+    };
+
+    class MetricsRegistry
+    {
+    public:
+        using Shard = MetricsShard;
+
+        struct Snapshot
+        {
+            uint64_t validations = 0;
+            uint64_t bytes = 0;
+            std::array<uint64_t, ERROR_TYPE_COUNT> rejects{};
+            std::vector<uint64_t> state_visits;    // indexed by StateID::id
+            std::vector<uint64_t> transition_hits; // indexed by TransitionID
+            size_t shard_count = 0;
+
+            [[nodiscard]] uint64_t getRejects() const;
+            [[nodiscard]] uint64_t getRejects(FSM::ErrorType type) const;
+            [[nodiscard]] uint64_t getAccepted() const { return validations - getRejects(); }
+            [[nodiscard]] std::string toString() const;
+        };
+
+        MetricsRegistry(size_t state_slots, size_t transition_slots);
+        explicit MetricsRegistry(const FSM &fsm);
+
+        ~MetricsRegistry();
+
+        MetricsRegistry(const MetricsRegistry &) = delete;
+        MetricsRegistry &operator=(const MetricsRegistry &) = delete;
+
+        // Shard of the calling thread; registers one on first use.
+        Shard &local();
+
+        // Registries the calling thread has cached a shard for. Entries of
+        // destroyed registries are dropped on the thread's next registration.
+        [[nodiscard]] static size_t getThreadCacheSize();
+
+        [[nodiscard]] Snapshot snapshot() const;
+        void reset();
+
+        [[nodiscard]] size_t getStateSlots() const { return state_slots_; }
+        [[nodiscard]] size_t getTransitionSlots() const { return transition_slots_; }
+        [[nodiscard]] size_t getShardCount() const;
+
+    private:
+        const uint64_t serial_;
+        size_t state_slots_;
+        size_t transition_slots_;
+
+        mutable std::mutex shards_mutex_; // guards registration and snapshot only
+        std::vector<std::unique_ptr<Shard>> shards_;
+    };
+
+    // ============================================================================
+    // Profile - Recorded Hit Counts for Profile-Guided Layout
+    // ============================================================================
+    //
+    // A plain-text file of per-state and per-transition counts, keyed the same
+    // way as MetricsRegistry. FSM::applyProfile() uses it to try hot
+    // transitions first and CompiledFSM to place hot states next to each other.
+    //
+    //   fsm-profile 1
+    //   machine <name>
+    //   state <id> <visits>
+    //   transition <id> <hits>
+
+    struct Profile
+    {
+        std::string machine;
+        std::vector<uint64_t> state_visits;    // indexed by StateID::id
+        std::vector<uint64_t> transition_hits; // indexed by TransitionID
+
+        static Profile fromSnapshot(const std::string &machine, const MetricsRegistry::Snapshot &snapshot);
+
+        // Adds the counts of another profile of the same machine.
+        void merge(const Profile &other);
+
+        // Counts are stored densely by id, so ids above max_id are rejected
+        // rather than allocated for. Pass the machine's largest StateID /
+        // TransitionID to check a profile against it.
+        static constexpr uint64_t MAX_ID = (uint64_t{1} << 24) - 1;
+
+        void write(std::ostream &os) const;
+        static Profile read(std::istream &is, uint64_t max_id = MAX_ID);
+
+        void save(const std::string &filename) const;
+        static Profile load(const std::string &filename, uint64_t max_id = MAX_ID);
+    };
+
+} // namespace fsm
+
+#endif // FSM_INSTRUMENTATION_HPP
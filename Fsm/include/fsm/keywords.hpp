@@ -0,0 +1,191 @@
+#ifndef FSM_KEYWORDS_HPP
+#define FSM_KEYWORDS_HPP
+
+#include <fsm/fsm.hpp>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fsm
+{
+    // ============================================================================
+    // KeywordSet - Perfect Hashing for Finite Languages
+    // ============================================================================
+    //
+    // Method names, header names and enum-like fields are small finite sets.
+    // Instead of walking an automaton byte by byte, a KeywordSet hashes the
+    // input's length plus the few byte positions that tell the keywords
+    // apart (picked when the set is built), looks the result up in a
+    // collision-free hash-and-displace table and confirms with one memcmp.
+    // The answer is the keyword's ID.
+    //
+    // Build one from a list or from any FSM that accepts a finite language:
+    //
+    //   KeywordSet methods = KeywordSet::Builder().add("GET").add("POST").build();
+    //   methods.find("POST"); // 1
+    //
+    //   KeywordSet methods(*http_method_fsm); // IDs in byte order
+    //
+    // FSM::validate() switches to one of these by itself (Engine::KEYWORDS)
+    // when a machine accepts at most KEYWORD_ENGINE_LIMIT strings.
+
+    class KeywordSet
+    {
+    public:
+        using KeywordID = uint32_t;
+
+        static constexpr KeywordID NO_KEYWORD = UINT32_MAX;
+        static constexpr size_t MAX_LENGTH = 255;
+
+        class Builder
+        {
+        public:
+            // IDs follow the order of add() calls.
+            Builder &add(std::string keyword);
+            [[nodiscard]] KeywordSet build();
+
+        private:
+            std::vector<std::string> keywords_;
+        };
+
+        // Throws std::invalid_argument on duplicates or keywords longer than
+        // MAX_LENGTH.
+        explicit KeywordSet(std::vector<std::string> keywords);
+
+        // Every string `fsm` accepts, first-match priorities included, sorted
+        // by bytes. Callbacks are not run. Throws std::invalid_argument if the
+        // language is infinite, has sub-machine calls or more than `limit`
+        // strings.
+        explicit KeywordSet(const FSM &fsm, size_t limit = FSM::KEYWORD_ENGINE_LIMIT);
+
+        [[nodiscard]] KeywordID find(std::string_view input) const noexcept;
+        [[nodiscard]] bool contains(std::string_view input) const noexcept { return find(input) != NO_KEYWORD; }
+
+        [[nodiscard]] size_t size() const { return entries_.size(); }
+        [[nodiscard]] bool empty() const { return entries_.empty(); }
+        [[nodiscard]] std::string_view getKeyword(KeywordID id) const;
+        [[nodiscard]] std::vector<std::string> getKeywords() const;
+
+        // State the FSM ends in after accepting the keyword; sets built from
+        // an FSM only.
+        [[nodiscard]] const StateID &getFinalState(KeywordID id) const;
+
+        // Byte positions hashed besides the length; negative ones count from
+        // the end. Empty when the whole string is hashed.
+        [[nodiscard]] const std::vector<int16_t> &getKeyPositions() const { return positions_; }
+        [[nodiscard]] size_t getSlotCount() const { return slots_.size(); }
+        [[nodiscard]] std::string toString() const;
+
+    private:
+        struct Entry
+        {
+            uint32_t offset; // into pool_
+            uint32_t length;
+        };
+
+        std::string pool_;
+        std::vector<Entry> entries_;
+        std::vector<StateID> final_states_;
+
+        std::vector<int16_t> positions_;
+        bool whole_key_ = false; // positions could not separate the keywords
+
+        std::array<uint64_t, 4> lengths_{}; // bit per keyword length
+        std::vector<uint32_t> seeds_;       // displacement by bucket
+        std::vector<KeywordID> slots_;
+        unsigned bucket_shift_ = 63; // buckets and slots come from the high bits
+        unsigned slot_shift_ = 63;
+
+        void compile(std::vector<std::string> keywords);
+        void choosePositions(const std::vector<std::string> &keywords);
+        void buildTable();
+
+        [[nodiscard]] uint64_t key(std::string_view input) const noexcept;
+
+        // Multiply-shift: one multiply per level, indices from the top bits.
+        [[nodiscard]] static uint64_t scramble(uint64_t key) noexcept { return key * 0x9e3779b97f4a7c15ULL; }
+
+        [[nodiscard]] static uint64_t slotHash(uint64_t h, uint32_t seed) noexcept
+        {
+            return (h ^ (seed * 0xc2b2ae3d27d4eb4fULL)) * 0xbf58476d1ce4e5b9ULL;
+        }
+
+        [[nodiscard]] static bool sameBytes(const char *a, const char *b, size_t length) noexcept;
+    };
+
+    inline uint64_t KeywordSet::key(std::string_view input) const noexcept
+    {
+        uint64_t k = input.size();
+        if (whole_key_)
+        {
+            for (char ch : input)
+            {
+                k = (k ^ static_cast<unsigned char>(ch)) * 0x100000001b3ULL;
+            }
+            return k;
+        }
+
+        // Length and up to seven bytes pack without loss.
+        for (int16_t position : positions_)
+        {
+            const size_t index = position >= 0 ? static_cast<size_t>(position) : input.size() + position;
+            k = (k << 8) | (index < input.size() ? static_cast<unsigned char>(input[index]) : 0u);
+        }
+        return k;
+    }
+
+    inline KeywordSet::KeywordID KeywordSet::find(std::string_view input) const noexcept
+    {
+        const size_t length = input.size();
+        if (length > MAX_LENGTH || !((lengths_[length >> 6] >> (length & 63)) & 1))
+        {
+            return NO_KEYWORD;
+        }
+
+        const uint64_t h = scramble(key(input));
+        const KeywordID id = slots_[slotHash(h, seeds_[h >> bucket_shift_]) >> slot_shift_];
+        if (id == NO_KEYWORD)
+        {
+            return NO_KEYWORD;
+        }
+
+        const Entry &entry = entries_[id];
+        return entry.length == length && sameBytes(pool_.data() + entry.offset, input.data(), length) ? id
+                                                                                                    : NO_KEYWORD;
+    }
+
+    // Keywords are short: two overlapping loads of the widest word that fits
+    // cover the whole string without a call into memcmp.
+    inline bool KeywordSet::sameBytes(const char *a, const char *b, size_t length) noexcept
+    {
+        auto same = [a, b, length](auto word)
+        {
+            decltype(word) a_head, a_tail, b_head, b_tail;
+            std::memcpy(&a_head, a, sizeof(word));
+            std::memcpy(&b_head, b, sizeof(word));
+            std::memcpy(&a_tail, a + length - sizeof(word), sizeof(word));
+            std::memcpy(&b_tail, b + length - sizeof(word), sizeof(word));
+            return ((a_head ^ b_head) | (a_tail ^ b_tail)) == 0;
+        };
+
+        if (length >= 8)
+        {
+            return length <= 16 ? same(uint64_t{}) : std::memcmp(a, b, length) == 0;
+        }
+        if (length >= 4)
+        {
+            return same(uint32_t{});
+        }
+        if (length >= 2)
+        {
+            return same(uint16_t{});
+        }
+        return length == 0 || *a == *b;
+    }
+
+} // namespace fsm
+
+#endif // FSM_KEYWORDS_HPP
@@ -0,0 +1,784 @@
+#ifndef FSM_MATCHER_HPP
+#define FSM_MATCHER_HPP
+
+#include <fsm/compiled.hpp>
+#include <fsm/instrumentation.hpp>
+#include <fsm/tracing.hpp>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace fsm
+{
+    // ============================================================================
+    // Runtime Policies
+    // ============================================================================
+    //
+    // A policy decides at compile time which debug features a Matcher carries.
+    // Disabled features cost nothing: no flag checks, no state lookups and no
+    // callback tests are emitted in the byte loop.
+
+    struct ProductionPolicy
+    {
+        static constexpr bool trace_transitions = false;
+        static constexpr bool trace_state_changes = false;
+        static constexpr bool collect_metrics = false;
+        static constexpr bool dispatch_callbacks = false;
+        static constexpr bool record_registry = false;
+        static constexpr bool ring_trace = false;
+    };
+
+    // Production loop plus MetricsRegistry counts and sampled RingTracer records.
+    struct InstrumentedPolicy : ProductionPolicy
+    {
+        static constexpr bool record_registry = true;
+        static constexpr bool ring_trace = true;
+    };
+
+    // Keeps the full FSM behaviour; individual features are still switched by
+    // the runtime DebugConfig flags.
+    struct DebugPolicy
+    {
+        static constexpr bool trace_transitions = true;
+        static constexpr bool trace_state_changes = true;
+        static constexpr bool collect_metrics = true;
+        static constexpr bool dispatch_callbacks = true;
+        static constexpr bool record_registry = true;
+        static constexpr bool ring_trace = true;
+    };
+
+    // ============================================================================
+    // Typed Actions
+    // ============================================================================
+    //
+    // Transitions tagged with withAction() report their ActionID to a handler
+    // passed to validate()/feed(). The handler type is a template parameter, so
+    // a functor whose operator() switches on the ID is inlined into the loop.
+
+    struct ActionContext
+    {
+        Transition::ActionID action;
+        size_t position;
+        char input_char;
+        CompiledFSM::StateIndex from_state;
+        CompiledFSM::StateIndex to_state;
+
+        template <typename Enum>
+        [[nodiscard]] Enum as() const { return static_cast<Enum>(action); }
+    };
+
+    // Selects the plain table-lookup loop.
+    struct NoActions
+    {
+        void operator()(const ActionContext &) const {}
+    };
+
+    // ============================================================================
+    // Matcher
+    // ============================================================================
+
+    template <typename Policy>
+    class Matcher
+    {
+    public:
+        using StateIndex = CompiledFSM::StateIndex;
+
+        static constexpr bool HAS_HOOKS = Policy::trace_transitions || Policy::trace_state_changes ||
+                                          Policy::collect_metrics || Policy::dispatch_callbacks ||
+                                          Policy::record_registry || Policy::ring_trace;
+
+        explicit Matcher(const FSM &fsm);
+        explicit Matcher(std::shared_ptr<const CompiledFSM> compiled);
+
+        // Input Processing
+        bool validate(std::string_view input) { return validate(input, NoActions{}); }
+        template <typename Handler>
+        bool validate(std::string_view input, Handler &&handler);
+        [[nodiscard]] bool isInAcceptState() const;
+        void reset();
+
+        // Streaming Input
+        StreamState feed(char ch) { return feed(std::string_view(&ch, 1), NoActions{}); }
+        StreamState feed(std::string_view chunk) { return feed(chunk, NoActions{}); }
+        template <typename Handler>
+        StreamState feed(std::string_view chunk, Handler &&handler);
+        StreamState endOfStream() { return endOfStream(NoActions{}); }
+        template <typename Handler>
+        StreamState endOfStream(Handler &&handler);
+        [[nodiscard]] StreamState getStreamState() const { return stream_state_; }
+
+        // Introspection
+        [[nodiscard]] StateID getCurrentState() const;
+        [[nodiscard]] StateIndex getCurrentIndex() const { return state_; }
+        [[nodiscard]] const CompiledFSM &getCompiled() const { return *compiled_; }
+        [[nodiscard]] std::optional<FSM::ValidationError> getLastError() const;
+        [[nodiscard]] bool hasError() const noexcept { return has_error_; }
+        [[nodiscard]] FSM::ErrorType getErrorType() const noexcept { return error_type_; }
+        [[nodiscard]] size_t getErrorPosition() const noexcept { return error_position_; }
+
+        // Debug Support (inert unless enabled by the policy)
+        void setDebugConfig(const DebugConfig &config) { debug_config_ = config; }
+        [[nodiscard]] const DebugConfig &getDebugConfig() const { return debug_config_; }
+        void setUserData(void *data) { user_data_ = data; }
+        [[nodiscard]] const std::vector<FSM::TraceEntry> &getTrace() const { return trace_; }
+        [[nodiscard]] const FSM::Metrics &getMetrics() const { return metrics_; }
+        void setMetricsRegistry(std::shared_ptr<MetricsRegistry> registry);
+        [[nodiscard]] const std::shared_ptr<MetricsRegistry> &getMetricsRegistry() const { return registry_; }
+        void setTracer(std::shared_ptr<RingTracer> tracer);
+        [[nodiscard]] const std::shared_ptr<RingTracer> &getTracer() const { return tracer_; }
+
+    private:
+        std::shared_ptr<const CompiledFSM> compiled_;
+        StateIndex state_ = CompiledFSM::DEAD_STATE;
+
+        StreamState stream_state_ = StreamState::READY;
+        bool streaming_mode_ = false;
+        size_t position_ = 0;
+
+        // Compact error record, rendered on demand by getLastError()
+        bool has_error_ = false;
+        FSM::ErrorType error_type_ = FSM::ErrorType::NO_MATCHING_TRANSITION;
+        size_t error_position_ = 0;
+        char error_char_ = '\0';
+        StateIndex error_state_ = CompiledFSM::DEAD_STATE;
+
+        DebugConfig debug_config_;
+        void *user_data_ = nullptr;
+        std::vector<FSM::TraceEntry> trace_;
+        FSM::Metrics metrics_;
+        std::shared_ptr<MetricsRegistry> registry_;
+        MetricsShard *shard_ = nullptr;
+        std::shared_ptr<RingTracer> tracer_;
+        bool trace_sampled_ = false;
+        uint32_t trace_validation_ = 0;
+
+        template <typename Handler>
+        bool run(std::string_view input, size_t base_position, Handler &handler);
+        template <bool WITH_ACTIONS, typename Handler>
+        bool scan(std::string_view input, size_t base_position, Handler &handler);
+        template <bool WITH_ACTIONS, typename View, typename Handler>
+        bool scanTable(const View &table, std::string_view input, size_t base_position, Handler &handler);
+        void onTransition(StateIndex from, StateIndex to, unsigned char byte, size_t position);
+        template <typename Handler>
+        void finish(size_t position, Handler &handler);
+        void fail(FSM::ErrorType type, size_t position, char ch);
+        void setError(FSM::ErrorType type, size_t position, char ch); // without counting a reject
+        void recordStream(size_t bytes);
+        void log(const std::string &message) const;
+    };
+
+    using FastMatcher = Matcher<ProductionPolicy>;
+    using InstrumentedMatcher = Matcher<InstrumentedPolicy>;
+    using DebugMatcher = Matcher<DebugPolicy>;
+
+    // ============================================================================
+    // Matcher Implementation
+    // ============================================================================
+
+    template <typename Policy>
+    Matcher<Policy>::Matcher(const FSM &fsm)
+        : compiled_(std::make_shared<const CompiledFSM>(fsm)),
+          debug_config_(fsm.getDebugConfig()), user_data_(fsm.getUserData())
+    {
+        if constexpr (Policy::record_registry)
+        {
+            registry_ = fsm.getMetricsRegistry();
+        }
+        if constexpr (Policy::ring_trace)
+        {
+            tracer_ = fsm.getTracer();
+        }
+        reset();
+    }
+
+    template <typename Policy>
+    Matcher<Policy>::Matcher(std::shared_ptr<const CompiledFSM> compiled)
+        : compiled_(std::move(compiled))
+    {
+        reset();
+    }
+
+    template <typename Policy>
+    template <typename Handler>
+    bool Matcher<Policy>::validate(std::string_view input, Handler &&handler)
+    {
+        reset();
+
+        if constexpr (Policy::record_registry)
+        {
+            if (shard_)
+            {
+                shard_->recordValidation(input.size());
+            }
+        }
+
+        if (state_ == CompiledFSM::DEAD_STATE)
+        {
+            fail(FSM::ErrorType::NO_START_STATE, 0, '\0');
+            return false;
+        }
+
+        // Like FSM::validate(), a machine whose callbacks are dispatched reads
+        // the input whatever its length, so they fire as without the check.
+        const FSM::LengthBounds &bounds = compiled_->getLengthBounds();
+        bool reject_length = !bounds.admits(input.size());
+        if constexpr (Policy::dispatch_callbacks)
+        {
+            reject_length = reject_length && !compiled_->hasCallbacks();
+        }
+
+        if (reject_length)
+        {
+            const size_t position = std::min(input.size(), bounds.max);
+            fail(FSM::ErrorType::LENGTH_OUT_OF_RANGE, position, position < input.size() ? input[position] : '\0');
+            return false;
+        }
+
+        [[maybe_unused]] std::chrono::high_resolution_clock::time_point start_time;
+        if constexpr (Policy::collect_metrics)
+        {
+            if (debug_config_.hasCollectMetrics())
+            {
+                start_time = std::chrono::high_resolution_clock::now();
+            }
+        }
+
+        if (!run(input, 0, handler))
+        {
+            return false;
+        }
+
+        finish(input.size(), handler);
+
+        if (!compiled_->isAcceptState(state_))
+        {
+            fail(FSM::ErrorType::NOT_IN_ACCEPT_STATE, input.size(), '\0');
+            return false;
+        }
+
+        if constexpr (Policy::collect_metrics)
+        {
+            if (debug_config_.hasCollectMetrics())
+            {
+                auto elapsed = std::chrono::high_resolution_clock::now() - start_time;
+                metrics_.validation_time_ns =
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+                metrics_.processing_time =
+                    std::chrono::duration_cast<std::chrono::microseconds>(elapsed);
+            }
+        }
+
+        return true;
+    }
+
+    template <typename Policy>
+    bool Matcher<Policy>::isInAcceptState() const
+    {
+        return state_ != CompiledFSM::DEAD_STATE && compiled_->isAcceptState(state_);
+    }
+
+    template <typename Policy>
+    void Matcher<Policy>::reset()
+    {
+        state_ = compiled_->getStartState();
+        has_error_ = false;
+        stream_state_ = StreamState::READY;
+        streaming_mode_ = false;
+        position_ = 0;
+
+        if constexpr (Policy::trace_transitions || Policy::trace_state_changes)
+        {
+            if (debug_config_.hasTraceTransitions() || debug_config_.hasTraceStateChanges())
+            {
+                trace_.clear();
+            }
+        }
+
+        if constexpr (Policy::collect_metrics)
+        {
+            if (debug_config_.hasCollectMetrics())
+            {
+                metrics_.reset();
+            }
+        }
+
+        if constexpr (Policy::record_registry)
+        {
+            shard_ = registry_ ? &registry_->local() : nullptr;
+        }
+
+        if constexpr (Policy::ring_trace)
+        {
+            trace_sampled_ = tracer_ && tracer_->sample(trace_validation_);
+        }
+    }
+
+    template <typename Policy>
+    void Matcher<Policy>::setTracer(std::shared_ptr<RingTracer> tracer)
+    {
+        tracer_ = std::move(tracer);
+        trace_sampled_ = tracer_ && tracer_->sample(trace_validation_);
+    }
+
+    template <typename Policy>
+    void Matcher<Policy>::setMetricsRegistry(std::shared_ptr<MetricsRegistry> registry)
+    {
+        registry_ = std::move(registry);
+        shard_ = registry_ ? &registry_->local() : nullptr;
+    }
+
+    template <typename Policy>
+    template <typename Handler>
+    StreamState Matcher<Policy>::feed(std::string_view chunk, Handler &&handler)
+    {
+        if (chunk.empty() || stream_state_ == StreamState::ACCEPTED)
+        {
+            return stream_state_;
+        }
+
+        if (!streaming_mode_)
+        {
+            streaming_mode_ = true;
+            stream_state_ = StreamState::PROCESSING;
+
+            if (state_ == CompiledFSM::DEAD_STATE)
+            {
+                recordStream(0);
+                fail(FSM::ErrorType::NO_START_STATE, position_, chunk.front());
+                stream_state_ = StreamState::ERROR;
+                return stream_state_;
+            }
+        }
+
+        // Bytes past the longest accepted input are scanned only to report an
+        // earlier reject.
+        const FSM::LengthBounds &bounds = compiled_->getLengthBounds();
+        const bool too_long = !bounds.empty && chunk.size() > bounds.max - std::min(position_, bounds.max);
+        const std::string_view scanned = too_long ? chunk.substr(0, bounds.max - std::min(position_, bounds.max))
+                                                  : chunk;
+
+        if (!run(scanned, position_, handler))
+        {
+            position_ = error_position_;
+            recordStream(position_);
+            stream_state_ = StreamState::ERROR;
+            return stream_state_;
+        }
+
+        if (too_long)
+        {
+            position_ += scanned.size();
+            fail(FSM::ErrorType::LENGTH_OUT_OF_RANGE, position_, chunk[scanned.size()]);
+            recordStream(position_);
+            stream_state_ = StreamState::ERROR;
+            return stream_state_;
+        }
+
+        position_ += chunk.size();
+        if (compiled_->isAcceptSink(state_))
+        {
+            stream_state_ = StreamState::ACCEPTED;
+        }
+        else
+        {
+            stream_state_ = compiled_->isAcceptState(state_) ? StreamState::COMPLETE
+                                                             : StreamState::WAITING_FOR_INPUT;
+        }
+        return stream_state_;
+    }
+
+    template <typename Policy>
+    template <typename Handler>
+    StreamState Matcher<Policy>::endOfStream(Handler &&handler)
+    {
+        // Nothing was fed, so there is no run to count.
+        if (!streaming_mode_)
+        {
+            setError(FSM::ErrorType::UNEXPECTED_END_OF_INPUT, 0, '\0');
+            stream_state_ = StreamState::ERROR;
+            return stream_state_;
+        }
+
+        recordStream(position_);
+
+        finish(position_, handler);
+
+        if (!compiled_->isAcceptState(state_))
+        {
+            fail(FSM::ErrorType::NOT_IN_ACCEPT_STATE, position_, '\0');
+            stream_state_ = StreamState::ERROR;
+            return stream_state_;
+        }
+
+        stream_state_ = StreamState::COMPLETE;
+        return stream_state_;
+    }
+
+    template <typename Policy>
+    StateID Matcher<Policy>::getCurrentState() const
+    {
+        return state_ == CompiledFSM::DEAD_STATE ? StateID() : compiled_->getStateID(state_);
+    }
+
+    template <typename Policy>
+    std::optional<FSM::ValidationError> Matcher<Policy>::getLastError() const
+    {
+        if (!has_error_)
+        {
+            return std::nullopt;
+        }
+
+        const StateID state = error_state_ == CompiledFSM::DEAD_STATE
+                                  ? StateID()
+                                  : compiled_->getStateID(error_state_);
+        std::string message;
+
+        switch (error_type_)
+        {
+        case FSM::ErrorType::NO_MATCHING_TRANSITION:
+            message = "No transition found from " + state.toString() +
+                      " for character '" + std::string(1, error_char_) + "'";
+            break;
+        case FSM::ErrorType::NOT_IN_ACCEPT_STATE:
+            message = (streaming_mode_ ? "End of stream but not in accept state.  Current state: "
+                                       : "Input consumed but not in accept state.  Current state: ") +
+                      state.toString();
+            break;
+        case FSM::ErrorType::NO_START_STATE:
+            message = "No start state defined";
+            break;
+        case FSM::ErrorType::UNEXPECTED_END_OF_INPUT:
+            message = "End of stream called before any input was fed";
+            break;
+        case FSM::ErrorType::LENGTH_OUT_OF_RANGE:
+            message = "Input length outside accepted range " + compiled_->getLengthBounds().toString();
+            break;
+        default:
+            break;
+        }
+
+        return FSM::ValidationError{error_type_, error_position_, error_char_, state,
+                                    std::move(message), {}, ""};
+    }
+
+    template <typename Policy>
+    template <typename Handler>
+    bool Matcher<Policy>::run(std::string_view input, size_t base_position, Handler &handler)
+    {
+        // Machines without any action keep the plain loop even when a handler
+        // is supplied.
+        if constexpr (std::is_same<std::decay_t<Handler>, NoActions>::value)
+        {
+            return scan<false>(input, base_position, handler);
+        }
+        else
+        {
+            return compiled_->hasActions() ? scan<true>(input, base_position, handler)
+                                           : scan<false>(input, base_position, handler);
+        }
+    }
+
+    template <typename Policy>
+    template <bool WITH_ACTIONS, typename Handler>
+    bool Matcher<Policy>::scan(std::string_view input, size_t base_position, Handler &handler)
+    {
+        return compiled_->withTable([&](const auto &table)
+                                    { return scanTable<WITH_ACTIONS>(table, input, base_position, handler); });
+    }
+
+    template <typename Policy>
+    template <bool WITH_ACTIONS, typename View, typename Handler>
+    bool Matcher<Policy>::scanTable(const View &table, std::string_view input, size_t base_position,
+                                    [[maybe_unused]] Handler &handler)
+    {
+        using Cell = typename View::Cell;
+
+        const uint8_t *classes = compiled_->getClassMap();
+        [[maybe_unused]] const Transition::ActionID *actions = compiled_->getActions();
+        [[maybe_unused]] const uint8_t *action_states = compiled_->getActionStates();
+
+        // Without hooks or actions nothing observes the bytes after an accept
+        // sink, so the scan polls for one every 64 bytes and stops there.
+        constexpr bool CAN_STOP = !HAS_HOOKS && !WITH_ACTIONS;
+        [[maybe_unused]] const uint8_t *sinks = compiled_->hasAcceptSinks() ? compiled_->getAcceptSinks() : nullptr;
+
+        StateIndex state = state_;
+
+        for (size_t i = 0; i < input.size(); ++i)
+        {
+            const auto byte = static_cast<unsigned char>(input[i]);
+            const size_t cell = table.slot(state, classes[byte]);
+            const Cell next = table.cells[cell];
+
+            if (next == CompiledFSM::DEAD_CELL<Cell>)
+            {
+                state_ = state;
+                fail(FSM::ErrorType::NO_MATCHING_TRANSITION, base_position + i, input[i]);
+                return false;
+            }
+
+            if constexpr (HAS_HOOKS)
+            {
+                onTransition(state, next, byte, base_position + i);
+            }
+
+            if constexpr (WITH_ACTIONS)
+            {
+                if (action_states[state] && actions[cell] != Transition::NO_ACTION)
+                {
+                    handler(ActionContext{actions[cell], base_position + i, input[i], state, next});
+                }
+            }
+
+            state = next;
+
+            if constexpr (CAN_STOP)
+            {
+                if ((i & 63) == 63 && sinks && sinks[state])
+                {
+                    break;
+                }
+            }
+        }
+
+        state_ = state;
+        return true;
+    }
+
+    template <typename Policy>
+    void Matcher<Policy>::onTransition(StateIndex from, StateIndex to, unsigned char byte, size_t position)
+    {
+        const CompiledFSM &compiled = *compiled_;
+        const Transition &trans = compiled.getTransition(compiled.edge(from, byte));
+        const char ch = static_cast<char>(byte);
+        const bool state_changed = from != to;
+
+        if constexpr (Policy::dispatch_callbacks)
+        {
+            if (state_changed && compiled.getState(from).on_exit)
+            {
+                compiled.getState(from).on_exit(
+                    StateContext(compiled.getStateID(from), position, ch, user_data_));
+            }
+
+            if (trans.on_transition)
+            {
+                trans.on_transition(TransitionContext(compiled.getStateID(from), compiled.getStateID(to),
+                                                      ch, position, &trans, user_data_));
+            }
+
+            if (state_changed && compiled.getState(to).on_entry)
+            {
+                compiled.getState(to).on_entry(
+                    StateContext(compiled.getStateID(to), position, ch, user_data_));
+            }
+        }
+
+        if constexpr (Policy::record_registry)
+        {
+            if (shard_)
+            {
+                shard_->recordTransition(trans.id);
+                shard_->recordStateVisit(compiled.getStateID(to).id);
+            }
+        }
+
+        if constexpr (Policy::ring_trace)
+        {
+            if (trace_sampled_)
+            {
+                tracer_->record(TraceRecord{trace_validation_, static_cast<uint32_t>(position),
+                                            compiled.getStateID(from).id, compiled.getStateID(to).id,
+                                            trans.id, byte, 0});
+            }
+        }
+
+        if constexpr (Policy::collect_metrics)
+        {
+            if (debug_config_.hasCollectMetrics())
+            {
+                metrics_.transitions_taken++;
+                metrics_.characters_processed++;
+                if (state_changed)
+                {
+                    metrics_.states_visited++;
+                }
+            }
+        }
+
+        if constexpr (Policy::trace_state_changes)
+        {
+            if (debug_config_.hasTraceStateChanges() && state_changed)
+            {
+                log("State change: " + compiled.getStateID(from).toString() + " -> " +
+                    compiled.getStateID(to).toString());
+            }
+        }
+
+        if constexpr (Policy::trace_transitions)
+        {
+            if (debug_config_.hasTraceTransitions())
+            {
+                trace_.push_back(FSM::TraceEntry{trace_.size(), compiled.getStateID(from),
+                                                 compiled.getStateID(to), ch, trans.id,
+                                                 trans.description});
+                log(trace_.back().toString());
+            }
+        }
+    }
+
+    template <typename Policy>
+    template <typename Handler>
+    void Matcher<Policy>::finish(size_t position, [[maybe_unused]] Handler &handler)
+    {
+        constexpr bool WITH_ACTIONS = !std::is_same<std::decay_t<Handler>, NoActions>::value;
+
+        if constexpr (HAS_HOOKS || WITH_ACTIONS)
+        {
+            const CompiledFSM &compiled = *compiled_;
+
+            for (CompiledFSM::EdgeIndex edge : compiled.getEpsilonChain(state_))
+            {
+                const Transition &trans = compiled.getTransition(edge);
+                const StateIndex from = state_;
+                const StateIndex to = compiled.getTarget(edge);
+
+                if constexpr (Policy::dispatch_callbacks)
+                {
+                    if (compiled.getState(from).on_exit)
+                    {
+                        compiled.getState(from).on_exit(
+                            StateContext(compiled.getStateID(from), position, '\0', user_data_));
+                    }
+
+                    if (trans.on_transition)
+                    {
+                        trans.on_transition(TransitionContext(compiled.getStateID(from),
+                                                              compiled.getStateID(to), '\0',
+                                                              position, &trans, user_data_));
+                    }
+                }
+
+                state_ = to;
+
+                if constexpr (Policy::dispatch_callbacks)
+                {
+                    if (compiled.getState(to).on_entry)
+                    {
+                        compiled.getState(to).on_entry(
+                            StateContext(compiled.getStateID(to), position, '\0', user_data_));
+                    }
+                }
+
+                if constexpr (Policy::record_registry)
+                {
+                    if (shard_)
+                    {
+                        shard_->recordTransition(trans.id);
+                        shard_->recordStateVisit(compiled.getStateID(to).id);
+                    }
+                }
+
+                if constexpr (Policy::ring_trace)
+                {
+                    if (trace_sampled_)
+                    {
+                        tracer_->record(TraceRecord{trace_validation_, static_cast<uint32_t>(position),
+                                                    compiled.getStateID(from).id,
+                                                    compiled.getStateID(to).id, trans.id, 0,
+                                                    TraceRecord::EPSILON});
+                    }
+                }
+
+                if constexpr (Policy::collect_metrics)
+                {
+                    if (debug_config_.hasCollectMetrics())
+                    {
+                        metrics_.epsilon_transitions++;
+                    }
+                }
+
+                if constexpr (Policy::trace_state_changes)
+                {
+                    if (debug_config_.hasTraceStateChanges())
+                    {
+                        log("State change: " + compiled.getStateID(from).toString() + " -> " +
+                            compiled.getStateID(to).toString());
+                    }
+                }
+
+                if constexpr (Policy::trace_transitions)
+                {
+                    if (debug_config_.hasTraceTransitions())
+                    {
+                        trace_.push_back(FSM::TraceEntry{trace_.size(), compiled.getStateID(from),
+                                                         compiled.getStateID(to), '\0', trans.id,
+                                                         "Epsilon"});
+                        log(trace_.back().toString());
+                    }
+                }
+
+                if constexpr (WITH_ACTIONS)
+                {
+                    if (trans.action != Transition::NO_ACTION)
+                    {
+                        handler(ActionContext{trans.action, position, '\0', from, to});
+                    }
+                }
+            }
+        }
+        else
+        {
+            state_ = compiled_->getFinalState(state_);
+        }
+    }
+
+    template <typename Policy>
+    void Matcher<Policy>::setError(FSM::ErrorType type, size_t position, char ch)
+    {
+        has_error_ = true;
+        error_type_ = type;
+        error_position_ = position;
+        error_char_ = ch;
+        error_state_ = state_;
+    }
+
+    template <typename Policy>
+    void Matcher<Policy>::fail(FSM::ErrorType type, size_t position, char ch)
+    {
+        setError(type, position, ch);
+        if constexpr (Policy::record_registry)
+        {
+            if (shard_)
+            {
+                shard_->recordReject(type);
+            }
+        }
+    }
+
+    template <typename Policy>
+    void Matcher<Policy>::recordStream([[maybe_unused]] size_t bytes)
+    {
+        if constexpr (Policy::record_registry)
+        {
+            if (shard_)
+            {
+                shard_->recordValidation(bytes);
+            }
+        }
+    }
+
+    template <typename Policy>
+    void Matcher<Policy>::log(const std::string &message) const
+    {
+        debug_config_.getOutputStream() << "[FSM:" << compiled_->getName() << "] " << message << std::endl;
+    }
+
+} // namespace fsm
+
+#endif // FSM_MATCHER_HPP
@@ -0,0 +1,87 @@
+#ifndef FSM_MEMORY_HPP
+#define FSM_MEMORY_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+
+namespace fsm
+{
+    class FSM;
+
+    // ============================================================================
+    // CountingResource - Allocation Accounting
+    // ============================================================================
+    //
+    // Forwards to an upstream resource and counts what passes through. Attach
+    // one with FSM::setMemoryResource() to see how much the runtime allocates;
+    // with COLLECT_METRICS the per-validation count lands in Metrics.
+
+    class CountingResource : public std::pmr::memory_resource
+    {
+    public:
+        explicit CountingResource(std::pmr::memory_resource *upstream = std::pmr::get_default_resource());
+
+        CountingResource(const CountingResource &) = delete;
+        CountingResource &operator=(const CountingResource &) = delete;
+
+        [[nodiscard]] uint64_t getAllocations() const noexcept { return allocations_.load(std::memory_order_relaxed); }
+        [[nodiscard]] uint64_t getDeallocations() const noexcept { return deallocations_.load(std::memory_order_relaxed); }
+        [[nodiscard]] uint64_t getBytesAllocated() const noexcept { return bytes_allocated_.load(std::memory_order_relaxed); }
+        [[nodiscard]] uint64_t getBytesInUse() const noexcept { return bytes_in_use_.load(std::memory_order_relaxed); }
+        [[nodiscard]] std::pmr::memory_resource *getUpstream() const noexcept { return upstream_; }
+
+        // Zeroes the event counters. Bytes in use keep tracking live memory.
+        void reset() noexcept;
+
+        [[nodiscard]] std::string toString() const;
+
+    private:
+        std::pmr::memory_resource *upstream_;
+
+        std::atomic<uint64_t> allocations_{0};
+        std::atomic<uint64_t> deallocations_{0};
+        std::atomic<uint64_t> bytes_allocated_{0};
+        std::atomic<uint64_t> bytes_in_use_{0};
+
+        void *do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+    };
+
+    // ============================================================================
+    // ScopedMemoryResource - Per-Request Arenas
+    // ============================================================================
+    //
+    // Points an FSM's run-time state at `resource` for one request and moves
+    // it back to the previous resource on destruction, dropping captures,
+    // trace and choice points. Declare the arena before the scope so the FSM
+    // lets go of it before it is released:
+    //
+    //   std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer));
+    //   {
+    //       ScopedMemoryResource scope(*fsm, &arena);
+    //       fsm->validate(request);
+    //       use(fsm->getAllCaptures());
+    //   }
+    //   arena.release(); // O(1)
+
+    class ScopedMemoryResource
+    {
+    public:
+        ScopedMemoryResource(FSM &fsm, std::pmr::memory_resource *resource);
+        ~ScopedMemoryResource();
+
+        ScopedMemoryResource(const ScopedMemoryResource &) = delete;
+        ScopedMemoryResource &operator=(const ScopedMemoryResource &) = delete;
+
+    private:
+        FSM &fsm_;
+        std::pmr::memory_resource *previous_;
+    };
+
+} // namespace fsm
+
+#endif // FSM_MEMORY_HPP
@@ -0,0 +1,159 @@
+#ifndef FSM_SEARCH_HPP
+#define FSM_SEARCH_HPP
+
+#include <fsm/compiled.hpp>
+#include <fsm/fsm.hpp>
+#include <optional>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace fsm
+{
+    // ============================================================================
+    // Searcher - Unanchored Search with Exact Spans
+    // ============================================================================
+    //
+    // validate() asks whether a whole input is in the language. A Searcher
+    // finds the substrings that are, using only table lookups:
+    //
+    //   1. Forward over unanchored(fsm) until the first position where some
+    //      match ends.
+    //   2. Backward from that end over reverse(fsm) to the leftmost position
+    //      a match ending there can start.
+    //   3. Forward from that start over fsm itself to the longest match.
+    //
+    // Phase 1 is the only pass over bytes outside matches; phases 2 and 3
+    // cover the match and at most the gap back to the previous one. Phase 3
+    // may run past the match looking for a longer one; the (position, state)
+    // pairs that led nowhere are remembered across a findAll() or count(),
+    // so no byte is rescanned from the same state and the whole search stays
+    // linear in the input (maximal munch, after Reps). A match
+    // is reported when it completes, as a streaming scanner would see it:
+    // for 1*DIGIT over "ab123" that is [2, 5). Matches found by findAll()
+    // never overlap.
+    //
+    //   Searcher numbers(*digits);
+    //   for (const Searcher::Match& m : numbers.findAll(text)) m.in(text);
+    //
+    // The constructor throws std::invalid_argument for machines the
+    // language operations reject (see <fsm/algebra.hpp>).
+
+    class Searcher
+    {
+    public:
+        struct Match
+        {
+            size_t begin;
+            size_t end;
+
+            [[nodiscard]] size_t length() const { return end - begin; }
+            [[nodiscard]] std::string_view in(std::string_view input) const
+            {
+                return input.substr(begin, end - begin);
+            }
+            bool operator==(const Match &other) const { return begin == other.begin && end == other.end; }
+        };
+
+        explicit Searcher(const FSM &fsm);
+
+        // The first match that ends at or after `from` and starts there or later
+        [[nodiscard]] std::optional<Match> find(std::string_view input, size_t from = 0) const;
+        [[nodiscard]] std::vector<Match> findAll(std::string_view input) const;
+
+        // Phase 1 only
+        [[nodiscard]] bool contains(std::string_view input) const;
+
+        // findAll().size() without storing the matches.
+        [[nodiscard]] size_t count(std::string_view input) const;
+
+        // The same count, with the input split into one chunk per thread (0:
+        // one per core). Each chunk is counted as if a search started at each
+        // of its first TRACKS bytes; chunks are then stitched in order,
+        // re-running the search only until it lines up with one of those, so
+        // matches that straddle a boundary are counted exactly once.
+        [[nodiscard]] size_t countParallel(std::string_view input, unsigned threads = 0) const;
+
+        [[nodiscard]] const CompiledFSM &getForward() const { return forward_; }
+        [[nodiscard]] const CompiledFSM &getReverse() const { return reverse_; }
+        [[nodiscard]] const CompiledFSM &getScanner() const { return scanner_; }
+
+    private:
+        using StateIndex = CompiledFSM::StateIndex;
+
+        // Where one search through a chunk of countParallel() left off
+        struct Chunk
+        {
+            size_t count = 0;
+            std::vector<size_t> starts; // search start before each match, up to RESUME_LIMIT
+            size_t first_end;           // end of the first match
+            size_t exit;                // search start after the last match
+            bool pending = false;       // no match end between `exit` and the chunk end
+            StateIndex state;           // scanner state at the chunk end, when pending
+        };
+
+        // Phase 3 pairs from which the forward machine reaches no later
+        // accept. They hold for the whole input, so one Memo serves every
+        // search over it.
+        struct Memo
+        {
+            std::unordered_set<uint64_t> dead_ends; // position * states + state
+            size_t horizon = 0;                     // no dead end at or past this position
+        };
+
+        static constexpr size_t NO_POSITION = static_cast<size_t>(-1);
+        static constexpr size_t RESUME_LIMIT = 64;
+        // Searches per chunk, started at its first bytes. Periodic input
+        // whose matches never restart where the first one does (pairs of
+        // "a" entered at an odd offset) lines up with another.
+        static constexpr size_t TRACKS = 4;
+
+        CompiledFSM forward_;
+        CompiledFSM reverse_;
+        CompiledFSM scanner_;
+
+        // Phase 1 from `state` at `from`, looking at ends up to `limit`;
+        // leaves the state at `limit` when none is found.
+        [[nodiscard]] size_t firstEnd(std::string_view input, size_t from, size_t limit, StateIndex &state) const;
+        // Phases 2 and 3
+        [[nodiscard]] Match widen(std::string_view input, size_t from, size_t end, Memo &memo) const;
+        [[nodiscard]] std::optional<Match> find(std::string_view input, size_t from, Memo &memo) const;
+        // The search from `from`; it stops early once it restarts where one
+        // of `tracks` did.
+        [[nodiscard]] Chunk countChunk(std::string_view input, size_t from, size_t end,
+                                       const std::vector<Chunk> &tracks) const;
+
+        // Where the next search starts after `match`
+        static size_t resume(const Match &match) { return match.end + (match.length() == 0 ? 1 : 0); }
+    };
+
+    // ============================================================================
+    // Record Counting
+    // ============================================================================
+    //
+    // For analytics over newline-delimited (or similar) data: every record
+    // between separators is validated on its own and only tallied. It is one
+    // table walk over the buffer with no per-record reset, and a rejected
+    // record is skipped with memchr. Records are tallied by the state they
+    // end in, so a machine with one accept state per pattern counts each
+    // pattern separately.
+    //
+    // With threads != 1 the buffer is split at separators, so no record
+    // straddles two threads.
+
+    struct RecordCounts
+    {
+        size_t records = 0;
+        size_t accepted = 0;
+        std::vector<size_t> by_state; // accepted records by CompiledFSM::StateIndex
+
+        RecordCounts &operator+=(const RecordCounts &other);
+    };
+
+    // A trailing separator does not start another record.
+    [[nodiscard]] RecordCounts countRecords(const CompiledFSM &compiled, std::string_view input,
+                                            char separator = '\n', unsigned threads = 1);
+
+} // namespace fsm
+
+#endif // FSM_SEARCH_HPP
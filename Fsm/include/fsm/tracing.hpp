@@ -0,0 +1,103 @@
+#ifndef FSM_TRACING_HPP
+#define FSM_TRACING_HPP
+
+#include <fsm/fsm.hpp>
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace fsm
+{
+    // ============================================================================
+    // TraceRecord - Compact Binary Trace Entry
+    // ============================================================================
+
+    struct TraceRecord
+    {
+        static constexpr uint8_t EPSILON = 0x01;
+
+        uint32_t validation; // sampled validation sequence number
+        uint32_t step;       // input position
+        uint32_t from;       // StateID::id
+        uint32_t to;         // StateID::id
+        uint32_t transition; // TransitionID
+        uint8_t byte;
+        uint8_t flags;
+        uint16_t reserved = 0;
+
+        [[nodiscard]] bool isEpsilon() const { return (flags & EPSILON) != 0; }
+    };
+
+    static_assert(sizeof(TraceRecord) == 24, "TraceRecord is written to disk as-is");
+
+    // ============================================================================
+    // RingTracer - Fixed-Capacity Lock-Free Trace Buffer
+    // ============================================================================
+    //
+    // Writers claim slots with one fetch_add and overwrite the oldest records,
+    // so memory use is fixed no matter how long tracing stays enabled. Each
+    // slot carries a sequence number; snapshot() skips slots that are being
+    // rewritten. With sampling only every Nth validation is recorded.
+
+    class RingTracer
+    {
+    public:
+        explicit RingTracer(size_t capacity, uint32_t sample_every = 1);
+
+        RingTracer(const RingTracer &) = delete;
+        RingTracer &operator=(const RingTracer &) = delete;
+
+        // Called once per validation; returns its sequence number if sampled.
+        bool sample(uint32_t &validation) noexcept;
+
+        void record(const TraceRecord &record) noexcept;
+
+        // Oldest first; only records that are still intact.
+        [[nodiscard]] std::vector<TraceRecord> snapshot() const;
+        void clear() noexcept;
+
+        [[nodiscard]] size_t capacity() const noexcept { return mask_ + 1; }
+        [[nodiscard]] uint32_t getSampleEvery() const noexcept { return sample_every_; }
+        [[nodiscard]] uint64_t getRecorded() const noexcept { return cursor_.load(std::memory_order_relaxed); }
+
+        // Binary dump: "FSMTRACE", uint32 version, uint64 count, then records.
+        void write(std::ostream &os) const;
+        void save(const std::string &filename) const;
+
+    private:
+        struct Slot
+        {
+            std::atomic<uint64_t> sequence{0}; // 0 = empty, odd = being written
+            std::atomic<uint64_t> words[3];
+        };
+
+        std::unique_ptr<Slot[]> slots_;
+        size_t mask_;
+        uint32_t sample_every_;
+
+        alignas(64) std::atomic<uint64_t> cursor_{0};
+        alignas(64) std::atomic<uint32_t> validations_{0};
+    };
+
+    // ============================================================================
+    // Trace Decoding (offline)
+    // ============================================================================
+
+    namespace trace
+    {
+        std::vector<TraceRecord> read(std::istream &is);
+        std::vector<TraceRecord> load(const std::string &filename);
+
+        // State names are resolved through the machine when one is given.
+        std::string toText(const std::vector<TraceRecord> &records, const FSM *fsm = nullptr);
+
+        // The machine's graph with traversed edges highlighted and counted.
+        std::string toDot(const std::vector<TraceRecord> &records, const FSM &fsm);
+    }
+
+} // namespace fsm
+
+#endif // FSM_TRACING_HPP
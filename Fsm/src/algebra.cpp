@@ -0,0 +1,474 @@
+#include <fsm/algebra.hpp>
+#include <fsm/compiled.hpp>
+#include <algorithm>
+#include <array>
+#include <map>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace fsm
+{
+    namespace
+    {
+        // ============================================================================
+        // Total DFA
+        // ============================================================================
+        //
+        // Every state has a target for every byte class. Bytes the source
+        // machine rejects go to an explicit trap state, so complement is just
+        // flipping the accept flags.
+
+        struct Dfa
+        {
+            std::array<uint8_t, 256> class_map{};
+            size_t class_count = 1;
+            std::vector<uint32_t> next; // by state * class_count + class
+            std::vector<uint8_t> accepting;
+            uint32_t start = 0;
+
+            [[nodiscard]] size_t size() const { return accepting.size(); }
+            [[nodiscard]] uint32_t target(uint32_t state, size_t byte_class) const
+            {
+                return next[state * class_count + byte_class];
+            }
+        };
+
+        Dfa toDfa(const FSM &fsm)
+        {
+            switch (fsm.getSelectedEngine())
+            {
+            case FSM::Engine::PUSHDOWN:
+                throw std::invalid_argument("FSM '" + fsm.getName() + "' has sub-machine calls");
+            case FSM::Engine::BACKTRACKING:
+                throw std::invalid_argument("FSM '" + fsm.getName() + "' is not deterministic");
+            default:
+                break;
+            }
+
+            const CompiledFSM compiled(fsm);
+            const uint32_t trap = static_cast<uint32_t>(compiled.getStateCount());
+
+            Dfa dfa;
+            dfa.class_count = compiled.getClassCount();
+            std::vector<int> representative(dfa.class_count, -1);
+            for (int byte = 0; byte < 256; ++byte)
+            {
+                const uint8_t byte_class = compiled.getByteClass(static_cast<unsigned char>(byte));
+                dfa.class_map[byte] = byte_class;
+                if (representative[byte_class] < 0)
+                {
+                    representative[byte_class] = byte;
+                }
+            }
+
+            dfa.accepting.assign(trap + 1, 0);
+            dfa.next.assign((trap + 1) * dfa.class_count, trap);
+            for (uint32_t s = 0; s < trap; ++s)
+            {
+                dfa.accepting[s] = compiled.isAcceptingAtEnd(s) ? 1 : 0;
+                for (size_t c = 0; c < dfa.class_count; ++c)
+                {
+                    const CompiledFSM::StateIndex to =
+                        compiled.next(s, static_cast<unsigned char>(representative[c]));
+                    dfa.next[s * dfa.class_count + c] = to == CompiledFSM::DEAD_STATE ? trap : to;
+                }
+            }
+
+            dfa.start = compiled.getStartState() == CompiledFSM::DEAD_STATE ? trap : compiled.getStartState();
+            return dfa;
+        }
+
+        // ============================================================================
+        // Product Construction
+        // ============================================================================
+
+        template <typename Accept>
+        Dfa product(const Dfa &a, const Dfa &b, Accept accept)
+        {
+            Dfa result;
+
+            // A byte's class in the product is its pair of operand classes.
+            std::map<std::pair<uint8_t, uint8_t>, uint8_t> pair_classes;
+            std::vector<std::pair<uint8_t, uint8_t>> class_pairs;
+            for (int byte = 0; byte < 256; ++byte)
+            {
+                const std::pair<uint8_t, uint8_t> key{a.class_map[byte], b.class_map[byte]};
+                auto [it, inserted] = pair_classes.emplace(key, static_cast<uint8_t>(class_pairs.size()));
+                if (inserted)
+                {
+                    class_pairs.push_back(key);
+                }
+                result.class_map[byte] = it->second;
+            }
+            result.class_count = class_pairs.size();
+
+            // Only pairs reachable from the start pair are built.
+            std::unordered_map<uint64_t, uint32_t> index;
+            std::vector<std::pair<uint32_t, uint32_t>> states;
+            auto intern = [&](uint32_t sa, uint32_t sb)
+            {
+                auto [it, inserted] = index.emplace((uint64_t{sa} << 32) | sb, static_cast<uint32_t>(states.size()));
+                if (inserted)
+                {
+                    states.emplace_back(sa, sb);
+                }
+                return it->second;
+            };
+
+            result.start = intern(a.start, b.start);
+            for (size_t head = 0; head < states.size(); ++head)
+            {
+                const auto [sa, sb] = states[head];
+                result.accepting.push_back(accept(a.accepting[sa] != 0, b.accepting[sb] != 0) ? 1 : 0);
+                for (const auto &[ca, cb] : class_pairs)
+                {
+                    result.next.push_back(intern(a.target(sa, ca), b.target(sb, cb)));
+                }
+            }
+            return result;
+        }
+
+        // ============================================================================
+        // Subset Construction
+        // ============================================================================
+        //
+        // Reads `dfa` as a nondeterministic machine over the same byte
+        // classes: `step` maps a sorted set of its states and a class to the
+        // next set, and a set accepts when `accept` says so. The empty set is
+        // an ordinary (trap) state.
+
+        using StateSet = std::vector<uint32_t>;
+
+        template <typename Step, typename Accept>
+        Dfa determinize(const Dfa &dfa, const std::string &name, StateSet start, Step step, Accept accept)
+        {
+            Dfa result;
+            result.class_map = dfa.class_map;
+            result.class_count = dfa.class_count;
+
+            std::map<StateSet, uint32_t> index;
+            std::vector<const StateSet *> sets;
+            auto intern = [&](StateSet set)
+            {
+                std::sort(set.begin(), set.end());
+                set.erase(std::unique(set.begin(), set.end()), set.end());
+                auto [it, inserted] = index.emplace(std::move(set), static_cast<uint32_t>(sets.size()));
+                if (inserted)
+                {
+                    if (sets.size() == MAX_SUBSET_STATES)
+                    {
+                        throw std::invalid_argument("FSM '" + name + "' needs more than " +
+                                                    std::to_string(MAX_SUBSET_STATES) + " subset states");
+                    }
+                    sets.push_back(&it->first);
+                }
+                return it->second;
+            };
+
+            result.start = intern(std::move(start));
+            for (size_t head = 0; head < sets.size(); ++head)
+            {
+                const StateSet &set = *sets[head];
+                result.accepting.push_back(accept(set) ? 1 : 0);
+                for (size_t c = 0; c < dfa.class_count; ++c)
+                {
+                    result.next.push_back(intern(step(set, c)));
+                }
+            }
+            return result;
+        }
+
+        Dfa reverseDfa(const Dfa &dfa, const std::string &name)
+        {
+            const size_t n = dfa.size();
+
+            // Unreachable states can never be on a reversed path to the start.
+            std::vector<uint8_t> reachable(n, 0);
+            std::vector<uint32_t> stack{dfa.start};
+            reachable[dfa.start] = 1;
+            while (!stack.empty())
+            {
+                const uint32_t s = stack.back();
+                stack.pop_back();
+                for (size_t c = 0; c < dfa.class_count; ++c)
+                {
+                    const uint32_t to = dfa.target(s, c);
+                    if (!reachable[to])
+                    {
+                        reachable[to] = 1;
+                        stack.push_back(to);
+                    }
+                }
+            }
+
+            // Predecessors by class * n + target
+            std::vector<StateSet> predecessors(dfa.class_count * n);
+            StateSet accepting;
+            for (uint32_t s = 0; s < n; ++s)
+            {
+                if (!reachable[s])
+                {
+                    continue;
+                }
+                if (dfa.accepting[s])
+                {
+                    accepting.push_back(s);
+                }
+                for (size_t c = 0; c < dfa.class_count; ++c)
+                {
+                    predecessors[c * n + dfa.target(s, c)].push_back(s);
+                }
+            }
+
+            return determinize(
+                dfa, name, accepting,
+                [&](const StateSet &set, size_t c)
+                {
+                    StateSet out;
+                    for (uint32_t s : set)
+                    {
+                        const StateSet &from = predecessors[c * n + s];
+                        out.insert(out.end(), from.begin(), from.end());
+                    }
+                    return out;
+                },
+                [&](const StateSet &set)
+                { return std::binary_search(set.begin(), set.end(), dfa.start); });
+        }
+
+        Dfa unanchoredDfa(const Dfa &dfa, const std::string &name)
+        {
+            // The trap can never lead to a match, so it is left out of sets.
+            const uint32_t trap = static_cast<uint32_t>(dfa.size() - 1);
+            return determinize(
+                dfa, name, {dfa.start},
+                [&](const StateSet &set, size_t c)
+                {
+                    StateSet out{dfa.start};
+                    for (uint32_t s : set)
+                    {
+                        const uint32_t to = dfa.target(s, c);
+                        if (to != trap)
+                        {
+                            out.push_back(to);
+                        }
+                    }
+                    return out;
+                },
+                [&](const StateSet &set)
+                {
+                    return std::any_of(set.begin(), set.end(), [&](uint32_t s)
+                                       { return dfa.accepting[s] != 0; });
+                });
+        }
+
+        // ============================================================================
+        // Minimization
+        // ============================================================================
+        //
+        // Moore's partition refinement: start from accepting / rejecting and
+        // split blocks by the blocks their successors fall in until nothing
+        // changes. Block numbers follow first appearance in state order.
+
+        Dfa minimizeDfa(const Dfa &dfa)
+        {
+            const size_t n = dfa.size();
+            std::vector<uint32_t> block(n);
+            size_t block_count = 0;
+            {
+                std::map<uint8_t, uint32_t> initial;
+                for (size_t s = 0; s < n; ++s)
+                {
+                    block[s] = initial.emplace(dfa.accepting[s], static_cast<uint32_t>(initial.size())).first->second;
+                }
+                block_count = initial.size();
+            }
+
+            std::vector<uint32_t> signature(dfa.class_count + 1);
+            while (true)
+            {
+                std::map<std::vector<uint32_t>, uint32_t> blocks;
+                std::vector<uint32_t> refined(n);
+                for (size_t s = 0; s < n; ++s)
+                {
+                    signature[0] = block[s];
+                    for (size_t c = 0; c < dfa.class_count; ++c)
+                    {
+                        signature[c + 1] = block[dfa.target(static_cast<uint32_t>(s), c)];
+                    }
+                    refined[s] = blocks.emplace(signature, static_cast<uint32_t>(blocks.size())).first->second;
+                }
+
+                block.swap(refined);
+                if (blocks.size() == block_count)
+                {
+                    break;
+                }
+                block_count = blocks.size();
+            }
+
+            Dfa result;
+            result.class_map = dfa.class_map;
+            result.class_count = dfa.class_count;
+            result.accepting.assign(block_count, 0);
+            result.next.assign(block_count * dfa.class_count, 0);
+            result.start = block[dfa.start];
+            for (size_t s = 0; s < n; ++s)
+            {
+                result.accepting[block[s]] = dfa.accepting[s];
+                for (size_t c = 0; c < dfa.class_count; ++c)
+                {
+                    result.next[block[s] * dfa.class_count + c] = block[dfa.target(static_cast<uint32_t>(s), c)];
+                }
+            }
+            return result;
+        }
+
+        // ============================================================================
+        // Back to an FSM
+        // ============================================================================
+        //
+        // States that cannot reach acceptance (the trap) are left out; a
+        // missing transition already rejects. States are numbered breadth-first
+        // from the start.
+
+        std::shared_ptr<FSM> toFSM(const Dfa &dfa, const std::string &name)
+        {
+            const size_t n = dfa.size();
+
+            std::vector<uint8_t> live(dfa.accepting.begin(), dfa.accepting.end());
+            for (bool changed = true; changed;)
+            {
+                changed = false;
+                for (uint32_t s = 0; s < n; ++s)
+                {
+                    for (size_t c = 0; c < dfa.class_count && !live[s]; ++c)
+                    {
+                        if (live[dfa.target(s, c)])
+                        {
+                            live[s] = 1;
+                            changed = true;
+                        }
+                    }
+                }
+            }
+
+            auto fsm = std::make_shared<FSM>(name);
+            std::vector<StateID> ids(n);
+            std::vector<uint8_t> added(n, 0);
+            std::vector<uint32_t> order{dfa.start};
+            added[dfa.start] = 1;
+
+            for (size_t head = 0; head < order.size(); ++head)
+            {
+                const uint32_t s = order[head];
+                ids[s] = fsm->addState("q" + std::to_string(head),
+                                       head == 0 ? StateType::START
+                                                 : (dfa.accepting[s] ? StateType::ACCEPT : StateType::NORMAL));
+                if (dfa.accepting[s])
+                {
+                    fsm->addAcceptState(ids[s]);
+                }
+
+                for (size_t c = 0; c < dfa.class_count; ++c)
+                {
+                    const uint32_t to = dfa.target(s, c);
+                    if (live[to] && !added[to])
+                    {
+                        added[to] = 1;
+                        order.push_back(to);
+                    }
+                }
+            }
+            fsm->setStartState(ids[dfa.start]);
+
+            for (uint32_t s : order)
+            {
+                if (!live[s])
+                {
+                    continue;
+                }
+
+                // One rule per target, built from runs of consecutive bytes.
+                std::map<uint32_t, ABNF> rules;
+                for (int lo = 0; lo < 256;)
+                {
+                    const uint32_t to = dfa.target(s, dfa.class_map[lo]);
+                    int hi = lo;
+                    while (hi < 255 && dfa.target(s, dfa.class_map[hi + 1]) == to)
+                    {
+                        ++hi;
+                    }
+                    if (live[to])
+                    {
+                        ABNF run(static_cast<uint8_t>(lo), static_cast<uint8_t>(hi));
+                        auto [it, inserted] = rules.emplace(to, run);
+                        if (!inserted)
+                        {
+                            it->second = it->second | run;
+                        }
+                    }
+                    lo = hi + 1;
+                }
+
+                for (const auto &[to, rule] : rules)
+                {
+                    fsm->addTransition(ids[s], ids[to], rule);
+                }
+            }
+
+            return fsm;
+        }
+    }
+
+    // ============================================================================
+    // Public Operations
+    // ============================================================================
+
+    std::shared_ptr<FSM> intersect(const FSM &a, const FSM &b)
+    {
+        return toFSM(minimizeDfa(product(toDfa(a), toDfa(b), [](bool x, bool y)
+                                         { return x && y; })),
+                     "(" + a.getName() + " & " + b.getName() + ")");
+    }
+
+    std::shared_ptr<FSM> unite(const FSM &a, const FSM &b)
+    {
+        return toFSM(minimizeDfa(product(toDfa(a), toDfa(b), [](bool x, bool y)
+                                         { return x || y; })),
+                     "(" + a.getName() + " | " + b.getName() + ")");
+    }
+
+    std::shared_ptr<FSM> difference(const FSM &a, const FSM &b)
+    {
+        return toFSM(minimizeDfa(product(toDfa(a), toDfa(b), [](bool x, bool y)
+                                         { return x && !y; })),
+                     "(" + a.getName() + " - " + b.getName() + ")");
+    }
+
+    std::shared_ptr<FSM> complement(const FSM &a)
+    {
+        Dfa dfa = toDfa(a);
+        for (uint8_t &accepting : dfa.accepting)
+        {
+            accepting = !accepting;
+        }
+        return toFSM(minimizeDfa(dfa), "~" + a.getName());
+    }
+
+    std::shared_ptr<FSM> minimize(const FSM &a)
+    {
+        return toFSM(minimizeDfa(toDfa(a)), a.getName());
+    }
+
+    std::shared_ptr<FSM> reverse(const FSM &a)
+    {
+        return toFSM(minimizeDfa(reverseDfa(toDfa(a), a.getName())), "reverse(" + a.getName() + ")");
+    }
+
+    std::shared_ptr<FSM> unanchored(const FSM &a)
+    {
+        return toFSM(minimizeDfa(unanchoredDfa(toDfa(a), a.getName())), ".*" + a.getName());
+    }
+
+} // namespace fsm
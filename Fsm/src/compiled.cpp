@@ -0,0 +1,530 @@
+#include <fsm/compiled.hpp>
+#include <algorithm>
+#include <sstream>
+
+namespace fsm
+{
+
+    // ============================================================================
+    // CompiledFSM Construction
+    // ============================================================================
+
+    namespace
+    {
+        // Narrowest cell that holds every index below count plus a dead value
+        size_t cellBytes(size_t count)
+        {
+            if (count < CompiledFSM::DEAD_CELL<uint8_t>)
+            {
+                return 1;
+            }
+            return count < CompiledFSM::DEAD_CELL<uint16_t> ? 2 : 4;
+        }
+    }
+
+    CompiledFSM::CompiledFSM(const FSM &fsm, TableLayout layout)
+        : name_(fsm.getName())
+    {
+        // Unreachable states are dropped. Profiled machines lay out hot states
+        // first so their rows share cache lines.
+        state_ids_ = fsm.getStates();
+        const std::vector<StateID> unreachable = fsm.getUnreachableStates();
+        state_ids_.erase(std::remove_if(state_ids_.begin(), state_ids_.end(),
+                                        [&unreachable](const StateID &id)
+                                        { return std::binary_search(unreachable.begin(), unreachable.end(), id); }),
+                         state_ids_.end());
+        std::sort(state_ids_.begin(), state_ids_.end(),
+                  [&fsm](const StateID &a, const StateID &b)
+                  {
+                      const uint64_t hits_a = fsm.getProfiledVisits(a);
+                      const uint64_t hits_b = fsm.getProfiledVisits(b);
+                      return hits_a != hits_b ? hits_a > hits_b : a < b;
+                  });
+
+        for (StateIndex i = 0; i < state_ids_.size(); ++i)
+        {
+            index_of_[state_ids_[i]] = i;
+            states_.push_back(fsm.getState(state_ids_[i]));
+
+            if (states_.back().on_entry || states_.back().on_exit)
+            {
+                has_callbacks_ = true;
+            }
+        }
+
+        // Per-state transition lists in the exact order the interpreter tries them.
+        std::vector<std::vector<EdgeIndex>> outgoing(state_ids_.size());
+        std::vector<const Transition *> rules;
+
+        for (StateIndex i = 0; i < state_ids_.size(); ++i)
+        {
+            for (const Transition *trans : fsm.getTransitionsFrom(state_ids_[i]))
+            {
+                outgoing[i].push_back(static_cast<EdgeIndex>(transitions_.size()));
+                transitions_.push_back(*trans);
+                targets_.push_back(indexOf(trans->to));
+                transition_ids_.push_back(trans->id);
+
+                if (trans->type == TransitionType::ABNF_RULE && trans->rule.has_value())
+                {
+                    rules.push_back(trans);
+                }
+
+                if (trans->on_transition)
+                {
+                    has_callbacks_ = true;
+                }
+            }
+        }
+
+        buildByteClasses(rules);
+
+        // Representative byte of each class
+        std::vector<unsigned char> representative(class_count_);
+        for (int byte = 255; byte >= 0; --byte)
+        {
+            representative[class_map_[byte]] = static_cast<unsigned char>(byte);
+        }
+
+        const size_t state_count = state_ids_.size();
+
+        // Edges into dead states stay NO_EDGE so the scan rejects on the spot.
+        std::vector<uint8_t> dead(state_count);
+        for (StateIndex s = 0; s < state_count; ++s)
+        {
+            dead[s] = fsm.isDeadState(state_ids_[s]) ? 1 : 0;
+        }
+
+        // One state's row, built on demand so the comb layout never holds
+        // the whole dense table.
+        auto fill_row = [&](StateIndex s, EdgeIndex *row)
+        {
+            for (size_t c = 0; c < class_count_; ++c)
+            {
+                const char ch = static_cast<char>(representative[c]);
+                row[c] = NO_EDGE;
+
+                for (EdgeIndex e : outgoing[s])
+                {
+                    const Transition &trans = transitions_[e];
+                    if (trans.type == TransitionType::ABNF_RULE && trans.matches(ch) &&
+                        targets_[e] != DEAD_STATE)
+                    {
+                        if (!dead[targets_[e]])
+                        {
+                            row[c] = e;
+                        }
+                        break;
+                    }
+                }
+            }
+        };
+
+        // Small tables stay dense: they fit in cache and skip the check probe.
+        // Both sizes count the edge kept beside every next cell.
+        const size_t cell_bytes = cellBytes(state_count);
+        const size_t edge_bytes = cellBytes(transitions_.size());
+        const size_t dense_bytes = state_count * class_count_ * (cell_bytes + edge_bytes);
+        std::vector<StateIndex> check;
+        std::vector<EdgeIndex> edges;
+
+        if (layout == TableLayout::COMB ||
+            (layout == TableLayout::AUTO && dense_bytes >= COMB_MIN_DENSE_BYTES))
+        {
+            check = buildComb(fill_row, edges);
+
+            const size_t comb_bytes = (edges.size() + check.size()) * cell_bytes + edges.size() * edge_bytes +
+                                      base_.size() * sizeof(uint32_t);
+            if (layout == TableLayout::AUTO && comb_bytes * 2 > dense_bytes)
+            {
+                layout_ = TableLayout::DENSE;
+                check.clear();
+                base_.clear();
+            }
+        }
+
+        if (layout_ == TableLayout::DENSE)
+        {
+            edges.assign(state_count * class_count_, NO_EDGE);
+            for (StateIndex s = 0; s < state_count; ++s)
+            {
+                fill_row(s, edges.data() + s * class_count_);
+            }
+        }
+
+        std::vector<StateIndex> cells(edges.size(), DEAD_STATE);
+        for (size_t slot = 0; slot < edges.size(); ++slot)
+        {
+            if (edges[slot] != NO_EDGE)
+            {
+                cells[slot] = targets_[edges[slot]];
+            }
+        }
+
+        narrowTable(cells, check);
+        narrowEdges(edges);
+
+        for (size_t slot = 0; slot < edges.size(); ++slot)
+        {
+            if (edges[slot] == NO_EDGE || transitions_[edges[slot]].action == Transition::NO_ACTION)
+            {
+                continue;
+            }
+
+            if (actions_.empty())
+            {
+                actions_.assign(edges.size(), Transition::NO_ACTION);
+                action_states_.assign(state_count, 0);
+            }
+
+            // Dense rows, packed comb slots and per-state default slots
+            StateIndex owner;
+            if (layout_ == TableLayout::DENSE)
+            {
+                owner = static_cast<StateIndex>(slot / class_count_);
+            }
+            else
+            {
+                owner = slot < check.size() ? check[slot] : static_cast<StateIndex>(slot - check.size());
+            }
+
+            actions_[slot] = transitions_[edges[slot]].action;
+            action_states_[owner] = 1;
+        }
+
+        // Epsilon chains follow the first epsilon edge that leads somewhere new,
+        // matching FSM::processEpsilonTransitions().
+        accept_.resize(state_count);
+        accept_at_end_.resize(state_count);
+        final_states_.resize(state_count);
+        epsilon_chains_.resize(state_count);
+
+        for (StateIndex s = 0; s < state_count; ++s)
+        {
+            std::vector<StateIndex> visited{s};
+            StateIndex current = s;
+
+            bool found_epsilon = true;
+            while (found_epsilon)
+            {
+                found_epsilon = false;
+
+                for (EdgeIndex e : outgoing[current])
+                {
+                    if (transitions_[e].type == TransitionType::EPSILON &&
+                        targets_[e] != DEAD_STATE &&
+                        std::find(visited.begin(), visited.end(), targets_[e]) == visited.end())
+                    {
+                        epsilon_chains_[s].push_back(e);
+                        current = targets_[e];
+                        visited.push_back(current);
+                        found_epsilon = true;
+                        break;
+                    }
+                }
+            }
+
+            final_states_[s] = current;
+            accept_[s] = fsm.isAcceptState(state_ids_[s]) ? 1 : 0;
+            accept_at_end_[s] = fsm.isAcceptState(state_ids_[current]) ? 1 : 0;
+        }
+
+        length_bounds_ = fsm.getLengthBounds();
+
+        accept_sinks_.resize(state_count);
+        for (StateIndex s = 0; s < state_count; ++s)
+        {
+            accept_sinks_[s] = fsm.isAcceptSink(state_ids_[s]) ? 1 : 0;
+            has_accept_sinks_ = has_accept_sinks_ || accept_sinks_[s];
+        }
+
+        if (fsm.getStartState().isValid() && fsm.hasState(fsm.getStartState()))
+        {
+            start_state_ = indexOf(fsm.getStartState());
+        }
+    }
+
+    void CompiledFSM::buildByteClasses(const std::vector<const Transition *> &rules)
+    {
+        // Partition refinement: two bytes share a class when every rule treats
+        // them the same way.
+        class_map_.fill(0);
+        class_count_ = 1;
+
+        for (const Transition *trans : rules)
+        {
+            std::array<int, 512> remap;
+            remap.fill(-1);
+            size_t next_class = 0;
+            std::array<uint8_t, 256> refined{};
+
+            for (int byte = 0; byte < 256; ++byte)
+            {
+                const int key = class_map_[byte] * 2 + (trans->matches(static_cast<char>(byte)) ? 1 : 0);
+                if (remap[key] < 0)
+                {
+                    remap[key] = static_cast<int>(next_class++);
+                }
+                refined[byte] = static_cast<uint8_t>(remap[key]);
+            }
+
+            if (next_class != class_count_)
+            {
+                class_map_ = refined;
+                class_count_ = next_class;
+            }
+        }
+    }
+
+    std::vector<CompiledFSM::StateIndex> CompiledFSM::buildComb(const RowFiller &fill_row,
+                                                                std::vector<EdgeIndex> &edges)
+    {
+        // Row displacement: every state's most common edge becomes its default;
+        // the remaining cells are packed first-fit, densest rows first. Rows
+        // are built one at a time and only their non-default cells are kept.
+        const size_t state_count = state_ids_.size();
+        std::vector<EdgeIndex> defaults(state_count, NO_EDGE);
+        std::vector<size_t> entries_begin(state_count + 1, 0);
+        std::vector<uint8_t> entry_classes;
+        std::vector<EdgeIndex> entry_edges;
+        std::vector<EdgeIndex> row(class_count_);
+        std::vector<EdgeIndex> sorted(class_count_);
+
+        for (StateIndex s = 0; s < state_count; ++s)
+        {
+            fill_row(s, row.data());
+            std::copy(row.begin(), row.end(), sorted.begin());
+            std::sort(sorted.begin(), sorted.end());
+
+            size_t best_run = 0;
+            for (size_t i = 0, j; i < sorted.size(); i = j)
+            {
+                for (j = i; j < sorted.size() && sorted[j] == sorted[i]; ++j)
+                {
+                }
+                if (j - i > best_run)
+                {
+                    best_run = j - i;
+                    defaults[s] = sorted[i];
+                }
+            }
+
+            for (size_t c = 0; c < class_count_; ++c)
+            {
+                if (row[c] != defaults[s])
+                {
+                    entry_classes.push_back(static_cast<uint8_t>(c));
+                    entry_edges.push_back(row[c]);
+                }
+            }
+            entries_begin[s + 1] = entry_classes.size();
+        }
+
+        auto entry_count = [&entries_begin](StateIndex s)
+        {
+            return entries_begin[s + 1] - entries_begin[s];
+        };
+
+        std::vector<StateIndex> order(state_count);
+        for (StateIndex s = 0; s < state_count; ++s)
+        {
+            order[s] = s;
+        }
+        std::stable_sort(order.begin(), order.end(), [&entry_count](StateIndex a, StateIndex b)
+                         { return entry_count(a) > entry_count(b); });
+
+        // One bit per slot, set once the slot is taken. A row is tested
+        // against 64 slots at a time, and candidate bases skip straight to
+        // the next free slot for the row's first class.
+        std::vector<uint64_t> used;
+        auto used_bits = [&used](size_t slot)
+        {
+            const size_t word = slot / 64;
+            const size_t shift = slot % 64;
+            uint64_t bits = word < used.size() ? used[word] >> shift : 0;
+            if (shift != 0 && word + 1 < used.size())
+            {
+                bits |= used[word + 1] << (64 - shift);
+            }
+            return bits;
+        };
+        auto next_free = [&used](size_t slot)
+        {
+            for (size_t word = slot / 64; word < used.size(); ++word)
+            {
+                uint64_t free = ~used[word];
+                if (word == slot / 64)
+                {
+                    free &= ~uint64_t{0} << (slot % 64);
+                }
+                if (free != 0)
+                {
+                    size_t bit = 0;
+                    while ((free >> bit & 1) == 0)
+                    {
+                        bit++;
+                    }
+                    return word * 64 + bit;
+                }
+            }
+            return std::max(slot, used.size() * 64);
+        };
+
+        std::vector<StateIndex> check(class_count_, DEAD_STATE);
+        std::vector<EdgeIndex> packed(class_count_, NO_EDGE);
+        used.assign((check.size() + 63) / 64, 0);
+        base_.assign(state_count, 0);
+        size_t first_free = 0;
+
+        for (StateIndex s : order)
+        {
+            if (entry_count(s) == 0)
+            {
+                continue;
+            }
+
+            const auto classes_begin = entry_classes.begin() + static_cast<std::ptrdiff_t>(entries_begin[s]);
+            const auto classes_end = entry_classes.begin() + static_cast<std::ptrdiff_t>(entries_begin[s + 1]);
+            const size_t front = *classes_begin;
+
+            std::array<uint64_t, 4> mask{};
+            for (auto it = classes_begin; it != classes_end; ++it)
+            {
+                mask[*it / 64] |= uint64_t{1} << (*it % 64);
+            }
+
+            size_t base = first_free > front ? first_free - front : 0;
+            for (;; ++base)
+            {
+                base = next_free(base + front) - front;
+
+                bool fits = true;
+                for (size_t w = 0; w < mask.size() && fits; ++w)
+                {
+                    fits = (mask[w] & used_bits(base + w * 64)) == 0;
+                }
+                if (fits)
+                {
+                    break;
+                }
+            }
+
+            // Every row must be probe-able for all classes.
+            if (base + class_count_ > check.size())
+            {
+                check.resize(base + class_count_, DEAD_STATE);
+                packed.resize(base + class_count_, NO_EDGE);
+                used.resize((check.size() + 63) / 64, 0);
+            }
+
+            for (size_t i = entries_begin[s]; i < entries_begin[s + 1]; ++i)
+            {
+                const size_t slot = base + entry_classes[i];
+                check[slot] = s;
+                packed[slot] = entry_edges[i];
+                used[slot / 64] |= uint64_t{1} << (slot % 64);
+            }
+            base_[s] = static_cast<uint32_t>(base);
+
+            first_free = next_free(first_free);
+        }
+
+        layout_ = TableLayout::COMB;
+        edges = std::move(packed);
+        edges.insert(edges.end(), defaults.begin(), defaults.end());
+        return check;
+    }
+
+    void CompiledFSM::narrowTable(const std::vector<StateIndex> &cells, const std::vector<StateIndex> &check)
+    {
+        // Every state index plus the dead cell must fit.
+        auto narrow = [](const std::vector<StateIndex> &wide, auto &out)
+        {
+            using Cell = typename std::decay_t<decltype(out)>::value_type;
+            out.resize(wide.size());
+            std::transform(wide.begin(), wide.end(), out.begin(), [](StateIndex index)
+                           { return index == DEAD_STATE ? DEAD_CELL<Cell> : static_cast<Cell>(index); });
+        };
+
+        switch (cellBytes(state_ids_.size()))
+        {
+        case 1:
+            width_ = TableWidth::BITS_8;
+            narrow(cells, table8_.cells);
+            narrow(check, table8_.check);
+            break;
+        case 2:
+            width_ = TableWidth::BITS_16;
+            narrow(cells, table16_.cells);
+            narrow(check, table16_.check);
+            break;
+        default:
+            width_ = TableWidth::BITS_32;
+            table32_.cells = cells;
+            table32_.check = check;
+            break;
+        }
+    }
+
+    void CompiledFSM::narrowEdges(const std::vector<EdgeIndex> &edges)
+    {
+        auto narrow = [&edges](auto &out)
+        {
+            using Edge = typename std::decay_t<decltype(out)>::value_type;
+            out.resize(edges.size());
+            std::transform(edges.begin(), edges.end(), out.begin(), [](EdgeIndex edge)
+                           { return edge == NO_EDGE ? DEAD_CELL<Edge> : static_cast<Edge>(edge); });
+        };
+
+        slot_count_ = edges.size();
+        switch (cellBytes(transitions_.size()))
+        {
+        case 1:
+            edge_width_ = TableWidth::BITS_8;
+            narrow(edges8_);
+            break;
+        case 2:
+            edge_width_ = TableWidth::BITS_16;
+            narrow(edges16_);
+            break;
+        default:
+            edge_width_ = TableWidth::BITS_32;
+            edges32_ = edges;
+            break;
+        }
+    }
+
+    // ============================================================================
+    // CompiledFSM Introspection
+    // ============================================================================
+
+    CompiledFSM::StateIndex CompiledFSM::indexOf(StateID id) const
+    {
+        auto it = index_of_.find(id);
+        return it == index_of_.end() ? DEAD_STATE : it->second;
+    }
+
+    size_t CompiledFSM::getTableBytes() const
+    {
+        // Comb tables add a check cell per packed slot and a base per state.
+        // Every slot also keeps its edge, and its action once any exists.
+        const size_t check_cells = layout_ == TableLayout::COMB ? slot_count_ - state_ids_.size() : 0;
+        return class_map_.size() + (slot_count_ + check_cells) * static_cast<size_t>(width_) +
+               base_.size() * sizeof(uint32_t) + slot_count_ * static_cast<size_t>(edge_width_) +
+               actions_.size() * sizeof(Transition::ActionID) + action_states_.size();
+    }
+
+    std::string CompiledFSM::toString() const
+    {
+        std::ostringstream oss;
+        oss << "CompiledFSM{name=" << name_
+            << ", states=" << getStateCount()
+            << ", classes=" << class_count_
+            << ", cell_bits=" << static_cast<int>(width_) * 8
+            << ", layout=" << (layout_ == TableLayout::COMB ? "comb" : "dense")
+            << ", table_bytes=" << getTableBytes()
+            << "}";
+        return oss.str();
+    }
+
+} // namespace fsm
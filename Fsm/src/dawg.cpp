@@ -0,0 +1,417 @@
+#include <fsm/dawg.hpp>
+#include <algorithm>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace fsm
+{
+    namespace
+    {
+        constexpr char DAWG_MAGIC[8] = {'F', 'S', 'M', 'D', 'A', 'W', 'G', '\0'};
+    }
+
+    // ============================================================================
+    // Dawg::Builder - Incremental Minimization
+    // ============================================================================
+    //
+    // Because words arrive sorted, once a word diverges from its predecessor
+    // the predecessor's path below the shared prefix can never change again.
+    // Those nodes are minimized bottom-up right away: each one is looked up
+    // in the register by its (accepting, edges) signature and replaced by an
+    // equal node if one exists, so the builder holds the minimal automaton
+    // plus one unminimized path.
+
+    Dawg::Builder::Builder()
+    {
+        nodes_.emplace_back();
+    }
+
+    uint32_t Dawg::Builder::newNode()
+    {
+        if (!free_nodes_.empty())
+        {
+            const uint32_t id = free_nodes_.back();
+            free_nodes_.pop_back();
+            return id;
+        }
+        nodes_.emplace_back();
+        return static_cast<uint32_t>(nodes_.size() - 1);
+    }
+
+    Dawg::Builder &Dawg::Builder::add(std::string_view word)
+    {
+        if (started_ && word <= previous_)
+        {
+            throw std::invalid_argument("Dawg::Builder: '" + std::string(word) + "' is not after '" + previous_ +
+                                        "'; words must be sorted and unique");
+        }
+
+        size_t prefix = 0;
+        while (prefix < word.size() && prefix < previous_.size() && word[prefix] == previous_[prefix])
+        {
+            ++prefix;
+        }
+
+        minimize(prefix);
+
+        uint32_t node = unchecked_.empty() ? 0 : unchecked_.back().child;
+        for (size_t i = prefix; i < word.size(); ++i)
+        {
+            const uint32_t child = newNode();
+            nodes_[node].edges.emplace_back(static_cast<uint8_t>(word[i]), child);
+            unchecked_.push_back({node, child});
+            node = child;
+        }
+        nodes_[node].accepting = true;
+
+        previous_.assign(word.data(), word.size());
+        started_ = true;
+        ++word_count_;
+        return *this;
+    }
+
+    void Dawg::Builder::minimize(size_t depth)
+    {
+        std::string signature;
+        while (unchecked_.size() > depth)
+        {
+            const Pending pending = unchecked_.back();
+            unchecked_.pop_back();
+
+            Node &child = nodes_[pending.child];
+            signature.assign(1, child.accepting ? '\1' : '\0');
+            for (const auto &[label, target] : child.edges)
+            {
+                signature.push_back(static_cast<char>(label));
+                signature.append(reinterpret_cast<const char *>(&target), sizeof(target));
+            }
+
+            auto [it, inserted] = register_.emplace(signature, pending.child);
+            if (!inserted)
+            {
+                nodes_[pending.parent].edges.back().second = it->second;
+                child = Node{};
+                free_nodes_.push_back(pending.child);
+            }
+        }
+    }
+
+    Dawg Dawg::Builder::build()
+    {
+        minimize(0);
+
+        // Number the reachable nodes breadth-first from the root; each takes
+        // one count cell plus one cell per edge.
+        std::vector<uint32_t> offsets(nodes_.size(), UINT32_MAX);
+        std::vector<uint32_t> order{0};
+        offsets[0] = 0;
+        size_t cell_count = 1 + nodes_[0].edges.size();
+
+        for (size_t head = 0; head < order.size(); ++head)
+        {
+            for (const auto &[label, target] : nodes_[order[head]].edges)
+            {
+                if (offsets[target] == UINT32_MAX)
+                {
+                    offsets[target] = static_cast<uint32_t>(cell_count);
+                    cell_count += 1 + nodes_[target].edges.size();
+                    order.push_back(target);
+                }
+            }
+
+            if (cell_count > MAX_CELLS)
+            {
+                throw std::length_error("Dawg: the automaton needs more than " + std::to_string(MAX_CELLS) +
+                                        " cells");
+            }
+        }
+
+        Dawg dawg;
+        dawg.owned_.resize(cell_count);
+        for (uint32_t id : order)
+        {
+            Cell *out = dawg.owned_.data() + offsets[id];
+            *out++ = static_cast<Cell>(nodes_[id].edges.size());
+            for (const auto &[label, target] : nodes_[id].edges)
+            {
+                *out++ = (Cell{label} << LABEL_SHIFT) | (nodes_[target].accepting ? ACCEPTS_BIT : 0) | offsets[target];
+            }
+        }
+
+        dawg.cells_ = dawg.owned_.data();
+        dawg.cell_count_ = cell_count;
+        dawg.state_count_ = order.size();
+        dawg.word_count_ = word_count_;
+        dawg.root_accepts_ = nodes_[0].accepting;
+
+        *this = Builder();
+        return dawg;
+    }
+
+    // ============================================================================
+    // Dawg Copying
+    // ============================================================================
+    //
+    // cells_ points either into owned_ or at borrowed memory; copies and
+    // moves keep it pointing at the right one.
+
+    Dawg::Dawg(const Dawg &other)
+        : owned_(other.owned_),
+          cells_(owned_.empty() ? other.cells_ : owned_.data()),
+          cell_count_(other.cell_count_),
+          state_count_(other.state_count_),
+          word_count_(other.word_count_),
+          root_accepts_(other.root_accepts_)
+    {
+    }
+
+    Dawg::Dawg(Dawg &&other) noexcept
+        : owned_(std::move(other.owned_)),
+          cells_(other.cells_),
+          cell_count_(other.cell_count_),
+          state_count_(other.state_count_),
+          word_count_(other.word_count_),
+          root_accepts_(other.root_accepts_)
+    {
+        other.owned_.clear();
+        other.cells_ = nullptr;
+        other.cell_count_ = 0;
+        other.state_count_ = 0;
+        other.word_count_ = 0;
+        other.root_accepts_ = false;
+    }
+
+    Dawg &Dawg::operator=(Dawg other) noexcept
+    {
+        std::swap(owned_, other.owned_);
+        std::swap(cells_, other.cells_);
+        std::swap(cell_count_, other.cell_count_);
+        std::swap(state_count_, other.state_count_);
+        std::swap(word_count_, other.word_count_);
+        std::swap(root_accepts_, other.root_accepts_);
+        return *this;
+    }
+
+    // ============================================================================
+    // Dawg Serialization
+    // ============================================================================
+
+    Dawg Dawg::view(const void *data, size_t size)
+    {
+        if (!data || reinterpret_cast<uintptr_t>(data) % alignof(Cell) != 0)
+        {
+            throw std::invalid_argument("Dawg::view: data must be non-null and 4-byte aligned");
+        }
+        if (size < sizeof(Header))
+        {
+            throw std::invalid_argument("Dawg::view: buffer is smaller than the header");
+        }
+
+        Header header;
+        std::memcpy(&header, data, sizeof(header));
+        if (size != sizeof(Header) + static_cast<size_t>(header.cell_count) * sizeof(Cell))
+        {
+            throw std::invalid_argument("Dawg::view: buffer size does not match the header");
+        }
+
+        Dawg dawg;
+        dawg.attach(header, reinterpret_cast<const Cell *>(static_cast<const char *>(data) + sizeof(Header)));
+        return dawg;
+    }
+
+    Dawg Dawg::load(std::istream &in)
+    {
+        Header header;
+        if (!in.read(reinterpret_cast<char *>(&header), sizeof(header)))
+        {
+            throw std::invalid_argument("Dawg::load: truncated header");
+        }
+
+        Dawg dawg;
+        if (header.cell_count <= MAX_CELLS)
+        {
+            dawg.owned_.resize(header.cell_count);
+            if (!in.read(reinterpret_cast<char *>(dawg.owned_.data()),
+                         static_cast<std::streamsize>(dawg.owned_.size() * sizeof(Cell))))
+            {
+                throw std::invalid_argument("Dawg::load: truncated cells");
+            }
+        }
+        dawg.attach(header, dawg.owned_.data());
+        return dawg;
+    }
+
+    void Dawg::save(std::ostream &out) const
+    {
+        Header header{};
+        std::memcpy(header.magic, DAWG_MAGIC, sizeof(DAWG_MAGIC));
+        header.version = FORMAT_VERSION;
+        header.byte_order = BYTE_ORDER_MARK;
+        header.cell_count = static_cast<uint32_t>(cell_count_);
+        header.state_count = static_cast<uint32_t>(state_count_);
+        header.word_count = static_cast<uint32_t>(word_count_);
+        header.root_accepts = root_accepts_ ? 1 : 0;
+
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char *>(cells_), static_cast<std::streamsize>(cell_count_ * sizeof(Cell)));
+    }
+
+    std::ostream &operator<<(std::ostream &out, const Dawg &dawg)
+    {
+        dawg.save(out);
+        return out;
+    }
+
+    // Bytes from disk are checked once so validate() can trust them: every
+    // state fits, labels ascend, targets are states and there is no cycle.
+    void Dawg::attach(const Header &header, const Cell *cells)
+    {
+        auto reject = [](const char *reason)
+        { throw std::invalid_argument(std::string("Dawg: invalid data: ") + reason); };
+
+        if (std::memcmp(header.magic, DAWG_MAGIC, sizeof(DAWG_MAGIC)) != 0)
+        {
+            reject("bad magic");
+        }
+        if (header.byte_order != BYTE_ORDER_MARK)
+        {
+            reject("written with the other byte order");
+        }
+        if (header.version != FORMAT_VERSION)
+        {
+            reject("unsupported version");
+        }
+        if (header.cell_count == 0 || header.cell_count > MAX_CELLS)
+        {
+            reject("cell count out of range");
+        }
+
+        const size_t cell_count = header.cell_count;
+        std::vector<uint32_t> incoming(cell_count, 0);
+        std::vector<uint8_t> is_state(cell_count, 0);
+        size_t state_count = 0;
+
+        for (size_t state = 0; state < cell_count; state += 1 + cells[state])
+        {
+            if (cells[state] > 256 || state + 1 + cells[state] > cell_count)
+            {
+                reject("state overruns the cells");
+            }
+            is_state[state] = 1;
+            ++state_count;
+        }
+
+        for (size_t state = 0; state < cell_count; state += 1 + cells[state])
+        {
+            for (size_t i = 1; i <= cells[state]; ++i)
+            {
+                const Cell edge = cells[state + i];
+                if (i > 1 && (cells[state + i - 1] >> LABEL_SHIFT) >= (edge >> LABEL_SHIFT))
+                {
+                    reject("edge labels out of order");
+                }
+                if ((edge & TARGET_MASK) >= cell_count || !is_state[edge & TARGET_MASK])
+                {
+                    reject("edge target is not a state");
+                }
+                ++incoming[edge & TARGET_MASK];
+            }
+        }
+
+        if (state_count != header.state_count)
+        {
+            reject("state count does not match the header");
+        }
+
+        // Kahn's algorithm: every state must come off the queue.
+        std::vector<uint32_t> ready;
+        for (size_t state = 0; state < cell_count; ++state)
+        {
+            if (is_state[state] && incoming[state] == 0)
+            {
+                ready.push_back(static_cast<uint32_t>(state));
+            }
+        }
+
+        size_t visited = 0;
+        while (!ready.empty())
+        {
+            const uint32_t state = ready.back();
+            ready.pop_back();
+            ++visited;
+            for (size_t i = 1; i <= cells[state]; ++i)
+            {
+                const Cell target = cells[state + i] & TARGET_MASK;
+                if (--incoming[target] == 0)
+                {
+                    ready.push_back(target);
+                }
+            }
+        }
+
+        if (visited != state_count)
+        {
+            reject("the automaton has a cycle");
+        }
+
+        cells_ = cells;
+        cell_count_ = cell_count;
+        state_count_ = state_count;
+        word_count_ = header.word_count;
+        root_accepts_ = header.root_accepts != 0;
+    }
+
+    // ============================================================================
+    // Dawg Queries
+    // ============================================================================
+
+    size_t Dawg::getBytes() const
+    {
+        return sizeof(Header) + cell_count_ * sizeof(Cell);
+    }
+
+    void Dawg::collectWords(Cell state, std::string &prefix, std::vector<std::string> &out) const
+    {
+        for (size_t i = 1; i <= cells_[state]; ++i)
+        {
+            const Cell edge = cells_[state + i];
+            prefix.push_back(static_cast<char>(edge >> LABEL_SHIFT));
+            if (edge & ACCEPTS_BIT)
+            {
+                out.push_back(prefix);
+            }
+            collectWords(edge & TARGET_MASK, prefix, out);
+            prefix.pop_back();
+        }
+    }
+
+    std::vector<std::string> Dawg::getWords() const
+    {
+        std::vector<std::string> words;
+        if (cell_count_ == 0)
+        {
+            return words;
+        }
+
+        words.reserve(word_count_);
+        if (root_accepts_)
+        {
+            words.emplace_back();
+        }
+        std::string prefix;
+        collectWords(0, prefix, words);
+        return words;
+    }
+
+    std::string Dawg::toString() const
+    {
+        std::ostringstream oss;
+        oss << "Dawg(" << word_count_ << " words, " << state_count_ << " states, " << getEdgeCount() << " edges, "
+            << getBytes() << " bytes" << (isView() ? ", view" : "") << ")";
+        return oss.str();
+    }
+
+} // namespace fsm
@@ -0,0 +1,210 @@
+#include <fsm/events.hpp>
+#include <stdexcept>
+
+namespace fsm
+{
+
+    // ============================================================================
+    // EventRing Implementation
+    // ============================================================================
+
+    EventRing::EventRing(Event *storage, size_t capacity)
+        : storage_(storage), mask_(capacity - 1)
+    {
+        if (storage == nullptr || capacity == 0 || (capacity & (capacity - 1)) != 0)
+        {
+            throw std::invalid_argument("EventRing capacity must be a non-zero power of two");
+        }
+    }
+
+    bool EventRing::pop(Event &event) noexcept
+    {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        event = storage_[head & mask_];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool EventRing::push(const Event &event) noexcept
+    {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) == capacity())
+        {
+            return false;
+        }
+
+        storage_[tail & mask_] = event;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t EventRing::size() const noexcept
+    {
+        const size_t head = head_.load(std::memory_order_acquire);
+        return tail_.load(std::memory_order_acquire) - head;
+    }
+
+    // ============================================================================
+    // EventScanner Implementation
+    // ============================================================================
+
+    EventScanner::EventScanner(const FSM &fsm, EventMode mode)
+        : EventScanner(std::make_shared<const CompiledFSM>(fsm), mode)
+    {
+    }
+
+    EventScanner::EventScanner(std::shared_ptr<const CompiledFSM> compiled, EventMode mode)
+        : compiled_(std::move(compiled)), mode_(mode)
+    {
+        reset();
+    }
+
+    void EventScanner::reset()
+    {
+        state_ = compiled_->getStartState();
+        position_ = 0;
+        rejected_ = (state_ == CompiledFSM::DEAD_STATE);
+    }
+
+    ScanResult EventScanner::scan(std::string_view chunk, EventRing &ring)
+    {
+        if (rejected_)
+        {
+            return ScanResult{ScanStatus::REJECTED, 0};
+        }
+
+        return compiled_->withTable(
+            [&](const auto &table)
+            {
+                return mode_ == EventMode::ACTIONS ? scanImpl<EventMode::ACTIONS>(table, chunk, ring)
+                                                   : scanImpl<EventMode::TRANSITIONS>(table, chunk, ring);
+            });
+    }
+
+    template <EventMode MODE, typename View>
+    ScanResult EventScanner::scanImpl(const View &table, std::string_view chunk, EventRing &ring)
+    {
+        using Cell = typename View::Cell;
+
+        const CompiledFSM &compiled = *compiled_;
+        const uint8_t *classes = compiled.getClassMap();
+        const bool has_actions = compiled.hasActions();
+        const Transition::ActionID *actions = compiled.getActions();
+        const uint8_t *action_states = compiled.getActionStates();
+        const Transition::TransitionID *transition_ids = compiled.getTransitionIDs();
+
+        // Events are written with a private tail and published once per call.
+        const size_t capacity = ring.capacity();
+        size_t tail = ring.tail_.load(std::memory_order_relaxed);
+        size_t head = ring.head_.load(std::memory_order_acquire);
+
+        StateIndex state = state_;
+        ScanStatus status = ScanStatus::CHUNK_CONSUMED;
+        size_t i = 0;
+
+        for (; i < chunk.size(); ++i)
+        {
+            const size_t cell = table.slot(state, classes[static_cast<unsigned char>(chunk[i])]);
+            const Cell next = table.cells[cell];
+
+            if (next == CompiledFSM::DEAD_CELL<Cell>)
+            {
+                rejected_ = true;
+                status = ScanStatus::REJECTED;
+                break;
+            }
+
+            bool emit;
+            uint32_t id;
+            if constexpr (MODE == EventMode::ACTIONS)
+            {
+                emit = has_actions && action_states[state] && actions[cell] != Transition::NO_ACTION;
+                id = emit ? actions[cell] : 0;
+            }
+            else
+            {
+                emit = true;
+                id = transition_ids[compiled.edgeAt(cell)];
+            }
+
+            if (emit)
+            {
+                if (tail - head == capacity)
+                {
+                    head = ring.head_.load(std::memory_order_acquire);
+                    if (tail - head == capacity)
+                    {
+                        status = ScanStatus::BUFFER_FULL;
+                        break;
+                    }
+                }
+
+                ring.storage_[tail & ring.mask_] = Event{position_ + i, id, next};
+                ++tail;
+            }
+
+            state = next;
+        }
+
+        ring.tail_.store(tail, std::memory_order_release);
+        state_ = state;
+        position_ += i;
+
+        return ScanResult{status, i};
+    }
+
+    ScanResult EventScanner::finish(EventRing &ring)
+    {
+        if (rejected_)
+        {
+            return ScanResult{ScanStatus::REJECTED, 0};
+        }
+
+        const CompiledFSM &compiled = *compiled_;
+        const auto &chain = compiled.getEpsilonChain(state_);
+
+        size_t needed = 0;
+        for (CompiledFSM::EdgeIndex edge : chain)
+        {
+            if (mode_ == EventMode::TRANSITIONS ||
+                compiled.getTransition(edge).action != Transition::NO_ACTION)
+            {
+                needed++;
+            }
+        }
+
+        if (ring.capacity() - ring.size() < needed)
+        {
+            return ScanResult{ScanStatus::BUFFER_FULL, 0};
+        }
+
+        for (CompiledFSM::EdgeIndex edge : chain)
+        {
+            const Transition &trans = compiled.getTransition(edge);
+            state_ = compiled.getTarget(edge);
+
+            if (mode_ == EventMode::TRANSITIONS)
+            {
+                ring.push(Event{position_, trans.id, state_});
+            }
+            else if (trans.action != Transition::NO_ACTION)
+            {
+                ring.push(Event{position_, trans.action, state_});
+            }
+        }
+
+        if (!compiled.isAcceptState(state_))
+        {
+            rejected_ = true;
+            return ScanResult{ScanStatus::REJECTED, 0};
+        }
+
+        return ScanResult{ScanStatus::ACCEPTED, 0};
+    }
+
+} // namespace fsm
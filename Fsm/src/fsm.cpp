@@ -1,13 +1,20 @@
 #include <fsm/fsm.hpp>
+#include <fsm/instrumentation.hpp>
+#include <fsm/keywords.hpp>
+#include <fsm/matcher.hpp>
+#include <fsm/memory.hpp>
+#include <fsm/tracing.hpp>
 #include <algorithm>
+#include <bitset>
 #include <fstream>
 #include <iomanip>
+#include <map>
+#include <new>
 #include <sstream>
 #include <stdexcept>
 
 namespace fsm
 {
-
     // ============================================================================
     // State Implementation
     // ============================================================================
@@ -80,6 +87,11 @@ namespace fsm
             << ", type=" << typeToString()
             << ", priority=" << priority;
 
+        if (action != NO_ACTION)
+        {
+            oss << ", action=" << action;
+        }
+
         if (!description.empty())
         {
             oss << ", desc=\"" << description << "\"";
@@ -89,9 +101,9 @@ namespace fsm
         {
             oss << ", rule=" << rule->toString();
         }
-        else if (type == TransitionType::FSM_INSTANCE && embedded_fsm)
+        else if (type == TransitionType::FSM_INSTANCE)
         {
-            oss << ", fsm=" << embedded_fsm->getName();
+            oss << ", fsm=" << (embedded_fsm ? embedded_fsm->getName() : "<self>");
         }
 
         oss << "}";
@@ -120,38 +132,7 @@ namespace fsm
     std::string FSM::ValidationError::toString() const
     {
         std::ostringstream oss;
-        oss << "ValidationError{";
-
-        switch (type)
-        {
-        case ErrorType::NO_MATCHING_TRANSITION:
-            oss << "NO_MATCHING_TRANSITION";
-            break;
-        case ErrorType::UNEXPECTED_END_OF_INPUT:
-            oss << "UNEXPECTED_END_OF_INPUT";
-            break;
-        case ErrorType::NOT_IN_ACCEPT_STATE:
-            oss << "NOT_IN_ACCEPT_STATE";
-            break;
-        case ErrorType::EMBEDDED_FSM_FAILED:
-            oss << "EMBEDDED_FSM_FAILED";
-            break;
-        case ErrorType::INVALID_STATE:
-            oss << "INVALID_STATE";
-            break;
-        case ErrorType::INVALID_TRANSITION:
-            oss << "INVALID_TRANSITION";
-            break;
-        case ErrorType::AMBIGUOUS_TRANSITION:
-            oss << "AMBIGUOUS_TRANSITION";
-            break;
-        case ErrorType::NO_START_STATE:
-            oss << "NO_START_STATE";
-            break;
-        case ErrorType::UNREACHABLE_STATES:
-            oss << "UNREACHABLE_STATES";
-            break;
-        }
+        oss << "ValidationError{" << errorTypeToString(type);
 
         oss << ", position=" << position
             << ", character='" << character << "' (0x" << std::hex
@@ -199,6 +180,7 @@ namespace fsm
         epsilon_transitions = 0;
         validation_time_ns = 0;
         processing_time = std::chrono::microseconds{0};
+        allocations = 0;
     }
 
     std::string FSM::Metrics::toString() const
@@ -211,6 +193,7 @@ namespace fsm
             << ", epsilons=" << epsilon_transitions
             << ", validation_time=" << validation_time_ns << "ns"
             << ", processing_time=" << processing_time.count() << "μs"
+            << ", allocations=" << allocations
             << "}";
         return oss.str();
     }
@@ -235,6 +218,12 @@ namespace fsm
     // FSM Constructors
     // ============================================================================
 
+    FSM::RunBuffers::RunBuffers(std::pmr::memory_resource *resource)
+        : current_input(resource), epsilon_visited(resource), trace(resource),
+          capture_names(resource), capture_slots(resource), captures(resource),
+          active_captures(resource), choice_stack(resource), valid_transitions(resource),
+          call_stack(resource), pushdown_chain(resource) {}
+
     FSM::FSM()
         : id_(0), name_("FSM_0"), start_state_(0), current_state_(0),
           next_state_id_(1), next_transition_id_(1) {}
@@ -313,6 +302,7 @@ namespace fsm
         start_state_ = state;
         current_state_ = state;
         states_[state].type = StateType::START;
+        transition_map_dirty_ = true; // reachability depends on the start state
     }
 
     StateID FSM::getStartState() const
@@ -327,6 +317,7 @@ namespace fsm
             throw std::invalid_argument("Cannot add non-existent state as accept state");
         }
         accept_states_.insert(state);
+        transition_map_dirty_ = true; // dead states and accept sinks depend on it
 
         if (states_[state].type != StateType::START)
         {
@@ -337,6 +328,7 @@ namespace fsm
     void FSM::removeAcceptState(StateID state)
     {
         accept_states_.erase(state);
+        transition_map_dirty_ = true;
     }
 
     bool FSM::isAcceptState(StateID state) const
@@ -429,15 +421,51 @@ namespace fsm
             throw std::invalid_argument("Cannot merge FSM with non-existent states");
         }
 
-        auto result = mergeStatesAndTransitions(from, to, *embedded_fsm);
+        auto result = mergeStatesAndTransitions(from, to, embedded_fsm);
         return result.new_transitions;
     }
 
+    Transition::TransitionID FSM::addSubMachineTransition(StateID from, StateID to,
+                                                          std::shared_ptr<FSM> sub_machine,
+                                                          int priority)
+    {
+        if (!sub_machine)
+        {
+            throw std::invalid_argument("Cannot call null FSM");
+        }
+
+        if (!hasState(from) || !hasState(to))
+        {
+            throw std::invalid_argument("Cannot add sub-machine transition with non-existent states");
+        }
+
+        Transition trans(next_transition_id_++, from, to, std::move(sub_machine), priority);
+        transitions_.push_back(trans);
+        transition_map_dirty_ = true;
+
+        return trans.id;
+    }
+
+    Transition::TransitionID FSM::addRecursiveTransition(StateID from, StateID to, int priority)
+    {
+        if (!hasState(from) || !hasState(to))
+        {
+            throw std::invalid_argument("Cannot add recursive transition with non-existent states");
+        }
+
+        Transition trans(next_transition_id_++, from, to, std::shared_ptr<FSM>(), priority);
+        transitions_.push_back(trans);
+        transition_map_dirty_ = true;
+
+        return trans.id;
+    }
+
     FSM::MergeResult FSM::mergeStatesAndTransitions(
         StateID from_state,
         StateID to_state,
-        const FSM &embedded)
+        const std::shared_ptr<FSM> &embedded_ptr)
     {
+        const FSM &embedded = *embedded_ptr;
         MergeResult result;
 
         result.state_mapping[embedded.start_state_] = from_state;
@@ -491,6 +519,13 @@ namespace fsm
                     result.new_transitions.insert(result.new_transitions.end(),
                                                   nested_ids.begin(), nested_ids.end());
                 }
+                else
+                {
+                    // A recursive call cannot be inlined; it keeps calling the
+                    // embedded machine it belonged to.
+                    result.new_transitions.push_back(
+                        addSubMachineTransition(mapped_from, mapped_to, embedded_ptr, trans.priority));
+                }
                 break;
             }
 
@@ -510,28 +545,192 @@ namespace fsm
     // ============================================================================
 
     bool FSM::validate(std::string_view input)
+    {
+        const bool counted = allocation_counter_ && debug_config_.hasCollectMetrics();
+        const uint64_t allocations_before = counted ? allocation_counter_->getAllocations() : 0;
+
+        const Engine engine = engineForRun();
+
+        // AUTO only picks the interpreter for callbacks. It then reads the
+        // input whatever its length, so they fire as they would without the
+        // length check.
+        const bool callbacks = engine == Engine::INTERPRETER && selected_engine_ == Engine::INTERPRETER;
+
+        bool accepted;
+        if (!length_bounds_.admits(input.size()) && !callbacks)
+        {
+            accepted = rejectLength(input);
+        }
+        else
+        {
+            switch (engine)
+            {
+            case Engine::TABLE:
+                accepted = validateTable(input);
+                break;
+            case Engine::KEYWORDS:
+                accepted = validateKeywords(input);
+                break;
+            case Engine::BACKTRACKING:
+                accepted = validateWithBacktracking(input);
+                break;
+            case Engine::PUSHDOWN:
+                accepted = validatePushdown(input);
+                break;
+            default:
+                accepted = validateInput(input);
+                break;
+            }
+        }
+
+        if (counted)
+        {
+            metrics_.allocations = allocation_counter_->getAllocations() - allocations_before;
+        }
+
+        if (metrics_shard_)
+        {
+            recordOutcome(input.size(), accepted);
+        }
+
+        return accepted;
+    }
+
+    bool FSM::rejectLength(std::string_view input)
+    {
+        reset();
+        has_error_ = false;
+
+        // Too long fails at the first byte no accepted input has; too short
+        // fails at the end. Only the bytes the error context shows are kept.
+        const size_t position = std::min(input.size(), length_bounds_.max);
+        run_->current_input.assign(input.data(), std::min(input.size(), position + 10));
+        clearCaptures();
+        current_input_position_ = position;
+        fail(ErrorType::LENGTH_OUT_OF_RANGE, ErrorSite::VALIDATE, position,
+             position < input.size() ? input[position] : '\0', current_state_.id);
+        return false;
+    }
+
+    bool FSM::validateTable(std::string_view input)
+    {
+        reset();
+        has_error_ = false;
+
+        run_->current_input.assign(input.data(), input.size());
+        clearCaptures();
+        current_input_position_ = 0;
+
+        if (!unresolved_.empty())
+        {
+            const Ambiguity &ambiguity = unresolved_.front();
+            fail(ErrorType::AMBIGUOUS_TRANSITION, ErrorSite::VALIDATE, 0, '\0', ambiguity.state.id, nullptr,
+                 ambiguity.second);
+            return false;
+        }
+
+        if (!start_state_.isValid())
+        {
+            fail(ErrorType::NO_START_STATE, ErrorSite::VALIDATE, 0, '\0', current_state_.id);
+            return false;
+        }
+
+        if (!table_matcher_)
+        {
+            table_matcher_ = std::make_shared<Matcher<ProductionPolicy>>(*this);
+        }
+
+        Matcher<ProductionPolicy> &matcher = *table_matcher_;
+        const bool accepted = matcher.validate(input);
+
+        if (matcher.getCurrentIndex() != CompiledFSM::DEAD_STATE)
+        {
+            current_state_ = matcher.getCompiled().getStateID(matcher.getCurrentIndex());
+        }
+
+        if (accepted)
+        {
+            current_input_position_ = input.size();
+            return true;
+        }
+
+        switch (matcher.getErrorType())
+        {
+        case ErrorType::NO_MATCHING_TRANSITION:
+        {
+            // The table folds a missing edge and an edge into a dead state
+            // into one reject; replaying the byte here tells them apart.
+            const size_t position = matcher.getErrorPosition();
+            current_input_position_ = position;
+            if (processCharImpl(input[position], position))
+            {
+                fail(ErrorType::NO_MATCHING_TRANSITION, ErrorSite::VALIDATE, position, input[position],
+                     current_state_.id);
+            }
+            return false;
+        }
+        case ErrorType::NO_START_STATE:
+            fail(ErrorType::NO_START_STATE, ErrorSite::VALIDATE, 0, '\0', current_state_.id);
+            return false;
+        default:
+            current_input_position_ = input.size();
+            fail(ErrorType::NOT_IN_ACCEPT_STATE, ErrorSite::VALIDATE, input.size(), '\0', current_state_.id);
+            return false;
+        }
+    }
+
+    bool FSM::validateKeywords(std::string_view input)
+    {
+        // Only a language small enough to list compiles to a keyword set;
+        // anything else, and every miss, goes through the table, which also
+        // reports the error where the interpreter would.
+        if (!keywords_)
+        {
+            if (!unresolved_.empty() || !start_state_.isValid() || length_bounds_.count > KEYWORD_ENGINE_LIMIT ||
+                length_bounds_.max > KeywordSet::MAX_LENGTH)
+            {
+                return validateTable(input);
+            }
+            keywords_ = std::make_shared<KeywordSet>(*this, KEYWORD_ENGINE_LIMIT);
+        }
+
+        const KeywordSet::KeywordID id = keywords_->find(input);
+        if (id == KeywordSet::NO_KEYWORD)
+        {
+            return validateTable(input);
+        }
+
+        reset();
+        has_error_ = false;
+
+        run_->current_input.assign(input.data(), input.size());
+        clearCaptures();
+        current_input_position_ = input.size();
+        current_state_ = keywords_->getFinalState(id);
+        return true;
+    }
+
+    bool FSM::validateInput(std::string_view input)
     {
         reset();
-        last_error_.reset();
+        has_error_ = false;
 
-        current_input_ = std::string(input);
+        run_->current_input.assign(input.data(), input.size());
         clearCaptures();
         current_input_position_ = 0;
 
         rebuildTransitionMap();
 
-        auto start_time = std::chrono::high_resolution_clock::now();
+        const bool timed = debug_config_.hasCollectMetrics();
+        std::chrono::high_resolution_clock::time_point start_time;
+        if (timed)
+        {
+            start_time = std::chrono::high_resolution_clock::now();
+        }
 
         if (!start_state_.isValid())
         {
-            last_error_ = ValidationError{
-                ErrorType::NO_START_STATE,
-                0,
-                '\0',
-                current_state_,
-                "No start state defined",
-                {},
-                ""};
+            fail(ErrorType::NO_START_STATE, ErrorSite::VALIDATE, 0, '\0', current_state_.id);
             return false;
         }
 
@@ -551,7 +750,12 @@ namespace fsm
                 metrics_.characters_processed++;
             }
 
-            recordCharInCaptures(ch);
+            // Every suffix is accepted from here; the rest of the input cannot
+            // change the verdict.
+            if (accept_sink_reached_)
+            {
+                break;
+            }
         }
 
         updateCapturePosition(input.size());
@@ -560,22 +764,14 @@ namespace fsm
 
         if (!isInAcceptState())
         {
-            last_error_ = ValidationError{
-                ErrorType::NOT_IN_ACCEPT_STATE,
-                input.size(),
-                '\0',
-                current_state_,
-                "Input consumed but not in accept state.  Current state: " +
-                    current_state_.toString(),
-                {},
-                ""};
+            fail(ErrorType::NOT_IN_ACCEPT_STATE, ErrorSite::VALIDATE, input.size(), '\0',
+                 current_state_.id);
             return false;
         }
 
-        auto end_time = std::chrono::high_resolution_clock::now();
-
-        if (debug_config_.hasCollectMetrics())
+        if (timed)
         {
+            auto end_time = std::chrono::high_resolution_clock::now();
             metrics_.validation_time_ns =
                 std::chrono::duration_cast<std::chrono::nanoseconds>(
                     end_time - start_time)
@@ -590,18 +786,18 @@ namespace fsm
 
     bool FSM::isInAcceptState() const
     {
-        return isAcceptState(current_state_);
+        return accept_states_.find(current_state_) != accept_states_.end();
     }
 
     void FSM::reset()
     {
         current_state_ = start_state_;
-        last_error_.reset();
+        has_error_ = false;
 
-        if (debug_config_.hasTraceTransitions() || debug_config_.hasTraceStateChanges())
-        {
-            trace_.clear();
-        }
+        // Everything below is a constant number of stores: the trace is
+        // dropped on its next use, choice point slots and capture storage are
+        // kept for the next run.
+        trace_stale_ = true;
 
         if (debug_config_.hasCollectMetrics())
         {
@@ -609,16 +805,20 @@ namespace fsm
         }
 
         current_input_position_ = 0;
-        current_input_.clear();
+        run_->current_input.clear();
 
         stream_state_ = StreamState::READY;
         streaming_mode_ = false;
 
-        while (!choice_stack_.empty())
-        {
-            choice_stack_.pop();
-        }
+        accept_sink_reached_ = false;
+
+        choice_depth_ = 0;
         resetBacktrackingStats();
+
+        run_->call_stack.clear();
+
+        metrics_shard_ = metrics_registry_ ? &metrics_registry_->local() : nullptr;
+        trace_sampled_ = tracer_ && tracer_->sample(trace_validation_);
     }
 
     // ============================================================================
@@ -627,30 +827,45 @@ namespace fsm
 
     StreamState FSM::feed(char ch)
     {
+        if (stream_state_ == StreamState::ACCEPTED)
+        {
+            return stream_state_;
+        }
+
         if (!streaming_mode_)
         {
             streaming_mode_ = true;
             stream_state_ = StreamState::PROCESSING;
 
-            current_input_ += ch;
+            run_->current_input += ch;
 
             if (!start_state_.isValid())
             {
-                last_error_ = ValidationError{
-                    ErrorType::NO_START_STATE,
-                    current_input_position_,
-                    ch,
-                    current_state_,
-                    "No start state defined",
-                    {},
-                    ""};
+                fail(ErrorType::NO_START_STATE, ErrorSite::VALIDATE, current_input_position_, ch,
+                     current_state_.id);
                 stream_state_ = StreamState::ERROR;
+                if (metrics_shard_)
+                {
+                    recordOutcome(0, false);
+                }
                 return stream_state_;
             }
         }
         else
         {
-            current_input_ += ch;
+            run_->current_input += ch;
+        }
+
+        if (current_input_position_ >= length_bounds_.max && !length_bounds_.empty)
+        {
+            fail(ErrorType::LENGTH_OUT_OF_RANGE, ErrorSite::STREAM, current_input_position_, ch,
+                 current_state_.id);
+            stream_state_ = StreamState::ERROR;
+            if (metrics_shard_)
+            {
+                recordOutcome(current_input_position_, false);
+            }
+            return stream_state_;
         }
 
         updateCapturePosition(current_input_position_);
@@ -658,6 +873,10 @@ namespace fsm
         if (!processCharImpl(ch, current_input_position_))
         {
             stream_state_ = StreamState::ERROR;
+            if (metrics_shard_)
+            {
+                recordOutcome(current_input_position_, false);
+            }
             return stream_state_;
         }
 
@@ -666,13 +885,15 @@ namespace fsm
             metrics_.characters_processed++;
         }
 
-        recordCharInCaptures(ch);
-
         current_input_position_++;
 
         updateCapturePosition(current_input_position_);
 
-        if (isInAcceptState())
+        if (accept_sink_reached_)
+        {
+            stream_state_ = StreamState::ACCEPTED;
+        }
+        else if (isInAcceptState())
         {
             stream_state_ = StreamState::COMPLETE;
         }
@@ -690,7 +911,7 @@ namespace fsm
         {
             StreamState state = feed(ch);
 
-            if (state == StreamState::ERROR)
+            if (state == StreamState::ERROR || state == StreamState::ACCEPTED)
             {
                 return state;
             }
@@ -701,16 +922,10 @@ namespace fsm
 
     StreamState FSM::endOfStream()
     {
+        // Nothing was fed, so there is no run to count.
         if (!streaming_mode_)
         {
-            last_error_ = ValidationError{
-                ErrorType::UNEXPECTED_END_OF_INPUT,
-                0,
-                '\0',
-                current_state_,
-                "End of stream called before any input was fed",
-                {},
-                ""};
+            fail(ErrorType::UNEXPECTED_END_OF_INPUT, ErrorSite::VALIDATE, 0, '\0', current_state_.id);
             stream_state_ = StreamState::ERROR;
             return stream_state_;
         }
@@ -719,20 +934,21 @@ namespace fsm
 
         if (!isInAcceptState())
         {
-            last_error_ = ValidationError{
-                ErrorType::NOT_IN_ACCEPT_STATE,
-                current_input_position_,
-                '\0',
-                current_state_,
-                "End of stream but not in accept state.  Current state: " +
-                    current_state_.toString(),
-                {},
-                ""};
+            fail(ErrorType::NOT_IN_ACCEPT_STATE, ErrorSite::STREAM, current_input_position_, '\0',
+                 current_state_.id);
             stream_state_ = StreamState::ERROR;
+            if (metrics_shard_)
+            {
+                recordOutcome(current_input_position_, false);
+            }
             return stream_state_;
         }
 
         stream_state_ = StreamState::COMPLETE;
+        if (metrics_shard_)
+        {
+            recordOutcome(current_input_position_, true);
+        }
         return stream_state_;
     }
 
@@ -743,7 +959,7 @@ namespace fsm
 
     bool FSM::isStreamComplete() const
     {
-        return stream_state_ == StreamState::COMPLETE;
+        return stream_state_ == StreamState::COMPLETE || stream_state_ == StreamState::ACCEPTED;
     }
 
     bool FSM::needsMoreInput() const
@@ -771,6 +987,8 @@ namespace fsm
             return "COMPLETE";
         case StreamState::ERROR:
             return "ERROR";
+        case StreamState::ACCEPTED:
+            return "ACCEPTED";
         default:
             return "UNKNOWN";
         }
@@ -821,23 +1039,22 @@ namespace fsm
         return max_backtrack_depth_;
     }
 
-    std::vector<const Transition *> FSM::getValidTransitions(char ch)
+    const std::pmr::vector<const Transition *> &FSM::getValidTransitions(char ch)
     {
-        std::vector<const Transition *> valid;
-        auto transitions = getTransitionsFrom(current_state_);
+        run_->valid_transitions.clear();
 
-        for (const auto *trans : transitions)
+        for (const RuntimeEdge &edge : edgesFrom(current_state_.id))
         {
-            if (trans->type == TransitionType::ABNF_RULE && trans->matches(ch))
+            if (edge.type == TransitionType::ABNF_RULE && edgeMatches(edge, ch))
             {
-                valid.push_back(trans);
+                run_->valid_transitions.push_back(&transitions_[edge.transition]);
             }
         }
 
-        return valid;
+        return run_->valid_transitions;
     }
 
-    bool FSM::shouldCreateChoicePoint(const std::vector<const Transition *> &valid_transitions) const
+    bool FSM::shouldCreateChoicePoint(const std::pmr::vector<const Transition *> &valid_transitions) const
     {
         if (valid_transitions.size() <= 1)
         {
@@ -852,34 +1069,51 @@ namespace fsm
         return valid_transitions.size() > 1;
     }
 
-    void FSM::saveChoicePoint(const std::vector<const Transition *> &alternatives,
-                              size_t position)
+    void FSM::saveChoicePoint(const std::pmr::vector<const Transition *> &valid_transitions, size_t position)
     {
-        if (max_backtrack_depth_ > 0 && choice_stack_.size() >= max_backtrack_depth_)
+        if (max_backtrack_depth_ > 0 && choice_depth_ >= max_backtrack_depth_)
         {
             return;
         }
 
-        choice_stack_.emplace(
-            current_state_,
-            position,
-            alternatives,
-            captures_,
-            active_captures_,
-            current_input_position_);
+        // The first valid transition is taken now; the rest are alternatives.
+        if (choice_depth_ < run_->choice_stack.size())
+        {
+            ChoicePoint &cp = run_->choice_stack[choice_depth_];
+            cp.state = current_state_.id;
+            cp.position = position;
+            cp.remaining.assign(valid_transitions.begin() + 1, valid_transitions.end());
+            cp.captures_snapshot.assign(run_->captures.begin(), run_->captures.end());
+            cp.active_captures_snapshot.assign(run_->active_captures.begin(), run_->active_captures.end());
+            cp.input_position_snapshot = current_input_position_;
+        }
+        else
+        {
+            run_->choice_stack.emplace_back(
+                current_state_.id,
+                position,
+                std::pmr::vector<const Transition *>(valid_transitions.begin() + 1, valid_transitions.end(),
+                                                     memory_resource_),
+                run_->captures,
+                run_->active_captures,
+                current_input_position_,
+                memory_resource_);
+        }
+
+        choice_depth_++;
 
         backtracking_stats_.choice_points_created++;
-        if (choice_stack_.size() > backtracking_stats_.max_stack_depth)
+        if (choice_depth_ > backtracking_stats_.max_stack_depth)
         {
-            backtracking_stats_.max_stack_depth = choice_stack_.size();
+            backtracking_stats_.max_stack_depth = choice_depth_;
         }
     }
 
     bool FSM::backtrack()
     {
-        while (!choice_stack_.empty())
+        while (choice_depth_ > 0)
         {
-            ChoicePoint &cp = choice_stack_.top();
+            ChoicePoint &cp = topChoicePoint();
 
             if (!cp.remaining.empty())
             {
@@ -888,7 +1122,7 @@ namespace fsm
                 return true;
             }
 
-            choice_stack_.pop();
+            choice_depth_--;
         }
 
         return false;
@@ -896,9 +1130,10 @@ namespace fsm
 
     void FSM::restoreFromChoicePoint(const ChoicePoint &cp)
     {
-        current_state_ = cp.state;
-        captures_ = cp.captures_snapshot;
-        active_captures_ = cp.active_captures_snapshot;
+        current_state_ = states_.find(StateID(cp.state))->first;
+        run_->captures = cp.captures_snapshot;
+        run_->active_captures = cp.active_captures_snapshot;
+        stampCaptureSlots();
         current_input_position_ = cp.input_position_snapshot;
     }
 
@@ -906,14 +1141,9 @@ namespace fsm
     {
         reset();
         resetBacktrackingStats();
-        last_error_.reset();
-
-        while (!choice_stack_.empty())
-        {
-            choice_stack_.pop();
-        }
+        has_error_ = false;
 
-        current_input_ = std::string(input);
+        run_->current_input.assign(input.data(), input.size());
         clearCaptures();
         current_input_position_ = 0;
 
@@ -921,14 +1151,7 @@ namespace fsm
 
         if (!start_state_.isValid())
         {
-            last_error_ = ValidationError{
-                ErrorType::NO_START_STATE,
-                0,
-                '\0',
-                current_state_,
-                "No start state defined",
-                {},
-                ""};
+            fail(ErrorType::NO_START_STATE, ErrorSite::VALIDATE, 0, '\0', current_state_.id);
             return false;
         }
 
@@ -940,26 +1163,23 @@ namespace fsm
 
             updateCapturePosition(position);
 
-            auto valid_transitions = getValidTransitions(ch);
+            const auto &valid_transitions = getValidTransitions(ch);
 
             if (valid_transitions.empty())
             {
                 if (backtrack())
                 {
-                    ChoicePoint &cp = choice_stack_.top();
+                    ChoicePoint &cp = topChoicePoint();
 
                     if (!cp.remaining.empty())
                     {
                         const Transition *next_trans = cp.remaining[0];
                         cp.remaining.erase(cp.remaining.begin());
 
-                        StateID old_state = current_state_;
                         current_state_ = next_trans->to;
 
                         backtracking_stats_.paths_explored++;
 
-                        recordCharInCaptures(ch);
-
                         position = cp.position + 1;
                         current_input_position_ = position;
 
@@ -972,33 +1192,21 @@ namespace fsm
                     }
                 }
 
-                last_error_ = ValidationError{
-                    ErrorType::NO_MATCHING_TRANSITION,
-                    position,
-                    ch,
-                    current_state_,
-                    "No transition found from " + current_state_.toString() +
-                        " for character '" + std::string(1, ch) + "'",
-                    {},
-                    ""};
+                fail(ErrorType::NO_MATCHING_TRANSITION, ErrorSite::VALIDATE, position, ch, current_state_.id);
                 return false;
             }
 
             if (shouldCreateChoicePoint(valid_transitions))
             {
-                std::vector<const Transition *> remaining(
-                    valid_transitions.begin() + 1,
-                    valid_transitions.end());
-
-                saveChoicePoint(remaining, position);
+                saveChoicePoint(valid_transitions, position);
             }
 
             const Transition *trans = valid_transitions[0];
 
             backtracking_stats_.paths_explored++;
 
-            StateID old_state = current_state_;
-            StateID new_state = trans->to;
+            const StateID &old_state = trans->from;
+            const StateID &new_state = trans->to;
             bool state_changed = (old_state != new_state);
 
             if (state_changed)
@@ -1045,14 +1253,9 @@ namespace fsm
 
             if (debug_config_.hasTraceTransitions())
             {
-                TraceEntry entry{trace_.size(), old_state, current_state_,
-                                 ch, trans->id, trans->description};
-                trace_.push_back(entry);
-                logTransition(entry);
+                logTransition(appendTrace(old_state, current_state_, ch, trans->id, trans->description));
             }
 
-            recordCharInCaptures(ch);
-
             position++;
             current_input_position_++;
 
@@ -1070,11 +1273,11 @@ namespace fsm
         {
             while (backtrack())
             {
-                ChoicePoint &cp = choice_stack_.top();
+                ChoicePoint &cp = topChoicePoint();
 
                 if (cp.remaining.empty())
                 {
-                    choice_stack_.pop();
+                    choice_depth_--;
                     continue;
                 }
 
@@ -1098,7 +1301,7 @@ namespace fsm
                     continue;
                 }
 
-                std::string remaining_input(input.substr(resume_pos));
+                std::string_view remaining_input = input.substr(resume_pos);
                 StateID saved_start = start_state_;
 
                 start_state_ = current_state_;
@@ -1113,15 +1316,8 @@ namespace fsm
                 }
             }
 
-            last_error_ = ValidationError{
-                ErrorType::NOT_IN_ACCEPT_STATE,
-                input.size(),
-                '\0',
-                current_state_,
-                "Input consumed but not in accept state. Current state: " +
-                    current_state_.toString(),
-                {},
-                ""};
+            fail(ErrorType::NOT_IN_ACCEPT_STATE, ErrorSite::BACKTRACK, input.size(), '\0',
+                 current_state_.id);
             return false;
         }
 
@@ -1129,90 +1325,468 @@ namespace fsm
     }
 
     // ============================================================================
-    // Internal Helpers
+    // Pushdown Implementation (Sub-machine Calls)
     // ============================================================================
 
-    bool FSM::processCharImpl(char ch, size_t position)
+    void FSM::setMaxCallDepth(size_t depth)
     {
-        auto transitions = getTransitionsFrom(current_state_);
+        max_call_depth_ = depth;
+    }
 
-        const Transition *best_match = nullptr;
+    size_t FSM::getMaxCallDepth() const
+    {
+        return max_call_depth_;
+    }
 
-        for (const auto *trans : transitions)
-        {
-            if (trans->type == TransitionType::ABNF_RULE && trans->matches(ch))
-            {
-                best_match = trans;
-                break;
-            }
-        }
+    size_t FSM::getCallDepth() const
+    {
+        return run_->call_stack.size();
+    }
 
-        if (!best_match)
+    void FSM::collectCallFirstSets(const FSM *root)
+    {
+        call_first_sets_ = computeCallFirstSets(root);
+        for (const auto &[machine, first] : call_first_sets_)
         {
-            last_error_ = ValidationError{
-                ErrorType::NO_MATCHING_TRANSITION,
-                position,
-                ch,
-                current_state_,
-                "No transition found from " + current_state_.toString() +
-                    " for character '" + std::string(1, ch) + "'",
-                {},
-                ""};
-            return false;
+            const_cast<FSM *>(machine)->rebuildTransitionMap();
         }
+    }
 
-        StateID old_state = current_state_;
-        StateID new_state = best_match->to;
-        bool state_changed = (old_state != new_state);
+    // Edge order does not change a first set, so this reads transitions_
+    // directly and can run while a transition map is being rebuilt.
+    FSM::FirstSets FSM::computeCallFirstSets(const FSM *root)
+    {
+        FirstSets first_sets;
+        std::vector<const FSM *> machines{root};
+        first_sets[root] = CallFirstSet();
 
-        if (state_changed)
+        for (size_t i = 0; i < machines.size(); ++i)
         {
-            auto old_state_it = states_.find(old_state);
-            if (old_state_it != states_.end() && old_state_it->second.on_exit)
+            const FSM *machine = machines[i];
+            for (const auto &trans : machine->transitions_)
             {
-                StateContext ctx(old_state, position, ch, user_data_);
-                old_state_it->second.on_exit(ctx);
+                if (trans.type != TransitionType::FSM_INSTANCE)
+                {
+                    continue;
+                }
+
+                const FSM *callee = trans.embedded_fsm ? trans.embedded_fsm.get() : machine;
+                if (first_sets.emplace(callee, CallFirstSet()).second)
+                {
+                    machines.push_back(callee);
+                }
             }
         }
 
-        if (best_match->on_transition)
+        // First sets of mutually recursive machines depend on each other, so
+        // iterate until nothing changes. A call to a machine that accepts the
+        // empty string can be passed through, so its target joins the closure.
+        bool changed = true;
+        while (changed)
         {
-            TransitionContext ctx(old_state, new_state, ch, position, best_match, user_data_);
-            best_match->on_transition(ctx);
-        }
-
-        current_state_ = new_state;
+            changed = false;
 
-        if (state_changed)
-        {
-            auto new_state_it = states_.find(new_state);
-            if (new_state_it != states_.end() && new_state_it->second.on_entry)
+            for (const FSM *machine : machines)
             {
-                StateContext ctx(new_state, position, ch, user_data_);
-                new_state_it->second.on_entry(ctx);
-            }
-        }
+                CallFirstSet first;
+                std::vector<StateID> closure{machine->start_state_};
 
-        if (debug_config_.hasCollectMetrics())
-        {
-            metrics_.transitions_taken++;
-            if (state_changed)
-            {
-                metrics_.states_visited++;
-            }
-        }
+                for (size_t i = 0; i < closure.size(); ++i)
+                {
+                    if (machine->isAcceptState(closure[i]))
+                    {
+                        first.accepts_empty = true;
+                    }
 
-        if (debug_config_.hasTraceStateChanges() && state_changed)
-        {
-            logStateChange(old_state, current_state_);
-        }
+                    for (const auto &trans : machine->transitions_)
+                    {
+                        if (trans.from != closure[i])
+                        {
+                            continue;
+                        }
 
-        if (debug_config_.hasTraceTransitions())
-        {
-            TraceEntry entry{trace_.size(), old_state, current_state_,
-                             ch, best_match->id, best_match->description};
-            trace_.push_back(entry);
-            logTransition(entry);
+                        bool follow = trans.type == TransitionType::EPSILON;
+                        switch (trans.type)
+                        {
+                        case TransitionType::ABNF_RULE:
+                            for (int byte = 0; byte < 256; ++byte)
+                            {
+                                if (trans.matches(static_cast<char>(byte)))
+                                {
+                                    first.bytes.set(byte);
+                                }
+                            }
+                            break;
+
+                        case TransitionType::FSM_INSTANCE:
+                        {
+                            const auto &callee = first_sets[trans.embedded_fsm ? trans.embedded_fsm.get() : machine];
+                            first.bytes |= callee.bytes;
+                            follow = callee.accepts_empty;
+                            break;
+                        }
+
+                        case TransitionType::EPSILON:
+                            break;
+                        }
+
+                        if (follow && std::find(closure.begin(), closure.end(), trans.to) == closure.end())
+                        {
+                            closure.push_back(trans.to);
+                        }
+                    }
+                }
+
+                auto &current = first_sets[machine];
+                if (current.bytes != first.bytes || current.accepts_empty != first.accepts_empty)
+                {
+                    current = first;
+                    changed = true;
+                }
+            }
+        }
+
+        return first_sets;
+    }
+
+    const std::pmr::vector<StateID> &FSM::pushdownEpsilonChain(const FSM *machine, StateID state)
+    {
+        // Mirrors processEpsilonTransitions(): follow the first epsilon edge
+        // that leads somewhere new. The chain lives in run_ so a step does not
+        // allocate once the buffer has grown.
+        auto &chain = run_->pushdown_chain;
+        chain.assign(1, state);
+
+        bool found_epsilon = true;
+        while (found_epsilon)
+        {
+            found_epsilon = false;
+
+            auto it = machine->transition_map_.find(chain.back());
+            if (it == machine->transition_map_.end())
+            {
+                break;
+            }
+
+            for (const auto *trans : it->second)
+            {
+                if (trans->type == TransitionType::EPSILON &&
+                    std::find(chain.begin(), chain.end(), trans->to) == chain.end())
+                {
+                    chain.push_back(trans->to);
+                    found_epsilon = true;
+                    break;
+                }
+            }
+        }
+
+        return chain;
+    }
+
+    bool FSM::pushdownStep(const FSM *&machine, char ch, size_t position)
+    {
+        const auto byte = static_cast<unsigned char>(ch);
+        size_t calls_without_input = 0;
+
+        while (true)
+        {
+            bool can_return = false;
+            bool entered_call = false;
+            const Transition *pass_through = nullptr;
+
+            const auto &chain = pushdownEpsilonChain(machine, current_state_);
+            for (const StateID &state : chain)
+            {
+                auto it = machine->transition_map_.find(state);
+                if (it != machine->transition_map_.end())
+                {
+                    for (const auto *trans : it->second)
+                    {
+                        if (trans->type == TransitionType::ABNF_RULE && trans->matches(ch))
+                        {
+                            current_state_ = trans->to;
+
+                            if (debug_config_.hasCollectMetrics())
+                            {
+                                metrics_.transitions_taken++;
+                            }
+                            return true;
+                        }
+
+                        if (trans->type != TransitionType::FSM_INSTANCE)
+                        {
+                            continue;
+                        }
+
+                        const FSM *callee = trans->embedded_fsm ? trans->embedded_fsm.get() : machine;
+                        const CallFirstSet &first = call_first_sets_[callee];
+                        if (!first.bytes.test(byte))
+                        {
+                            // The callee cannot start with this byte, but if it
+                            // accepts the empty string the call can be skipped.
+                            if (!pass_through && first.accepts_empty &&
+                                std::find(chain.begin(), chain.end(), trans->to) == chain.end())
+                            {
+                                pass_through = trans;
+                            }
+                            continue;
+                        }
+
+                        if (run_->call_stack.size() >= max_call_depth_ ||
+                            ++calls_without_input > max_call_depth_)
+                        {
+                            fail(ErrorType::EMBEDDED_FSM_FAILED, ErrorSite::PUSHDOWN, position, ch, state.id,
+                                 machine, static_cast<uint32_t>(max_call_depth_));
+                            return false;
+                        }
+
+                        run_->call_stack.push_back(CallFrame{machine, trans->to});
+                        machine = callee;
+                        current_state_ = callee->start_state_;
+                        entered_call = true;
+                        break;
+                    }
+                }
+
+                if (entered_call)
+                {
+                    break;
+                }
+
+                if (machine->isAcceptState(state))
+                {
+                    can_return = true;
+                }
+            }
+
+            if (entered_call)
+            {
+                continue;
+            }
+
+            if (pass_through)
+            {
+                if (++calls_without_input > max_call_depth_)
+                {
+                    fail(ErrorType::EMBEDDED_FSM_FAILED, ErrorSite::PUSHDOWN, position, ch,
+                         current_state_.id, machine, static_cast<uint32_t>(max_call_depth_));
+                    return false;
+                }
+                current_state_ = pass_through->to;
+                continue;
+            }
+
+            if (can_return && !run_->call_stack.empty())
+            {
+                machine = run_->call_stack.back().machine;
+                current_state_ = run_->call_stack.back().return_state;
+                run_->call_stack.pop_back();
+                continue;
+            }
+
+            fail(ErrorType::NO_MATCHING_TRANSITION, ErrorSite::PUSHDOWN, position, ch,
+                 current_state_.id, machine);
+            return false;
+        }
+    }
+
+    bool FSM::validatePushdown(std::string_view input)
+    {
+        reset();
+        has_error_ = false;
+
+        run_->current_input.assign(input.data(), input.size());
+        clearCaptures();
+        current_input_position_ = 0;
+
+        rebuildTransitionMap();
+
+        if (!start_state_.isValid())
+        {
+            fail(ErrorType::NO_START_STATE, ErrorSite::VALIDATE, 0, '\0', current_state_.id);
+            return false;
+        }
+
+        call_first_sets_.clear();
+        collectCallFirstSets(this);
+
+        const FSM *machine = this;
+
+        for (size_t i = 0; i < input.size(); ++i)
+        {
+            updateCapturePosition(i);
+
+            if (!pushdownStep(machine, input[i], i))
+            {
+                return false;
+            }
+
+            if (debug_config_.hasCollectMetrics())
+            {
+                metrics_.characters_processed++;
+            }
+        }
+
+        updateCapturePosition(input.size());
+
+        // Unwind the return stack: every pending frame must be able to finish
+        // without further input.
+        size_t calls_without_input = 0;
+        while (true)
+        {
+            bool accepted = false;
+            const Transition *pass_through = nullptr;
+
+            const auto &chain = pushdownEpsilonChain(machine, current_state_);
+            for (const StateID &state : chain)
+            {
+                if (machine->isAcceptState(state))
+                {
+                    current_state_ = state;
+                    accepted = true;
+                    break;
+                }
+
+                auto it = machine->transition_map_.find(state);
+                if (pass_through || it == machine->transition_map_.end())
+                {
+                    continue;
+                }
+                for (const auto *trans : it->second)
+                {
+                    if (trans->type == TransitionType::FSM_INSTANCE &&
+                        call_first_sets_[trans->embedded_fsm ? trans->embedded_fsm.get() : machine].accepts_empty &&
+                        std::find(chain.begin(), chain.end(), trans->to) == chain.end())
+                    {
+                        pass_through = trans;
+                        break;
+                    }
+                }
+            }
+
+            // Calls to machines that accept the empty string need no input.
+            if (!accepted && pass_through && ++calls_without_input <= max_call_depth_)
+            {
+                current_state_ = pass_through->to;
+                continue;
+            }
+
+            if (!accepted)
+            {
+                fail(ErrorType::NOT_IN_ACCEPT_STATE, ErrorSite::PUSHDOWN, input.size(), '\0',
+                     current_state_.id, machine, static_cast<uint32_t>(run_->call_stack.size()));
+                return false;
+            }
+
+            if (run_->call_stack.empty())
+            {
+                return true;
+            }
+
+            machine = run_->call_stack.back().machine;
+            current_state_ = run_->call_stack.back().return_state;
+            run_->call_stack.pop_back();
+        }
+    }
+
+    // ============================================================================
+    // Internal Helpers
+    // ============================================================================
+
+    bool FSM::processCharImpl(char ch, size_t position)
+    {
+        const RuntimeEdge *taken = nullptr;
+
+        for (const RuntimeEdge &edge : edgesFrom(current_state_.id))
+        {
+            if (edge.type == TransitionType::ABNF_RULE && edgeMatches(edge, ch))
+            {
+                taken = &edge;
+                break;
+            }
+        }
+
+        const Transition *best_match = taken ? &transitions_[taken->transition] : nullptr;
+
+        if (!best_match)
+        {
+            fail(ErrorType::NO_MATCHING_TRANSITION, ErrorSite::VALIDATE, position, ch, current_state_.id);
+            return false;
+        }
+
+        accept_sink_reached_ = (taken->flags & RuntimeEdge::TARGET_SINK) != 0;
+
+        // No accept state is reachable from the target: stop before scanning on.
+        if (taken->flags & RuntimeEdge::TARGET_DEAD)
+        {
+            fail(ErrorType::NO_MATCHING_TRANSITION, ErrorSite::VALIDATE, position, ch, current_state_.id,
+                 nullptr, best_match->to.id);
+            return false;
+        }
+
+        // The transition's own IDs outlive current_state_ and copying them
+        // would allocate for long state names.
+        const StateID &old_state = best_match->from;
+        const StateID &new_state = best_match->to;
+        bool state_changed = (old_state != new_state);
+
+        if (state_changed)
+        {
+            auto old_state_it = states_.find(old_state);
+            if (old_state_it != states_.end() && old_state_it->second.on_exit)
+            {
+                StateContext ctx(old_state, position, ch, user_data_);
+                old_state_it->second.on_exit(ctx);
+            }
+        }
+
+        if (taken->flags & RuntimeEdge::HAS_CALLBACK)
+        {
+            TransitionContext ctx(old_state, new_state, ch, position, best_match, user_data_);
+            best_match->on_transition(ctx);
+        }
+
+        current_state_ = new_state;
+
+        if (metrics_shard_)
+        {
+            metrics_shard_->recordTransition(best_match->id);
+            metrics_shard_->recordStateVisit(new_state.id);
+        }
+
+        if (trace_sampled_)
+        {
+            tracer_->record(TraceRecord{trace_validation_, static_cast<uint32_t>(position), old_state.id,
+                                        new_state.id, best_match->id, static_cast<uint8_t>(ch), 0});
+        }
+
+        if (state_changed)
+        {
+            auto new_state_it = states_.find(new_state);
+            if (new_state_it != states_.end() && new_state_it->second.on_entry)
+            {
+                StateContext ctx(new_state, position, ch, user_data_);
+                new_state_it->second.on_entry(ctx);
+            }
+        }
+
+        if (debug_config_.hasCollectMetrics())
+        {
+            metrics_.transitions_taken++;
+            if (state_changed)
+            {
+                metrics_.states_visited++;
+            }
+        }
+
+        if (debug_config_.hasTraceStateChanges() && state_changed)
+        {
+            logStateChange(old_state, current_state_);
+        }
+
+        if (debug_config_.hasTraceTransitions())
+        {
+            logTransition(appendTrace(old_state, current_state_, ch, best_match->id, best_match->description));
         }
 
         return true;
@@ -1220,26 +1794,30 @@ namespace fsm
 
     void FSM::processEpsilonTransitions(size_t position)
     {
-        std::unordered_set<StateID, StateID::Hash> epsilon_visited;
-        epsilon_visited.insert(current_state_);
+        // Chains are short, so a reused flat list beats hashing and keeps
+        // the end of input allocation-free.
+        run_->epsilon_visited.clear();
+        run_->epsilon_visited.push_back(current_state_.id);
 
         bool found_epsilon = true;
         while (found_epsilon)
         {
             found_epsilon = false;
-            auto transitions = getTransitionsFrom(current_state_);
 
-            for (const auto *trans : transitions)
+            for (const RuntimeEdge &edge : edgesFrom(current_state_.id))
             {
-                if (trans->type == TransitionType::EPSILON)
+                if (edge.type == TransitionType::EPSILON)
                 {
-                    if (epsilon_visited.find(trans->to) != epsilon_visited.end())
+                    const Transition *trans = &transitions_[edge.transition];
+
+                    if (std::find(run_->epsilon_visited.begin(), run_->epsilon_visited.end(), trans->to.id) !=
+                        run_->epsilon_visited.end())
                     {
                         continue;
                     }
 
-                    StateID old_state = current_state_;
-                    StateID new_state = trans->to;
+                    const StateID &old_state = trans->from;
+                    const StateID &new_state = trans->to;
 
                     auto old_state_it = states_.find(old_state);
                     if (old_state_it != states_.end() && old_state_it->second.on_exit)
@@ -1255,7 +1833,20 @@ namespace fsm
                     }
 
                     current_state_ = new_state;
-                    epsilon_visited.insert(current_state_);
+                    run_->epsilon_visited.push_back(current_state_.id);
+
+                    if (metrics_shard_)
+                    {
+                        metrics_shard_->recordTransition(trans->id);
+                        metrics_shard_->recordStateVisit(new_state.id);
+                    }
+
+                    if (trace_sampled_)
+                    {
+                        tracer_->record(TraceRecord{trace_validation_, static_cast<uint32_t>(position),
+                                                    old_state.id, new_state.id, trans->id, 0,
+                                                    TraceRecord::EPSILON});
+                    }
 
                     auto new_state_it = states_.find(new_state);
                     if (new_state_it != states_.end() && new_state_it->second.on_entry)
@@ -1276,10 +1867,7 @@ namespace fsm
 
                     if (debug_config_.hasTraceTransitions())
                     {
-                        TraceEntry entry{trace_.size(), old_state, current_state_,
-                                         '\0', trans->id, "Epsilon"};
-                        trace_.push_back(entry);
-                        logTransition(entry);
+                        logTransition(appendTrace(old_state, current_state_, '\0', trans->id, "Epsilon"));
                     }
 
                     found_epsilon = true;
@@ -1303,6 +1891,12 @@ namespace fsm
             transition_map_[trans.from].push_back(&trans);
         }
 
+        // Calls compete with ABNF edges for their callee's first bytes.
+        const bool has_calls = std::any_of(transitions_.begin(), transitions_.end(), [](const Transition &trans)
+                                           { return trans.type == TransitionType::FSM_INSTANCE; });
+        const FirstSets first_sets =
+            !profile_transition_hits_.empty() && has_calls ? computeCallFirstSets(this) : FirstSets();
+
         for (auto &[state, trans_list] : transition_map_)
         {
             std::sort(trans_list.begin(), trans_list.end(),
@@ -1310,52 +1904,864 @@ namespace fsm
                       {
                           return a->priority > b->priority;
                       });
+
+            if (!profile_transition_hits_.empty())
+            {
+                orderByProfile(trans_list, first_sets);
+            }
+        }
+
+        buildRuntimeEdges();
+
+        transition_map_dirty_ = false;
+    }
+
+    void FSM::buildRuntimeEdges()
+    {
+        static_assert(sizeof(RuntimeEdge) == 8, "RuntimeEdge must stay packed");
+
+        runtime_edges_.clear();
+        charsets_.clear();
+        table_matcher_.reset();
+        keywords_.reset();
+
+        uint32_t max_state = 0;
+        for (const auto &[state, trans_list] : transition_map_)
+        {
+            max_state = std::max(max_state, state.id);
+        }
+
+        // Offsets are counted per state first, then turned into prefix sums.
+        edge_offsets_.assign(transition_map_.empty() ? 0 : static_cast<size_t>(max_state) + 2, 0);
+        for (const auto &[state, trans_list] : transition_map_)
+        {
+            edge_offsets_[state.id + 1] = static_cast<uint32_t>(trans_list.size());
+        }
+        for (size_t i = 1; i < edge_offsets_.size(); ++i)
+        {
+            edge_offsets_[i] += edge_offsets_[i - 1];
+        }
+
+        runtime_edges_.resize(transitions_.size());
+        live_states_ = analyzeReachability().live;
+
+        std::map<CharSet, uint16_t> charset_index;
+        for (const auto &[state, trans_list] : transition_map_)
+        {
+            RuntimeEdge *out = runtime_edges_.data() + edge_offsets_[state.id];
+
+            for (const Transition *trans : trans_list)
+            {
+                RuntimeEdge edge{static_cast<uint32_t>(trans - transitions_.data()), 0, trans->type, 0};
+
+                if (trans->on_transition)
+                {
+                    edge.flags |= RuntimeEdge::HAS_CALLBACK;
+                }
+
+                if (trans->to.id >= live_states_.size() || !live_states_[trans->to.id])
+                {
+                    edge.flags |= RuntimeEdge::TARGET_DEAD;
+                }
+
+                if (trans->type == TransitionType::ABNF_RULE)
+                {
+                    CharSet set{};
+                    for (int byte = 0; byte < 256; ++byte)
+                    {
+                        if (trans->matches(static_cast<char>(byte)))
+                        {
+                            set[byte >> 6] |= uint64_t{1} << (byte & 63);
+                        }
+                    }
+
+                    auto [it, inserted] = charset_index.emplace(set, static_cast<uint16_t>(charsets_.size()));
+                    if (inserted)
+                    {
+                        if (charsets_.size() > UINT16_MAX)
+                        {
+                            throw std::runtime_error("FSM '" + name_ + "' has more than 65536 distinct character sets");
+                        }
+                        charsets_.push_back(set);
+                    }
+                    edge.charset = it->second;
+                }
+
+                *out++ = edge;
+            }
+        }
+
+        findAcceptSinks();
+
+        for (RuntimeEdge &edge : runtime_edges_)
+        {
+            const uint32_t target = transitions_[edge.transition].to.id;
+            if (target < accept_sinks_.size() && accept_sinks_[target])
+            {
+                edge.flags |= RuntimeEdge::TARGET_SINK;
+            }
+        }
+
+        length_bounds_ = analyzeLengths();
+        selectEngine();
+    }
+
+    void FSM::findAcceptSinks()
+    {
+        accept_sinks_.assign(live_states_.size(), 0);
+
+        // Candidates: callback-free accept states where every byte has an ABNF
+        // edge and nothing else leaves. Their first-match targets per byte are
+        // collected for the fixpoint below.
+        std::vector<std::pair<uint32_t, std::vector<uint32_t>>> candidates;
+
+        for (const auto &accept : accept_states_)
+        {
+            auto state_it = states_.find(accept);
+            if (accept.id >= accept_sinks_.size() || state_it == states_.end() ||
+                state_it->second.on_entry || state_it->second.on_exit)
+            {
+                continue;
+            }
+
+            const EdgeSpan edges = edgeRange(accept.id);
+            const bool plain = std::all_of(edges.begin(), edges.end(), [](const RuntimeEdge &edge)
+                                           { return edge.type == TransitionType::ABNF_RULE &&
+                                                    !(edge.flags & RuntimeEdge::HAS_CALLBACK); });
+            if (!plain || edges.begin() == edges.end())
+            {
+                continue;
+            }
+
+            std::vector<uint32_t> targets;
+            bool total = true;
+            for (int byte = 0; byte < 256 && total; ++byte)
+            {
+                const RuntimeEdge *match = nullptr;
+                for (const RuntimeEdge &edge : edges)
+                {
+                    if (edgeMatches(edge, static_cast<char>(byte)))
+                    {
+                        match = &edge;
+                        break;
+                    }
+                }
+
+                total = match != nullptr;
+                if (total)
+                {
+                    targets.push_back(transitions_[match->transition].to.id);
+                }
+            }
+
+            if (total)
+            {
+                std::sort(targets.begin(), targets.end());
+                targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+                candidates.emplace_back(accept.id, std::move(targets));
+                accept_sinks_[accept.id] = 1;
+            }
+        }
+
+        // Greatest fixpoint: drop candidates that some byte leads out of the set.
+        bool changed = true;
+        while (changed)
+        {
+            changed = false;
+            for (const auto &[id, targets] : candidates)
+            {
+                if (accept_sinks_[id] &&
+                    std::any_of(targets.begin(), targets.end(), [this](uint32_t target)
+                                { return target >= accept_sinks_.size() || !accept_sinks_[target]; }))
+                {
+                    accept_sinks_[id] = 0;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    std::vector<StateID> FSM::getAcceptSinkStates() const
+    {
+        const_cast<FSM *>(this)->rebuildTransitionMap();
+
+        std::vector<StateID> sinks;
+        for (const auto &[id, state] : states_)
+        {
+            if (id.id < accept_sinks_.size() && accept_sinks_[id.id])
+            {
+                sinks.push_back(id);
+            }
+        }
+        std::sort(sinks.begin(), sinks.end());
+        return sinks;
+    }
+
+    bool FSM::isAcceptSink(StateID state) const
+    {
+        const_cast<FSM *>(this)->rebuildTransitionMap();
+        return state.id < accept_sinks_.size() && accept_sinks_[state.id];
+    }
+
+    FSM::LengthBounds FSM::analyzeLengths() const
+    {
+        LengthBounds bounds;
+        if (!start_state_.isValid() || !hasState(start_state_))
+        {
+            return bounds;
+        }
+
+        const size_t slots = live_states_.size();
+        std::vector<std::vector<uint32_t>> forward(slots);
+        std::vector<std::vector<uint32_t>> backward(slots);
+        std::vector<std::vector<uint32_t>> epsilon_back(slots);
+        std::vector<std::vector<uint32_t>> widths(slots); // bytes per forward edge
+
+        // Mid-input only ABNF edges move; epsilon edges decide at the end
+        // which states accept.
+        for (const RuntimeEdge &edge : runtime_edges_)
+        {
+            const Transition &trans = transitions_[edge.transition];
+            if (trans.from.id >= slots || trans.to.id >= slots)
+            {
+                continue;
+            }
+
+            if (edge.type == TransitionType::FSM_INSTANCE)
+            {
+                return bounds;
+            }
+
+            if (edge.type == TransitionType::EPSILON)
+            {
+                epsilon_back[trans.to.id].push_back(trans.from.id);
+            }
+            else if (charsets_[edge.charset] != CharSet{})
+            {
+                const CharSet &set = charsets_[edge.charset];
+                forward[trans.from.id].push_back(trans.to.id);
+                widths[trans.from.id].push_back(static_cast<uint32_t>(
+                    std::bitset<64>(set[0]).count() + std::bitset<64>(set[1]).count() +
+                    std::bitset<64>(set[2]).count() + std::bitset<64>(set[3]).count()));
+                backward[trans.to.id].push_back(trans.from.id);
+            }
+        }
+
+        auto flood = [](const std::vector<std::vector<uint32_t>> &graph, std::vector<uint32_t> pending,
+                        std::vector<uint8_t> &marked)
+        {
+            for (uint32_t id : pending)
+            {
+                marked[id] = 1;
+            }
+            while (!pending.empty())
+            {
+                const uint32_t id = pending.back();
+                pending.pop_back();
+                for (uint32_t next : graph[id])
+                {
+                    if (!marked[next])
+                    {
+                        marked[next] = 1;
+                        pending.push_back(next);
+                    }
+                }
+            }
+        };
+
+        std::vector<uint32_t> accepting;
+        for (const auto &accept : accept_states_)
+        {
+            if (accept.id < slots)
+            {
+                accepting.push_back(accept.id);
+            }
+        }
+
+        // States whose epsilon edges can end in an accept state
+        std::vector<uint8_t> ends(slots);
+        flood(epsilon_back, std::move(accepting), ends);
+
+        std::vector<uint32_t> end_states;
+        for (uint32_t id = 0; id < slots; ++id)
+        {
+            if (ends[id])
+            {
+                end_states.push_back(id);
+            }
+        }
+
+        std::vector<uint8_t> reached(slots);
+        std::vector<uint8_t> useful(slots);
+        flood(forward, {start_state_.id}, reached);
+        flood(backward, std::move(end_states), useful);
+
+        for (uint32_t id = 0; id < slots; ++id)
+        {
+            useful[id] = useful[id] && reached[id];
+        }
+
+        if (!useful[start_state_.id])
+        {
+            bounds.max = 0;
+            bounds.finite = true;
+            bounds.empty = true;
+            bounds.count = 0;
+            return bounds;
+        }
+
+        // Shortest: breadth-first from the start state.
+        std::vector<size_t> depth(slots, LengthBounds::UNBOUNDED);
+        std::vector<uint32_t> queue{start_state_.id};
+        depth[start_state_.id] = 0;
+        for (size_t head = 0; head < queue.size(); ++head)
+        {
+            const uint32_t id = queue[head];
+            if (ends[id])
+            {
+                bounds.min = depth[id];
+                break;
+            }
+            for (uint32_t next : forward[id])
+            {
+                if (useful[next] && depth[next] == LengthBounds::UNBOUNDED)
+                {
+                    depth[next] = depth[id] + 1;
+                    queue.push_back(next);
+                }
+            }
+        }
+
+        // Longest: a cycle among useful states means there is no bound,
+        // otherwise take the longest path in topological order. The same pass
+        // counts accepted strings, saturating instead of overflowing.
+        std::vector<uint32_t> incoming(slots);
+        size_t useful_count = 0;
+        for (uint32_t id = 0; id < slots; ++id)
+        {
+            if (!useful[id])
+            {
+                continue;
+            }
+            ++useful_count;
+            for (uint32_t next : forward[id])
+            {
+                incoming[next] += useful[next];
+            }
+        }
+
+        std::vector<uint32_t> order;
+        for (uint32_t id = 0; id < slots; ++id)
+        {
+            if (useful[id] && incoming[id] == 0)
+            {
+                order.push_back(id);
+            }
+        }
+
+        auto saturatingAdd = [](size_t a, size_t b)
+        { return a > LengthBounds::UNBOUNDED - b ? LengthBounds::UNBOUNDED : a + b; };
+
+        std::vector<size_t> longest(slots, 0);
+        std::vector<size_t> paths(slots, 0);
+        paths[start_state_.id] = 1;
+        bounds.max = 0;
+        bounds.count = 0;
+        for (size_t head = 0; head < order.size(); ++head)
+        {
+            const uint32_t id = order[head];
+            if (ends[id])
+            {
+                bounds.max = std::max(bounds.max, longest[id]);
+                bounds.count = saturatingAdd(bounds.count, paths[id]);
+            }
+            for (size_t i = 0; i < forward[id].size(); ++i)
+            {
+                const uint32_t next = forward[id][i];
+                if (!useful[next])
+                {
+                    continue;
+                }
+                const size_t width = widths[id][i];
+                paths[next] = saturatingAdd(paths[next], paths[id] > LengthBounds::UNBOUNDED / width
+                                                             ? LengthBounds::UNBOUNDED
+                                                             : paths[id] * width);
+                longest[next] = std::max(longest[next], longest[id] + 1);
+                if (--incoming[next] == 0)
+                {
+                    order.push_back(next);
+                }
+            }
+        }
+
+        bounds.finite = order.size() == useful_count;
+        if (!bounds.finite)
+        {
+            bounds.max = LengthBounds::UNBOUNDED;
+            bounds.count = LengthBounds::UNBOUNDED;
+        }
+        return bounds;
+    }
+
+    FSM::LengthBounds FSM::getLengthBounds() const
+    {
+        const_cast<FSM *>(this)->rebuildTransitionMap();
+        return length_bounds_;
+    }
+
+    std::string FSM::LengthBounds::toString() const
+    {
+        if (empty)
+        {
+            return "(nothing accepted)";
+        }
+        return "[" + std::to_string(min) + ", " +
+               (max == UNBOUNDED ? std::string("unbounded") : std::to_string(max)) + "]";
+    }
+
+    std::vector<FSM::Ambiguity> FSM::findAmbiguities() const
+    {
+        std::vector<Ambiguity> result;
+
+        for (const auto &[id, state] : states_)
+        {
+            const EdgeSpan edges = edgeRange(id.id);
+
+            // covered holds every byte some earlier ABNF edge already takes.
+            CharSet covered{};
+            for (const RuntimeEdge *a = edges.begin(); a != edges.end(); ++a)
+            {
+                if (a->type == TransitionType::FSM_INSTANCE)
+                {
+                    continue;
+                }
+
+                const Transition &first = transitions_[a->transition];
+                for (const RuntimeEdge *b = a + 1; b != edges.end(); ++b)
+                {
+                    const Transition &second = transitions_[b->transition];
+                    if (b->type != a->type ||
+                        (first.to == second.to && !((a->flags | b->flags) & RuntimeEdge::HAS_CALLBACK)))
+                    {
+                        continue;
+                    }
+
+                    Ambiguity ambiguity{id, first.id, second.id, a->type};
+                    ambiguity.resolved_by_priority = first.priority != second.priority;
+
+                    if (a->type == TransitionType::ABNF_RULE)
+                    {
+                        const CharSet &set_a = charsets_[a->charset];
+                        const CharSet &set_b = charsets_[b->charset];
+
+                        size_t shared = 0;
+                        bool shadowed = true;
+                        for (size_t word = 0; word < set_a.size(); ++word)
+                        {
+                            shared += std::bitset<64>(set_a[word] & set_b[word]).count();
+                            shadowed = shadowed && (set_b[word] & ~(covered[word] | set_a[word])) == 0;
+                        }
+
+                        if (shared == 0)
+                        {
+                            continue;
+                        }
+
+                        ambiguity.shared_bytes = static_cast<uint16_t>(shared);
+                        ambiguity.shadowed = shadowed;
+                    }
+
+                    result.push_back(ambiguity);
+                }
+
+                if (a->type == TransitionType::ABNF_RULE)
+                {
+                    for (size_t word = 0; word < covered.size(); ++word)
+                    {
+                        covered[word] |= charsets_[a->charset][word];
+                    }
+                }
+            }
+        }
+
+        std::sort(result.begin(), result.end(), [](const Ambiguity &a, const Ambiguity &b)
+                  { return a.state != b.state ? a.state < b.state
+                                              : std::make_pair(a.first, a.second) < std::make_pair(b.first, b.second); });
+        return result;
+    }
+
+    void FSM::selectEngine()
+    {
+        bool calls = false;
+        bool callbacks = false;
+
+        for (const RuntimeEdge &edge : runtime_edges_)
+        {
+            calls = calls || edge.type == TransitionType::FSM_INSTANCE;
+            callbacks = callbacks || (edge.flags & RuntimeEdge::HAS_CALLBACK);
+        }
+
+        for (const auto &[id, state] : states_)
+        {
+            callbacks = callbacks || state.on_entry || state.on_exit;
+        }
+
+        unresolved_.clear();
+        for (const Ambiguity &ambiguity : findAmbiguities())
+        {
+            if (ambiguity.type == TransitionType::ABNF_RULE && !ambiguity.resolved_by_priority)
+            {
+                unresolved_.push_back(ambiguity);
+            }
+            else if (ambiguity.resolved_by_priority && debug_config_.hasVerboseErrors())
+            {
+                debug_config_.getOutputStream() << "[FSM:" << name_ << "] Warning: priority order hides "
+                                                << ambiguity.toString() << std::endl;
+            }
+        }
+
+        if (calls)
+        {
+            selected_engine_ = Engine::PUSHDOWN;
+        }
+        else if (!unresolved_.empty())
+        {
+            selected_engine_ = Engine::BACKTRACKING;
+        }
+        else if (callbacks)
+        {
+            selected_engine_ = Engine::INTERPRETER;
+        }
+        else
+        {
+            selected_engine_ = length_bounds_.count <= KEYWORD_ENGINE_LIMIT &&
+                                       length_bounds_.max <= KeywordSet::MAX_LENGTH
+                                   ? Engine::KEYWORDS
+                                   : Engine::TABLE;
+        }
+    }
+
+    std::vector<FSM::Ambiguity> FSM::getAmbiguities() const
+    {
+        const_cast<FSM *>(this)->rebuildTransitionMap();
+        return findAmbiguities();
+    }
+
+    bool FSM::isDeterministic() const
+    {
+        const std::vector<Ambiguity> ambiguities = getAmbiguities();
+        return std::all_of(ambiguities.begin(), ambiguities.end(), [](const Ambiguity &ambiguity)
+                           { return ambiguity.resolved_by_priority || ambiguity.type == TransitionType::EPSILON; });
+    }
+
+    std::string FSM::Ambiguity::toString() const
+    {
+        std::ostringstream oss;
+        oss << "overlap in " << state.toString() << ": transition " << first << " before " << second;
+        if (type == TransitionType::EPSILON)
+        {
+            oss << " (epsilon)";
+        }
+        else
+        {
+            oss << " on " << shared_bytes << (shared_bytes == 1 ? " byte" : " bytes");
+        }
+        if (shadowed)
+        {
+            oss << ", " << second << " is never taken";
+        }
+        return oss.str();
+    }
+
+    // ============================================================================
+    // Engine Selection
+    // ============================================================================
+
+    void FSM::setEngine(Engine engine)
+    {
+        engine_ = engine;
+    }
+
+    FSM::Engine FSM::getEngine() const
+    {
+        return engine_;
+    }
+
+    FSM::Engine FSM::getSelectedEngine() const
+    {
+        const_cast<FSM *>(this)->rebuildTransitionMap();
+        return selected_engine_;
+    }
+
+    const char *FSM::engineToString(Engine engine) noexcept
+    {
+        switch (engine)
+        {
+        case Engine::AUTO:
+            return "AUTO";
+        case Engine::TABLE:
+            return "TABLE";
+        case Engine::INTERPRETER:
+            return "INTERPRETER";
+        case Engine::BACKTRACKING:
+            return "BACKTRACKING";
+        case Engine::PUSHDOWN:
+            return "PUSHDOWN";
+        case Engine::KEYWORDS:
+            return "KEYWORDS";
+        default:
+            return "UNKNOWN";
+        }
+    }
+
+    FSM::Engine FSM::engineForRun()
+    {
+        rebuildTransitionMap();
+
+        if (engine_ != Engine::AUTO)
+        {
+            return engine_;
+        }
+
+        // The table and keyword engines carry no hooks, so instrumented runs
+        // stay on the interpreter.
+        if ((selected_engine_ == Engine::TABLE || selected_engine_ == Engine::KEYWORDS) &&
+            (debug_config_.hasTraceTransitions() || debug_config_.hasTraceStateChanges() ||
+             debug_config_.hasCollectMetrics() || metrics_registry_ || tracer_))
+        {
+            return Engine::INTERPRETER;
+        }
+
+        return selected_engine_;
+    }
+
+    FSM::EdgeSpan FSM::edgesFrom(uint32_t state) const
+    {
+        const_cast<FSM *>(this)->rebuildTransitionMap();
+        return edgeRange(state);
+    }
+
+    FSM::EdgeSpan FSM::edgeRange(uint32_t state) const
+    {
+        if (state + size_t{1} >= edge_offsets_.size())
+        {
+            return EdgeSpan{nullptr, nullptr};
+        }
+
+        const RuntimeEdge *edges = runtime_edges_.data();
+        return EdgeSpan{edges + edge_offsets_[state], edges + edge_offsets_[state + 1]};
+    }
+
+    void FSM::orderByProfile(std::vector<Transition *> &transitions, const FirstSets &first_sets) const
+    {
+        // Two neighbours may swap when they can never compete for the same
+        // step. Epsilon edges are tried in a separate pass from consuming
+        // ones. ABNF rules and sub-machine calls share one first-match pass
+        // (a call is entered when its callee's first set has the byte), so
+        // they commute only when their byte sets are disjoint. Two calls, or
+        // two epsilon edges, never commute.
+        auto bytes = [&](const Transition *trans)
+        {
+            std::bitset<256> set;
+            if (trans->type == TransitionType::FSM_INSTANCE)
+            {
+                // A call that can pass through on empty input competes for
+                // every byte.
+                auto it = first_sets.find(trans->embedded_fsm ? trans->embedded_fsm.get() : this);
+                return it != first_sets.end() && !it->second.accepts_empty ? it->second.bytes : set.set();
+            }
+            for (int byte = 0; byte < 256; ++byte)
+            {
+                set[byte] = trans->matches(static_cast<char>(byte));
+            }
+            return set;
+        };
+
+        auto commute = [&](const Transition *a, const Transition *b)
+        {
+            if ((a->type == TransitionType::EPSILON) != (b->type == TransitionType::EPSILON))
+            {
+                return true;
+            }
+            if (a->type == TransitionType::EPSILON ||
+                (a->type == TransitionType::FSM_INSTANCE && b->type == TransitionType::FSM_INSTANCE))
+            {
+                return false;
+            }
+            return (bytes(a) & bytes(b)).none();
+        };
+
+        for (size_t i = 1; i < transitions.size(); ++i)
+        {
+            for (size_t j = i; j > 0; --j)
+            {
+                Transition *hot = transitions[j];
+                Transition *cold = transitions[j - 1];
+
+                if (getProfiledHits(hot->id) <= getProfiledHits(cold->id) || !commute(hot, cold))
+                {
+                    break;
+                }
+
+                std::swap(transitions[j], transitions[j - 1]);
+            }
+        }
+    }
+
+    void FSM::sortTransitionsByPriority()
+    {
+        std::sort(transitions_.begin(), transitions_.end(),
+                  [](const Transition &a, const Transition &b)
+                  {
+                      return a.priority > b.priority;
+                  });
+
+        transition_map_dirty_ = true;
+    }
+
+    void FSM::logTransition(const TraceEntry &entry)
+    {
+        auto &os = debug_config_.getOutputStream();
+        os << "[FSM:" << name_ << "] " << entry.toString() << std::endl;
+    }
+
+    void FSM::logStateChange(StateID from, StateID to)
+    {
+        auto &os = debug_config_.getOutputStream();
+        os << "[FSM:" << name_ << "] State change: "
+           << from.toString() << " -> " << to.toString() << std::endl;
+    }
+
+    std::string FSM::getInputContext(std::string_view input, size_t position) const
+    {
+        const size_t context_size = 10;
+        size_t start = (position > context_size) ? position - context_size : 0;
+        size_t end = std::min(position + context_size, input.size());
+
+        std::string context(input.substr(start, end - start));
+        return context;
+    }
+
+    // ============================================================================
+    // Error Reporting
+    // ============================================================================
+
+    std::optional<FSM::ValidationError> FSM::getLastError() const
+    {
+        if (!has_error_)
+        {
+            return std::nullopt;
+        }
+
+        const FSM *machine = error_.machine ? error_.machine : this;
+        auto state_it = machine->states_.find(StateID(error_.state));
+        const StateID state = state_it != machine->states_.end() ? state_it->first : StateID(error_.state);
+        const std::string character(1, error_.character);
+        std::string message;
+
+        switch (error_.type)
+        {
+        case ErrorType::NO_MATCHING_TRANSITION:
+            if (error_.site == ErrorSite::PUSHDOWN)
+            {
+                message = "No transition found from " + state.toString() + " in " + machine->name_ +
+                          " for character '" + character + "'";
+            }
+            else if (error_.detail != 0)
+            {
+                auto dead_it = states_.find(StateID(error_.detail));
+                const StateID dead = dead_it != states_.end() ? dead_it->first : StateID(error_.detail);
+                message = "Transition from " + state.toString() + " for character '" + character +
+                          "' leads to dead state " + dead.toString();
+            }
+            else
+            {
+                message = "No transition found from " + state.toString() +
+                          " for character '" + character + "'";
+            }
+            break;
+        case ErrorType::NOT_IN_ACCEPT_STATE:
+            switch (error_.site)
+            {
+            case ErrorSite::STREAM:
+                message = "End of stream but not in accept state.  Current state: " + state.toString();
+                break;
+            case ErrorSite::BACKTRACK:
+                message = "Input consumed but not in accept state. Current state: " + state.toString();
+                break;
+            case ErrorSite::PUSHDOWN:
+                message = "Input consumed but not in accept state.  Current state: " + state.toString() +
+                          " in " + machine->name_ + " (call depth " + std::to_string(error_.detail) + ")";
+                break;
+            default:
+                message = "Input consumed but not in accept state.  Current state: " + state.toString();
+                break;
+            }
+            break;
+        case ErrorType::EMBEDDED_FSM_FAILED:
+            message = "Sub-machine call depth limit (" + std::to_string(error_.detail) +
+                      ") exceeded in " + machine->name_;
+            break;
+        case ErrorType::NO_START_STATE:
+            message = "No start state defined";
+            break;
+        case ErrorType::LENGTH_OUT_OF_RANGE:
+            message = std::string(error_.position < length_bounds_.min ? "Input shorter" : "Input longer") +
+                      " than accepted range " + length_bounds_.toString();
+            break;
+        case ErrorType::AMBIGUOUS_TRANSITION:
+            message = "Table engine needs a deterministic machine, but " + state.toString() +
+                      " has an equal-priority overlap with transition " + std::to_string(error_.detail);
+            break;
+        case ErrorType::UNEXPECTED_END_OF_INPUT:
+            message = "End of stream called before any input was fed";
+            break;
+        default:
+            message = errorTypeToString(error_.type);
+            break;
         }
 
-        transition_map_dirty_ = false;
-    }
-
-    void FSM::sortTransitionsByPriority()
-    {
-        std::sort(transitions_.begin(), transitions_.end(),
-                  [](const Transition &a, const Transition &b)
-                  {
-                      return a.priority > b.priority;
-                  });
-
-        transition_map_dirty_ = true;
-    }
-
-    void FSM::logTransition(const TraceEntry &entry)
-    {
-        auto &os = debug_config_.getOutputStream();
-        os << "[FSM:" << name_ << "] " << entry.toString() << std::endl;
-    }
+        std::string context = error_.position <= run_->current_input.size()
+                                  ? getInputContext(run_->current_input, error_.position)
+                                  : "";
 
-    void FSM::logStateChange(StateID from, StateID to)
-    {
-        auto &os = debug_config_.getOutputStream();
-        os << "[FSM:" << name_ << "] State change: "
-           << from.toString() << " -> " << to.toString() << std::endl;
+        return ValidationError{error_.type, error_.position, error_.character, state, std::move(message),
+                               {}, std::move(context)};
     }
 
-    std::string FSM::getInputContext(std::string_view input, size_t position) const
+    const char *FSM::errorTypeToString(ErrorType type) noexcept
     {
-        const size_t context_size = 10;
-        size_t start = (position > context_size) ? position - context_size : 0;
-        size_t end = std::min(position + context_size, input.size());
-
-        std::string context(input.substr(start, end - start));
-        return context;
+        switch (type)
+        {
+        case ErrorType::NO_MATCHING_TRANSITION:
+            return "NO_MATCHING_TRANSITION";
+        case ErrorType::UNEXPECTED_END_OF_INPUT:
+            return "UNEXPECTED_END_OF_INPUT";
+        case ErrorType::NOT_IN_ACCEPT_STATE:
+            return "NOT_IN_ACCEPT_STATE";
+        case ErrorType::EMBEDDED_FSM_FAILED:
+            return "EMBEDDED_FSM_FAILED";
+        case ErrorType::INVALID_STATE:
+            return "INVALID_STATE";
+        case ErrorType::INVALID_TRANSITION:
+            return "INVALID_TRANSITION";
+        case ErrorType::AMBIGUOUS_TRANSITION:
+            return "AMBIGUOUS_TRANSITION";
+        case ErrorType::NO_START_STATE:
+            return "NO_START_STATE";
+        case ErrorType::UNREACHABLE_STATES:
+            return "UNREACHABLE_STATES";
+        case ErrorType::LENGTH_OUT_OF_RANGE:
+            return "LENGTH_OUT_OF_RANGE";
+        }
+        return "UNKNOWN";
     }
 
-    // ============================================================================
-    // Error Reporting
-    // ============================================================================
-
-    std::optional<FSM::ValidationError> FSM::getLastError() const
+    void FSM::fail(ErrorType type, ErrorSite site, size_t position, char ch, uint32_t state,
+                   const FSM *machine, uint32_t detail) noexcept
     {
-        return last_error_;
+        has_error_ = true;
+        error_ = ErrorRecord{type, site, ch, state, detail, position, machine};
     }
 
     // ============================================================================
@@ -1365,6 +2771,7 @@ namespace fsm
     void FSM::setDebugConfig(const DebugConfig &config)
     {
         debug_config_ = config;
+        transition_map_dirty_ = true; // reruns the analysis so its warnings reach the new stream
     }
 
     DebugConfig &FSM::getDebugConfig()
@@ -1466,9 +2873,9 @@ namespace fsm
             {
                 oss << "ε";
             }
-            else if (trans.type == TransitionType::FSM_INSTANCE && trans.embedded_fsm)
+            else if (trans.type == TransitionType::FSM_INSTANCE)
             {
-                oss << "FSM:" << trans.embedded_fsm->getName();
+                oss << "FSM:" << (trans.embedded_fsm ? trans.embedded_fsm->getName() : "<self>");
             }
 
             if (!trans.description.empty())
@@ -1507,14 +2914,39 @@ namespace fsm
         }
     }
 
-    const std::vector<FSM::TraceEntry> &FSM::getTrace() const
+    std::vector<FSM::TraceEntry> FSM::getTrace() const
+    {
+        const auto &trace = getTraceView();
+        return std::vector<TraceEntry>(trace.begin(), trace.end());
+    }
+
+    const std::pmr::vector<FSM::TraceEntry> &FSM::getTraceView() const
     {
-        return trace_;
+        if (trace_stale_)
+        {
+            run_->trace.clear();
+            trace_stale_ = false;
+        }
+        return run_->trace;
     }
 
     void FSM::clearTrace()
     {
-        trace_.clear();
+        run_->trace.clear();
+        trace_stale_ = false;
+    }
+
+    FSM::TraceEntry &FSM::appendTrace(const StateID &from, const StateID &to, char ch,
+                                      Transition::TransitionID transition_id, const std::string &description)
+    {
+        if (trace_stale_)
+        {
+            run_->trace.clear();
+            trace_stale_ = false;
+        }
+
+        run_->trace.push_back(TraceEntry{run_->trace.size(), from, to, ch, transition_id, description});
+        return run_->trace.back();
     }
 
     const FSM::Metrics &FSM::getMetrics() const
@@ -1527,6 +2959,90 @@ namespace fsm
         metrics_.reset();
     }
 
+    void FSM::setMetricsRegistry(std::shared_ptr<MetricsRegistry> registry)
+    {
+        metrics_registry_ = std::move(registry);
+        metrics_shard_ = metrics_registry_ ? &metrics_registry_->local() : nullptr;
+    }
+
+    const std::shared_ptr<MetricsRegistry> &FSM::getMetricsRegistry() const
+    {
+        return metrics_registry_;
+    }
+
+    void FSM::setTracer(std::shared_ptr<RingTracer> tracer)
+    {
+        tracer_ = std::move(tracer);
+        trace_sampled_ = tracer_ && tracer_->sample(trace_validation_);
+    }
+
+    const std::shared_ptr<RingTracer> &FSM::getTracer() const
+    {
+        return tracer_;
+    }
+
+    void FSM::setMemoryResource(std::pmr::memory_resource *resource)
+    {
+        memory_resource_ = resource ? resource : std::pmr::get_default_resource();
+        allocation_counter_ = dynamic_cast<CountingResource *>(memory_resource_);
+
+        // Drop the old buffers before building new ones on the new resource.
+        run_.reset();
+        run_.emplace(memory_resource_);
+        choice_depth_ = 0;
+        capture_groups_.clear();
+        capture_groups_stale_ = false;
+    }
+
+    std::pmr::memory_resource *FSM::getMemoryResource() const
+    {
+        return memory_resource_;
+    }
+
+    void FSM::applyProfile(const Profile &profile)
+    {
+        if (!profile.machine.empty() && profile.machine != name_)
+        {
+            throw std::invalid_argument("Profile for '" + profile.machine +
+                                        "' cannot be applied to '" + name_ + "'");
+        }
+
+        profile_state_visits_ = profile.state_visits;
+        profile_transition_hits_ = profile.transition_hits;
+        transition_map_dirty_ = true;
+    }
+
+    void FSM::clearProfile()
+    {
+        profile_state_visits_.clear();
+        profile_transition_hits_.clear();
+        transition_map_dirty_ = true;
+    }
+
+    bool FSM::hasProfile() const
+    {
+        return !profile_state_visits_.empty() || !profile_transition_hits_.empty();
+    }
+
+    uint64_t FSM::getProfiledVisits(StateID state) const
+    {
+        return state.id < profile_state_visits_.size() ? profile_state_visits_[state.id] : 0;
+    }
+
+    uint64_t FSM::getProfiledHits(Transition::TransitionID transition_id) const
+    {
+        return transition_id < profile_transition_hits_.size() ? profile_transition_hits_[transition_id] : 0;
+    }
+
+    void FSM::recordOutcome(size_t bytes, bool accepted)
+    {
+        metrics_shard_->recordValidation(bytes);
+        if (!accepted && has_error_)
+        {
+            metrics_shard_->recordReject(error_.type);
+        }
+    }
+
     // ============================================================================
     // Validation
     // ============================================================================
@@ -1573,6 +3089,137 @@ namespace fsm
         return issues;
     }
 
+    // ============================================================================
+    // Static Analysis
+    // ============================================================================
+
+    FSM::Reachability FSM::analyzeReachability() const
+    {
+        uint32_t max_id = start_state_.id;
+        for (const auto &[id, state] : states_)
+        {
+            max_id = std::max(max_id, id.id);
+        }
+
+        Reachability result;
+        result.reachable.assign(static_cast<size_t>(max_id) + 1, 0);
+        result.live.assign(static_cast<size_t>(max_id) + 1, 0);
+
+        // Every transition kind counts: a path is a path whichever engine runs it.
+        std::vector<std::vector<uint32_t>> forward(result.live.size());
+        std::vector<std::vector<uint32_t>> backward(result.live.size());
+        for (const auto &trans : transitions_)
+        {
+            if (trans.from.id <= max_id && trans.to.id <= max_id)
+            {
+                forward[trans.from.id].push_back(trans.to.id);
+                backward[trans.to.id].push_back(trans.from.id);
+            }
+        }
+
+        auto flood = [](const std::vector<std::vector<uint32_t>> &graph, std::vector<uint32_t> pending,
+                        std::vector<uint8_t> &marked)
+        {
+            for (uint32_t id : pending)
+            {
+                marked[id] = 1;
+            }
+            while (!pending.empty())
+            {
+                const uint32_t id = pending.back();
+                pending.pop_back();
+                for (uint32_t next : graph[id])
+                {
+                    if (!marked[next])
+                    {
+                        marked[next] = 1;
+                        pending.push_back(next);
+                    }
+                }
+            }
+        };
+
+        if (start_state_.isValid() && hasState(start_state_))
+        {
+            flood(forward, {start_state_.id}, result.reachable);
+        }
+
+        std::vector<uint32_t> accepting;
+        for (const auto &accept : accept_states_)
+        {
+            if (hasState(accept))
+            {
+                accepting.push_back(accept.id);
+            }
+        }
+        flood(backward, std::move(accepting), result.live);
+
+        return result;
+    }
+
+    std::vector<StateID> FSM::getUnreachableStates() const
+    {
+        const Reachability reach = analyzeReachability();
+
+        std::vector<StateID> unreachable;
+        for (const auto &[id, state] : states_)
+        {
+            if (!reach.reachable[id.id])
+            {
+                unreachable.push_back(id);
+            }
+        }
+        std::sort(unreachable.begin(), unreachable.end());
+        return unreachable;
+    }
+
+    std::vector<StateID> FSM::getDeadStates() const
+    {
+        const Reachability reach = analyzeReachability();
+
+        std::vector<StateID> dead;
+        for (const auto &[id, state] : states_)
+        {
+            if (!reach.live[id.id])
+            {
+                dead.push_back(id);
+            }
+        }
+        std::sort(dead.begin(), dead.end());
+        return dead;
+    }
+
+    bool FSM::isDeadState(StateID state) const
+    {
+        const_cast<FSM *>(this)->rebuildTransitionMap();
+        return hasState(state) && (state.id >= live_states_.size() || !live_states_[state.id]);
+    }
+
+    size_t FSM::pruneUnreachableStates()
+    {
+        const Reachability reach = analyzeReachability();
+        const size_t before = states_.size();
+
+        for (auto it = states_.begin(); it != states_.end();)
+        {
+            it = reach.reachable[it->first.id] ? std::next(it) : states_.erase(it);
+        }
+
+        for (auto it = accept_states_.begin(); it != accept_states_.end();)
+        {
+            it = reach.reachable[it->id] ? std::next(it) : accept_states_.erase(it);
+        }
+
+        // A reachable state's transitions only lead to reachable states.
+        transitions_.erase(std::remove_if(transitions_.begin(), transitions_.end(),
+                                          [&reach](const Transition &trans)
+                                          { return !reach.reachable[trans.from.id]; }),
+                           transitions_.end());
+
+        transition_map_dirty_ = true;
+        return before - states_.size();
+    }
+
     // ============================================================================
     // Introspection
     // ============================================================================
@@ -1605,14 +3252,17 @@ namespace fsm
 
     std::vector<Transition *> FSM::getTransitionsFrom(StateID state) const
     {
+        return transitionsFrom(state);
+    }
+
+    const std::vector<Transition *> &FSM::transitionsFrom(const StateID &state) const
+    {
+        static const std::vector<Transition *> none;
+
         const_cast<FSM *>(this)->rebuildTransitionMap();
 
         auto it = transition_map_.find(state);
-        if (it == transition_map_.end())
-        {
-            return {};
-        }
-        return it->second;
+        return it == transition_map_.end() ? none : it->second;
     }
 
     const std::string &FSM::getName() const
@@ -1638,6 +3288,7 @@ namespace fsm
                                         state.toString());
         }
         it->second.on_entry = std::move(callback);
+        transition_map_dirty_ = true; // accept sinks and engine choice look at callbacks
     }
 
     void FSM::setStateExitCallback(StateID state, StateExitCallback callback)
@@ -1649,6 +3300,7 @@ namespace fsm
                                         state.toString());
         }
         it->second.on_exit = std::move(callback);
+        transition_map_dirty_ = true;
     }
 
     void FSM::setTransitionCallback(Transition::TransitionID transition_id,
@@ -1659,6 +3311,7 @@ namespace fsm
             if (trans.id == transition_id)
             {
                 trans.on_transition = std::move(callback);
+                transition_map_dirty_ = true; // runtime edges cache HAS_CALLBACK
                 return;
             }
         }
@@ -1666,6 +3319,20 @@ namespace fsm
                                     std::to_string(transition_id));
     }
 
+    void FSM::setTransitionAction(Transition::TransitionID transition_id, Transition::ActionID action)
+    {
+        for (auto &trans : transitions_)
+        {
+            if (trans.id == transition_id)
+            {
+                trans.action = action;
+                return;
+            }
+        }
+        throw std::invalid_argument("Cannot set action for non-existent transition ID: " +
+                                    std::to_string(transition_id));
+    }
+
     void FSM::setUserData(void *data)
     {
         user_data_ = data;
@@ -1682,82 +3349,145 @@ namespace fsm
 
     void FSM::beginCapture(const std::string &name)
     {
-        for (const auto &active : active_captures_)
+        const uint32_t name_index = internCaptureName(name);
+
+        for (const auto &active : run_->active_captures)
         {
-            if (active.name == name)
+            if (active.name == name_index)
             {
                 throw std::logic_error("Capture group '" + name + "' is already active");
             }
         }
 
-        active_captures_.emplace_back(name, current_input_position_);
+        run_->active_captures.push_back(CaptureSpan{name_index, current_input_position_, current_input_position_});
     }
 
     CaptureGroup FSM::endCapture(const std::string &name)
     {
-        for (auto it = active_captures_.begin(); it != active_captures_.end(); ++it)
+        for (auto it = run_->active_captures.begin(); it != run_->active_captures.end(); ++it)
         {
-            if (it->name == name)
+            if (std::string_view(run_->capture_names[it->name]) == name)
             {
-                CaptureGroup capture(
-                    it->name,
-                    it->start_position,
-                    current_input_position_,
-                    it->buffer);
+                CaptureSpan span{it->name, it->start_position, current_input_position_};
+
+                CaptureSlot &slot = run_->capture_slots[span.name];
+                if (slot.generation != capture_generation_)
+                {
+                    slot = CaptureSlot{capture_generation_, static_cast<uint32_t>(run_->captures.size())};
+                }
 
-                captures_.push_back(capture);
-                active_captures_.erase(it);
+                run_->captures.push_back(span);
+                run_->active_captures.erase(it);
+                capture_groups_stale_ = true;
 
-                return capture;
+                return renderCapture(span);
             }
         }
 
         throw std::logic_error("No active capture group named '" + name + "'");
     }
 
-    void FSM::recordCharInCaptures(char ch)
+    uint32_t FSM::internCaptureName(const std::string &name)
     {
-        for (auto &active : active_captures_)
+        for (size_t i = 0; i < run_->capture_names.size(); ++i)
         {
-            active.buffer += ch;
+            if (std::string_view(run_->capture_names[i]) == name)
+            {
+                return static_cast<uint32_t>(i);
+            }
         }
+
+        run_->capture_names.emplace_back(name.data(), name.size());
+        run_->capture_slots.push_back(CaptureSlot{0, 0});
+        return static_cast<uint32_t>(run_->capture_names.size() - 1);
     }
 
-    std::optional<CaptureGroup> FSM::getCapture(const std::string &name) const
+    const CaptureSpan *FSM::findCapture(const std::string &name) const
+    {
+        for (size_t i = 0; i < run_->capture_names.size(); ++i)
+        {
+            if (std::string_view(run_->capture_names[i]) == name)
+            {
+                const CaptureSlot &slot = run_->capture_slots[i];
+                return slot.generation == capture_generation_ && slot.index < run_->captures.size()
+                           ? &run_->captures[slot.index]
+                           : nullptr;
+            }
+        }
+        return nullptr;
+    }
+
+    void FSM::stampCaptureSlots()
     {
-        for (const auto &capture : captures_)
+        // Captures were replaced wholesale (choice point restore): start a new
+        // generation and point each name at its first surviving capture.
+        capture_generation_++;
+
+        for (size_t i = 0; i < run_->captures.size(); ++i)
         {
-            if (capture.name == name)
+            CaptureSlot &slot = run_->capture_slots[run_->captures[i].name];
+            if (slot.generation != capture_generation_)
             {
-                return capture;
+                slot = CaptureSlot{capture_generation_, static_cast<uint32_t>(i)};
             }
         }
+
+        capture_groups_stale_ = true;
+    }
+
+    CaptureGroup FSM::renderCapture(const CaptureSpan &span) const
+    {
+        // Captured bytes are always a slice of the input seen so far.
+        const size_t start = std::min(span.start_position, run_->current_input.size());
+        const size_t end = std::min(std::max(span.end_position, start), run_->current_input.size());
+
+        return CaptureGroup(std::string(run_->capture_names[span.name]), span.start_position, span.end_position,
+                            std::string(run_->current_input.data() + start, end - start));
+    }
+
+    std::optional<CaptureGroup> FSM::getCapture(const std::string &name) const
+    {
+        if (const CaptureSpan *capture = findCapture(name))
+        {
+            return renderCapture(*capture);
+        }
         return std::nullopt;
     }
 
     const std::vector<CaptureGroup> &FSM::getAllCaptures() const
     {
-        return captures_;
+        if (capture_groups_stale_)
+        {
+            capture_groups_.clear();
+            for (const auto &capture : run_->captures)
+            {
+                capture_groups_.push_back(renderCapture(capture));
+            }
+            capture_groups_stale_ = false;
+        }
+        return capture_groups_;
     }
 
     std::optional<CaptureGroup> FSM::getCaptureByIndex(size_t index) const
     {
-        if (index < captures_.size())
+        if (index < run_->captures.size())
         {
-            return captures_[index];
+            return renderCapture(run_->captures[index]);
         }
         return std::nullopt;
     }
 
     void FSM::clearCaptures()
     {
-        captures_.clear();
-        active_captures_.clear();
+        run_->captures.clear();
+        run_->active_captures.clear();
+        capture_generation_++;
+        capture_groups_stale_ = true;
     }
 
     bool FSM::hasCapture(const std::string &name) const
     {
-        return getCapture(name).has_value();
+        return findCapture(name) != nullptr;
     }
 
     void FSM::updateCapturePosition(size_t pos)
@@ -1887,6 +3617,32 @@ namespace fsm
         return *this;
     }
 
+    FSM::Builder &FSM::Builder::callSubMachine(const std::string &from, const std::string &to,
+                                               std::shared_ptr<FSM> fsm, int priority)
+    {
+        if (!fsm)
+        {
+            throw std::invalid_argument("Cannot call null FSM");
+        }
+
+        StateID from_id = getOrCreateState(from);
+        StateID to_id = getOrCreateState(to);
+
+        transitions_.push_back(Transition(static_cast<Transition::TransitionID>(transitions_.size() + 1),
+                                          from_id, to_id, std::move(fsm), priority));
+        return *this;
+    }
+
+    FSM::Builder &FSM::Builder::callSelf(const std::string &from, const std::string &to, int priority)
+    {
+        StateID from_id = getOrCreateState(from);
+        StateID to_id = getOrCreateState(to);
+
+        transitions_.push_back(Transition(static_cast<Transition::TransitionID>(transitions_.size() + 1),
+                                          from_id, to_id, std::shared_ptr<FSM>(), priority));
+        return *this;
+    }
+
     FSM::Builder &FSM::Builder::setDebugFlags(DebugFlags flags)
     {
         debug_config_.flags = flags;
@@ -1975,6 +3731,18 @@ namespace fsm
         return *this;
     }
 
+    FSM::Builder &FSM::Builder::withAction(Transition::ActionID action)
+    {
+        if (transitions_.empty())
+        {
+            throw std::logic_error("No transitions added yet.  Call addTransition first.");
+        }
+
+        transitions_.back().action = action;
+
+        return *this;
+    }
+
     FSM::Builder &FSM::Builder::withUserData(void *data)
     {
         user_data_ = data;
@@ -0,0 +1,413 @@
+#include <fsm/instrumentation.hpp>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace fsm
+{
+    namespace
+    {
+        // Serials are never reused, so a thread's cached shard can't outlive
+        // its registry and be mistaken for a new one at the same address.
+        std::atomic<uint64_t> next_registry_serial{1};
+
+        // Serials of live registries. Destroying one bumps the generation,
+        // which tells every thread to prune its cache on the next miss.
+        struct LiveRegistries
+        {
+            std::mutex mutex;
+            std::unordered_set<uint64_t> serials;
+            std::atomic<uint64_t> generation{0};
+        };
+
+        // Never destroyed, so registries with static lifetime can still
+        // unregister at exit.
+        LiveRegistries &liveRegistries()
+        {
+            static LiveRegistries *live = new LiveRegistries;
+            return *live;
+        }
+
+        struct ThreadCache
+        {
+            std::unordered_map<uint64_t, MetricsShard *> shards;
+            uint64_t generation = 0;
+        };
+
+        ThreadCache &threadCache()
+        {
+            thread_local ThreadCache cache;
+            return cache;
+        }
+    }
+
+    // ============================================================================
+    // Shard Implementation
+    // ============================================================================
+
+    MetricsShard::MetricsShard(size_t state_slots, size_t transition_slots)
+        : state_slots_(state_slots), transition_slots_(transition_slots),
+          state_visits_(new std::atomic<uint64_t>[state_slots]()),
+          transition_hits_(new std::atomic<uint64_t>[transition_slots]())
+    {
+    }
+
+    // ============================================================================
+    // MetricsRegistry Implementation
+    // ============================================================================
+
+    MetricsRegistry::MetricsRegistry(size_t state_slots, size_t transition_slots)
+        : serial_(next_registry_serial.fetch_add(1, std::memory_order_relaxed)),
+          state_slots_(state_slots), transition_slots_(transition_slots)
+    {
+        LiveRegistries &live = liveRegistries();
+        std::lock_guard<std::mutex> lock(live.mutex);
+        live.serials.insert(serial_);
+    }
+
+    MetricsRegistry::~MetricsRegistry()
+    {
+        LiveRegistries &live = liveRegistries();
+        std::lock_guard<std::mutex> lock(live.mutex);
+        live.serials.erase(serial_);
+        live.generation.fetch_add(1, std::memory_order_release);
+    }
+
+    MetricsRegistry::MetricsRegistry(const FSM &fsm)
+        : MetricsRegistry(0, 0)
+    {
+        for (const auto &state : fsm.getStates())
+        {
+            state_slots_ = std::max<size_t>(state_slots_, state.id + 1);
+        }
+
+        for (const auto &trans : fsm.getTransitions())
+        {
+            transition_slots_ = std::max<size_t>(transition_slots_, trans.id + 1);
+        }
+    }
+
+    MetricsRegistry::Shard &MetricsRegistry::local()
+    {
+        thread_local uint64_t cached_serial = 0;
+        thread_local Shard *cached_shard = nullptr;
+
+        if (cached_serial == serial_)
+        {
+            return *cached_shard;
+        }
+
+        ThreadCache &cache = threadCache();
+        LiveRegistries &live = liveRegistries();
+        const uint64_t generation = live.generation.load(std::memory_order_acquire);
+        if (cache.generation != generation)
+        {
+            std::lock_guard<std::mutex> lock(live.mutex);
+            for (auto it = cache.shards.begin(); it != cache.shards.end();)
+            {
+                it = live.serials.count(it->first) ? std::next(it) : cache.shards.erase(it);
+            }
+            cache.generation = generation;
+        }
+
+        Shard *&shard = cache.shards[serial_];
+        if (!shard)
+        {
+            auto owned = std::make_unique<Shard>(state_slots_, transition_slots_);
+            shard = owned.get();
+
+            std::lock_guard<std::mutex> lock(shards_mutex_);
+            shards_.push_back(std::move(owned));
+        }
+
+        cached_serial = serial_;
+        cached_shard = shard;
+        return *shard;
+    }
+
+    size_t MetricsRegistry::getThreadCacheSize()
+    {
+        return threadCache().shards.size();
+    }
+
+    MetricsRegistry::Snapshot MetricsRegistry::snapshot() const
+    {
+        Snapshot result;
+        result.state_visits.assign(state_slots_, 0);
+        result.transition_hits.assign(transition_slots_, 0);
+
+        std::lock_guard<std::mutex> lock(shards_mutex_);
+        result.shard_count = shards_.size();
+
+        for (const auto &shard : shards_)
+        {
+            result.validations += shard->validations_.load(std::memory_order_relaxed);
+            result.bytes += shard->bytes_.load(std::memory_order_relaxed);
+
+            for (size_t i = 0; i < ERROR_TYPE_COUNT; ++i)
+            {
+                result.rejects[i] += shard->rejects_[i].load(std::memory_order_relaxed);
+            }
+            for (size_t i = 0; i < state_slots_; ++i)
+            {
+                result.state_visits[i] += shard->state_visits_[i].load(std::memory_order_relaxed);
+            }
+            for (size_t i = 0; i < transition_slots_; ++i)
+            {
+                result.transition_hits[i] += shard->transition_hits_[i].load(std::memory_order_relaxed);
+            }
+        }
+
+        return result;
+    }
+
+    // Counts recorded concurrently with reset() may survive it.
+    void MetricsRegistry::reset()
+    {
+        std::lock_guard<std::mutex> lock(shards_mutex_);
+
+        for (const auto &shard : shards_)
+        {
+            shard->validations_.store(0, std::memory_order_relaxed);
+            shard->bytes_.store(0, std::memory_order_relaxed);
+
+            for (auto &counter : shard->rejects_)
+            {
+                counter.store(0, std::memory_order_relaxed);
+            }
+            for (size_t i = 0; i < state_slots_; ++i)
+            {
+                shard->state_visits_[i].store(0, std::memory_order_relaxed);
+            }
+            for (size_t i = 0; i < transition_slots_; ++i)
+            {
+                shard->transition_hits_[i].store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    size_t MetricsRegistry::getShardCount() const
+    {
+        std::lock_guard<std::mutex> lock(shards_mutex_);
+        return shards_.size();
+    }
+
+    // ============================================================================
+    // Snapshot Implementation
+    // ============================================================================
+
+    uint64_t MetricsRegistry::Snapshot::getRejects() const
+    {
+        uint64_t total = 0;
+        for (uint64_t count : rejects)
+        {
+            total += count;
+        }
+        return total;
+    }
+
+    uint64_t MetricsRegistry::Snapshot::getRejects(FSM::ErrorType type) const
+    {
+        return rejects[static_cast<size_t>(type)];
+    }
+
+    std::string MetricsRegistry::Snapshot::toString() const
+    {
+        std::ostringstream oss;
+        oss << "RegistryMetrics{"
+            << "validations=" << validations
+            << ", accepted=" << getAccepted()
+            << ", bytes=" << bytes
+            << ", shards=" << shard_count;
+
+        for (size_t i = 0; i < ERROR_TYPE_COUNT; ++i)
+        {
+            if (rejects[i] > 0)
+            {
+                oss << ", " << FSM::errorTypeToString(static_cast<FSM::ErrorType>(i)) << "=" << rejects[i];
+            }
+        }
+
+        oss << ", states={";
+        const char *sep = "";
+        for (size_t i = 0; i < state_visits.size(); ++i)
+        {
+            if (state_visits[i] > 0)
+            {
+                oss << sep << i << ":" << state_visits[i];
+                sep = ", ";
+            }
+        }
+
+        oss << "}, transitions={";
+        sep = "";
+        for (size_t i = 0; i < transition_hits.size(); ++i)
+        {
+            if (transition_hits[i] > 0)
+            {
+                oss << sep << i << ":" << transition_hits[i];
+                sep = ", ";
+            }
+        }
+
+        oss << "}}";
+        return oss.str();
+    }
+
+    // ============================================================================
+    // Profile Implementation
+    // ============================================================================
+
+    Profile Profile::fromSnapshot(const std::string &machine, const MetricsRegistry::Snapshot &snapshot)
+    {
+        return Profile{machine, snapshot.state_visits, snapshot.transition_hits};
+    }
+
+    void Profile::merge(const Profile &other)
+    {
+        if (!machine.empty() && !other.machine.empty() && machine != other.machine)
+        {
+            throw std::invalid_argument("Cannot merge profile of '" + other.machine +
+                                        "' into profile of '" + machine + "'");
+        }
+
+        if (machine.empty())
+        {
+            machine = other.machine;
+        }
+
+        auto add = [](std::vector<uint64_t> &into, const std::vector<uint64_t> &from)
+        {
+            if (into.size() < from.size())
+            {
+                into.resize(from.size(), 0);
+            }
+            for (size_t i = 0; i < from.size(); ++i)
+            {
+                into[i] += from[i];
+            }
+        };
+
+        add(state_visits, other.state_visits);
+        add(transition_hits, other.transition_hits);
+    }
+
+    void Profile::write(std::ostream &os) const
+    {
+        os << "fsm-profile 1\n";
+        os << "machine " << machine << "\n";
+
+        for (size_t i = 0; i < state_visits.size(); ++i)
+        {
+            if (state_visits[i] > 0)
+            {
+                os << "state " << i << " " << state_visits[i] << "\n";
+            }
+        }
+
+        for (size_t i = 0; i < transition_hits.size(); ++i)
+        {
+            if (transition_hits[i] > 0)
+            {
+                os << "transition " << i << " " << transition_hits[i] << "\n";
+            }
+        }
+    }
+
+    Profile Profile::read(std::istream &is, uint64_t max_id)
+    {
+        Profile profile;
+        std::string line;
+        size_t line_number = 0;
+
+        auto fail = [&line_number](const std::string &what)
+        {
+            throw std::runtime_error("Invalid profile at line " + std::to_string(line_number) + ": " + what);
+        };
+
+        if (!std::getline(is, line) || line != "fsm-profile 1")
+        {
+            line_number = 1;
+            fail("expected 'fsm-profile 1' header");
+        }
+        line_number = 1;
+
+        while (std::getline(is, line))
+        {
+            line_number++;
+            if (line.empty() || line[0] == '#')
+            {
+                continue;
+            }
+
+            std::istringstream fields(line);
+            std::string kind;
+            fields >> kind;
+
+            if (kind == "machine")
+            {
+                std::getline(fields >> std::ws, profile.machine);
+                continue;
+            }
+
+            uint64_t id = 0;
+            uint64_t count = 0;
+            if (!(fields >> id >> count))
+            {
+                fail("expected '<kind> <id> <count>'");
+            }
+
+            std::vector<uint64_t> *counts = nullptr;
+            if (kind == "state")
+            {
+                counts = &profile.state_visits;
+            }
+            else if (kind == "transition")
+            {
+                counts = &profile.transition_hits;
+            }
+            else
+            {
+                fail("unknown record '" + kind + "'");
+            }
+
+            if (id > max_id)
+            {
+                fail("id " + std::to_string(id) + " above limit " + std::to_string(max_id));
+            }
+            if (counts->size() <= id)
+            {
+                counts->resize(id + 1, 0);
+            }
+            (*counts)[id] += count;
+        }
+
+        return profile;
+    }
+
+    void Profile::save(const std::string &filename) const
+    {
+        std::ofstream file(filename);
+        if (!file.is_open())
+        {
+            throw std::runtime_error("Failed to open file for profile export: " + filename);
+        }
+
+        write(file);
+    }
+
+    Profile Profile::load(const std::string &filename, uint64_t max_id)
+    {
+        std::ifstream file(filename);
+        if (!file.is_open())
+        {
+            throw std::runtime_error("Failed to open profile: " + filename);
+        }
+
+        return read(file, max_id);
+    }
+
+} // namespace fsm
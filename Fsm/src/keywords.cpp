@@ -0,0 +1,379 @@
+#include <fsm/keywords.hpp>
+#include <fsm/compiled.hpp>
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+namespace fsm
+{
+    // ============================================================================
+    // KeywordSet Construction
+    // ============================================================================
+
+    namespace
+    {
+        // Bits needed to index at least n entries
+        unsigned indexBits(size_t n)
+        {
+            unsigned bits = 0;
+            while ((size_t{1} << bits) < n)
+            {
+                ++bits;
+            }
+            return bits;
+        }
+
+        // Depth-first in byte order, so keywords come out sorted. Only states
+        // that can still accept are entered; the FSM's finite length bounds
+        // keep the depth under MAX_LENGTH.
+        void collectKeywords(const CompiledFSM &compiled, const std::vector<uint8_t> &live,
+                             CompiledFSM::StateIndex state, std::string &prefix, size_t limit,
+                             std::vector<std::pair<std::string, StateID>> &out)
+        {
+            if (compiled.isAcceptingAtEnd(state))
+            {
+                if (out.size() == limit)
+                {
+                    throw std::invalid_argument("FSM '" + compiled.getName() + "' accepts more than " +
+                                                std::to_string(limit) + " strings");
+                }
+                out.emplace_back(prefix, compiled.getStateID(compiled.getFinalState(state)));
+            }
+
+            for (int byte = 0; byte < 256; ++byte)
+            {
+                const CompiledFSM::StateIndex next = compiled.next(state, static_cast<unsigned char>(byte));
+                if (next == CompiledFSM::DEAD_STATE || !live[next])
+                {
+                    continue;
+                }
+                prefix.push_back(static_cast<char>(byte));
+                collectKeywords(compiled, live, next, prefix, limit, out);
+                prefix.pop_back();
+            }
+        }
+    }
+
+    KeywordSet::Builder &KeywordSet::Builder::add(std::string keyword)
+    {
+        keywords_.push_back(std::move(keyword));
+        return *this;
+    }
+
+    KeywordSet KeywordSet::Builder::build()
+    {
+        return KeywordSet(std::move(keywords_));
+    }
+
+    KeywordSet::KeywordSet(std::vector<std::string> keywords)
+    {
+        compile(std::move(keywords));
+    }
+
+    KeywordSet::KeywordSet(const FSM &fsm, size_t limit)
+    {
+        const FSM::LengthBounds bounds = fsm.getLengthBounds();
+        if (!bounds.finite)
+        {
+            throw std::invalid_argument("FSM '" + fsm.getName() + "' does not accept a finite language");
+        }
+        if (bounds.max > MAX_LENGTH)
+        {
+            throw std::invalid_argument("FSM '" + fsm.getName() + "' accepts strings longer than " +
+                                        std::to_string(MAX_LENGTH) + " bytes");
+        }
+
+        const CompiledFSM compiled(fsm);
+        const size_t state_count = compiled.getStateCount();
+
+        // States that can still end in acceptance, by backward fixpoint.
+        std::vector<uint8_t> live(state_count);
+        for (CompiledFSM::StateIndex s = 0; s < state_count; ++s)
+        {
+            live[s] = compiled.isAcceptingAtEnd(s) ? 1 : 0;
+        }
+
+        bool changed = true;
+        while (changed)
+        {
+            changed = false;
+            for (CompiledFSM::StateIndex s = 0; s < state_count; ++s)
+            {
+                for (int byte = 0; byte < 256 && !live[s]; ++byte)
+                {
+                    const CompiledFSM::StateIndex next = compiled.next(s, static_cast<unsigned char>(byte));
+                    if (next != CompiledFSM::DEAD_STATE && live[next])
+                    {
+                        live[s] = 1;
+                        changed = true;
+                    }
+                }
+            }
+        }
+
+        std::vector<std::pair<std::string, StateID>> accepted;
+        const CompiledFSM::StateIndex start = compiled.getStartState();
+        if (start != CompiledFSM::DEAD_STATE && live[start])
+        {
+            std::string prefix;
+            collectKeywords(compiled, live, start, prefix, limit, accepted);
+        }
+
+        std::vector<std::string> keywords;
+        keywords.reserve(accepted.size());
+        final_states_.reserve(accepted.size());
+        for (auto &[keyword, final_state] : accepted)
+        {
+            keywords.push_back(std::move(keyword));
+            final_states_.push_back(final_state);
+        }
+
+        compile(std::move(keywords));
+    }
+
+    void KeywordSet::compile(std::vector<std::string> keywords)
+    {
+        std::vector<std::string_view> sorted(keywords.begin(), keywords.end());
+        std::sort(sorted.begin(), sorted.end());
+        const auto duplicate = std::adjacent_find(sorted.begin(), sorted.end());
+        if (duplicate != sorted.end())
+        {
+            throw std::invalid_argument("KeywordSet: duplicate keyword '" + std::string(*duplicate) + "'");
+        }
+
+        entries_.reserve(keywords.size());
+        for (const std::string &keyword : keywords)
+        {
+            if (keyword.size() > MAX_LENGTH)
+            {
+                throw std::invalid_argument("KeywordSet: keyword longer than " + std::to_string(MAX_LENGTH) +
+                                            " bytes");
+            }
+
+            entries_.push_back({static_cast<uint32_t>(pool_.size()), static_cast<uint32_t>(keyword.size())});
+            pool_ += keyword;
+            lengths_[keyword.size() >> 6] |= uint64_t{1} << (keyword.size() & 63);
+        }
+
+        choosePositions(keywords);
+        buildTable();
+    }
+
+    // ============================================================================
+    // Key Selection
+    // ============================================================================
+    //
+    // Greedy, as in gperf: start from the length alone and keep adding the
+    // byte position (from either end) that separates the most keywords,
+    // until every keyword has its own key. Two keywords of equal length
+    // differ somewhere, so each round makes progress. Past seven positions
+    // the key no longer packs into 64 bits and the whole string is hashed.
+
+    void KeywordSet::choosePositions(const std::vector<std::string> &keywords)
+    {
+        positions_.clear();
+        whole_key_ = false;
+
+        size_t longest = 0;
+        for (const std::string &keyword : keywords)
+        {
+            longest = std::max(longest, keyword.size());
+        }
+
+        std::vector<uint64_t> keys(keywords.size());
+        auto distinctKeys = [&]()
+        {
+            for (size_t i = 0; i < keywords.size(); ++i)
+            {
+                keys[i] = key(keywords[i]);
+            }
+            std::sort(keys.begin(), keys.end());
+            return static_cast<size_t>(std::unique(keys.begin(), keys.end()) - keys.begin());
+        };
+
+        size_t distinct = distinctKeys();
+        while (distinct < keywords.size())
+        {
+            if (positions_.size() == 7)
+            {
+                positions_.clear();
+                whole_key_ = true;
+                return;
+            }
+
+            int16_t best_position = 0;
+            size_t best_distinct = distinct;
+            for (int offset = 0; offset < static_cast<int>(longest); ++offset)
+            {
+                for (int16_t position : {static_cast<int16_t>(offset), static_cast<int16_t>(-1 - offset)})
+                {
+                    positions_.push_back(position);
+                    const size_t candidate = distinctKeys();
+                    positions_.pop_back();
+
+                    if (candidate > best_distinct)
+                    {
+                        best_position = position;
+                        best_distinct = candidate;
+                    }
+                }
+            }
+
+            positions_.push_back(best_position);
+            distinct = best_distinct;
+        }
+    }
+
+    // ============================================================================
+    // Hash-and-Displace Table
+    // ============================================================================
+    //
+    // Keys are split into buckets of about four; the largest buckets are
+    // placed first, each trying seeds until all its keys land in free slots.
+    // A lookup is therefore one bucket read and one slot read. With 25% spare
+    // slots a seed is found quickly; the table doubles if one is not.
+
+    void KeywordSet::buildTable()
+    {
+        constexpr uint32_t MAX_SEED = 1u << 16;
+
+        const size_t count = entries_.size();
+        std::vector<uint64_t> hashes(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            hashes[i] = scramble(key(std::string_view(pool_.data() + entries_[i].offset, entries_[i].length)));
+        }
+
+        std::vector<uint64_t> unique_hashes = hashes;
+        std::sort(unique_hashes.begin(), unique_hashes.end());
+        if (std::adjacent_find(unique_hashes.begin(), unique_hashes.end()) != unique_hashes.end())
+        {
+            throw std::runtime_error("KeywordSet: keyword hashes collide");
+        }
+
+        // A shift of 64 would be undefined, so one-entry levels use bit 63.
+        const unsigned bucket_bits = std::max(1u, indexBits((count + 3) / 4));
+        const size_t bucket_count = size_t{1} << bucket_bits;
+        bucket_shift_ = 64 - bucket_bits;
+
+        std::vector<std::vector<uint32_t>> buckets(bucket_count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            buckets[hashes[i] >> bucket_shift_].push_back(static_cast<uint32_t>(i));
+        }
+
+        std::vector<uint32_t> order(bucket_count);
+        for (uint32_t b = 0; b < bucket_count; ++b)
+        {
+            order[b] = b;
+        }
+        std::stable_sort(order.begin(), order.end(), [&buckets](uint32_t a, uint32_t b)
+                         { return buckets[a].size() > buckets[b].size(); });
+
+        std::vector<uint64_t> placed;
+        for (unsigned slot_bits = std::max(1u, indexBits(count + count / 4 + 1));; ++slot_bits)
+        {
+            slot_shift_ = 64 - slot_bits;
+            slots_.assign(size_t{1} << slot_bits, NO_KEYWORD);
+            seeds_.assign(bucket_count, 0);
+
+            bool complete = true;
+            for (uint32_t b : order)
+            {
+                const std::vector<uint32_t> &bucket = buckets[b];
+                if (bucket.empty())
+                {
+                    break;
+                }
+
+                bool fits = false;
+                for (uint32_t seed = 0; seed < MAX_SEED && !fits; ++seed)
+                {
+                    placed.clear();
+                    fits = true;
+                    for (uint32_t i : bucket)
+                    {
+                        const uint64_t slot = slotHash(hashes[i], seed) >> slot_shift_;
+                        if (slots_[slot] != NO_KEYWORD || std::find(placed.begin(), placed.end(), slot) != placed.end())
+                        {
+                            fits = false;
+                            break;
+                        }
+                        placed.push_back(slot);
+                    }
+
+                    if (fits)
+                    {
+                        seeds_[b] = seed;
+                        for (size_t k = 0; k < bucket.size(); ++k)
+                        {
+                            slots_[placed[k]] = bucket[k];
+                        }
+                    }
+                }
+
+                if (!fits)
+                {
+                    complete = false;
+                    break;
+                }
+            }
+
+            if (complete)
+            {
+                return;
+            }
+        }
+    }
+
+    // ============================================================================
+    // KeywordSet Queries
+    // ============================================================================
+
+    std::string_view KeywordSet::getKeyword(KeywordID id) const
+    {
+        const Entry &entry = entries_.at(id);
+        return std::string_view(pool_.data() + entry.offset, entry.length);
+    }
+
+    std::vector<std::string> KeywordSet::getKeywords() const
+    {
+        std::vector<std::string> keywords;
+        keywords.reserve(entries_.size());
+        for (KeywordID id = 0; id < entries_.size(); ++id)
+        {
+            keywords.emplace_back(getKeyword(id));
+        }
+        return keywords;
+    }
+
+    const StateID &KeywordSet::getFinalState(KeywordID id) const
+    {
+        if (final_states_.empty())
+        {
+            throw std::logic_error("KeywordSet was not built from an FSM");
+        }
+        return final_states_.at(id);
+    }
+
+    std::string KeywordSet::toString() const
+    {
+        std::ostringstream oss;
+        oss << "KeywordSet(" << entries_.size() << (entries_.size() == 1 ? " keyword" : " keywords") << ", key: ";
+        if (whole_key_)
+        {
+            oss << "whole string";
+        }
+        else
+        {
+            oss << "length";
+            for (int16_t position : positions_)
+            {
+                oss << " + [" << position << "]";
+            }
+        }
+        oss << ", " << slots_.size() << " slots)";
+        return oss.str();
+    }
+
+} // namespace fsm
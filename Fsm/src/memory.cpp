@@ -0,0 +1,78 @@
+#include <fsm/memory.hpp>
+#include <fsm/fsm.hpp>
+#include <sstream>
+#include <stdexcept>
+
+namespace fsm
+{
+    // ============================================================================
+    // CountingResource Implementation
+    // ============================================================================
+
+    CountingResource::CountingResource(std::pmr::memory_resource *upstream)
+        : upstream_(upstream)
+    {
+        if (!upstream_)
+        {
+            throw std::invalid_argument("CountingResource requires an upstream resource");
+        }
+    }
+
+    void CountingResource::reset() noexcept
+    {
+        allocations_.store(0, std::memory_order_relaxed);
+        deallocations_.store(0, std::memory_order_relaxed);
+        bytes_allocated_.store(0, std::memory_order_relaxed);
+    }
+
+    std::string CountingResource::toString() const
+    {
+        std::ostringstream oss;
+        oss << "CountingResource{"
+            << "allocations=" << getAllocations()
+            << ", deallocations=" << getDeallocations()
+            << ", bytes=" << getBytesAllocated()
+            << ", in_use=" << getBytesInUse()
+            << "}";
+        return oss.str();
+    }
+
+    void *CountingResource::do_allocate(size_t bytes, size_t alignment)
+    {
+        void *p = upstream_->allocate(bytes, alignment);
+
+        allocations_.fetch_add(1, std::memory_order_relaxed);
+        bytes_allocated_.fetch_add(bytes, std::memory_order_relaxed);
+        bytes_in_use_.fetch_add(bytes, std::memory_order_relaxed);
+        return p;
+    }
+
+    void CountingResource::do_deallocate(void *p, size_t bytes, size_t alignment)
+    {
+        upstream_->deallocate(p, bytes, alignment);
+
+        deallocations_.fetch_add(1, std::memory_order_relaxed);
+        bytes_in_use_.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    bool CountingResource::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+    {
+        return this == &other;
+    }
+
+    // ============================================================================
+    // ScopedMemoryResource Implementation
+    // ============================================================================
+
+    ScopedMemoryResource::ScopedMemoryResource(FSM &fsm, std::pmr::memory_resource *resource)
+        : fsm_(fsm), previous_(fsm.getMemoryResource())
+    {
+        fsm_.setMemoryResource(resource);
+    }
+
+    ScopedMemoryResource::~ScopedMemoryResource()
+    {
+        fsm_.setMemoryResource(previous_);
+    }
+
+} // namespace fsm
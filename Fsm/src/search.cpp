@@ -0,0 +1,560 @@
+#include <fsm/search.hpp>
+#include <fsm/algebra.hpp>
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace fsm
+{
+    namespace
+    {
+        // ============================================================================
+        // Scanning Loops
+        // ============================================================================
+        //
+        // Each loop walks one table over a byte range from the machine's start
+        // (or a given state) and stops at the dead cell.
+
+        using StateIndex = CompiledFSM::StateIndex;
+
+        // First accepting position after `from`, up to `limit`
+        template <typename View>
+        size_t scanFirstEnd(const CompiledFSM &compiled, const View &table, std::string_view input, size_t from,
+                            size_t limit, StateIndex &state, size_t not_found)
+        {
+            using Cell = typename View::Cell;
+            const uint8_t *classes = compiled.getClassMap();
+
+            for (size_t i = from; i < limit; ++i)
+            {
+                const Cell next = table.cells[table.slot(state, classes[static_cast<unsigned char>(input[i])])];
+                if (next == CompiledFSM::DEAD_CELL<Cell>)
+                {
+                    state = CompiledFSM::DEAD_STATE;
+                    return not_found;
+                }
+                state = next;
+                if (compiled.isAcceptingAtEnd(state))
+                {
+                    return i + 1;
+                }
+            }
+            return not_found;
+        }
+
+        // Last accepting position going forward from `from`, given one at
+        // `end`. The pairs it passes after its last accept are added to the
+        // memo's dead ends, and it stops at any pair already there.
+        template <typename View, typename Memo>
+        size_t scanLongest(const CompiledFSM &compiled, const View &table, std::string_view input, size_t from,
+                           size_t end, Memo &memo)
+        {
+            using Cell = typename View::Cell;
+            const uint8_t *classes = compiled.getClassMap();
+            auto step = [&](StateIndex state, size_t i)
+            {
+                return table.cells[table.slot(state, classes[static_cast<unsigned char>(input[i])])];
+            };
+
+            StateIndex state = compiled.getStartState();
+            for (size_t i = from; i < end; ++i)
+            {
+                const Cell next = step(state, i);
+                if (next == CompiledFSM::DEAD_CELL<Cell>)
+                {
+                    return end;
+                }
+                state = next;
+            }
+
+            const uint64_t states = compiled.getStateCount();
+            size_t found = end;
+            StateIndex found_state = state;
+
+            const size_t horizon = memo.horizon;
+            size_t i = end;
+            for (; i < input.size(); ++i)
+            {
+                if (i < horizon && memo.dead_ends.count(i * states + state) != 0)
+                {
+                    break;
+                }
+
+                const Cell next = step(state, i);
+                if (next == CompiledFSM::DEAD_CELL<Cell>)
+                {
+                    // The pair at `i` is one step from dead: cheaper to
+                    // rediscover than to store.
+                    break;
+                }
+                state = next;
+                if (compiled.isAcceptingAtEnd(state))
+                {
+                    found = i + 1;
+                    found_state = state;
+                }
+            }
+
+            // Replay the tail past the last accept into the memo.
+            state = found_state;
+            for (size_t p = found; p < i; ++p)
+            {
+                memo.dead_ends.insert(p * states + state);
+                state = step(state, p);
+            }
+            memo.horizon = std::max(memo.horizon, i);
+            return found;
+        }
+
+        // Last accepting position going backward from `end` to `from`
+        template <typename View>
+        size_t scanBackward(const CompiledFSM &compiled, const View &table, std::string_view input, size_t from,
+                            size_t end, size_t found)
+        {
+            using Cell = typename View::Cell;
+            const uint8_t *classes = compiled.getClassMap();
+            StateIndex state = compiled.getStartState();
+
+            for (size_t i = end; i > from; --i)
+            {
+                const Cell next = table.cells[table.slot(state, classes[static_cast<unsigned char>(input[i - 1])])];
+                if (next == CompiledFSM::DEAD_CELL<Cell>)
+                {
+                    break;
+                }
+                state = next;
+                if (compiled.isAcceptingAtEnd(state))
+                {
+                    found = i - 1;
+                }
+            }
+            return found;
+        }
+
+        // Chunk boundaries for `parts` threads: [bounds[k], bounds[k + 1])
+        std::vector<size_t> splitEvenly(size_t size, size_t parts)
+        {
+            std::vector<size_t> bounds(parts + 1);
+            for (size_t k = 0; k <= parts; ++k)
+            {
+                bounds[k] = size / parts * k + size % parts * k / parts;
+            }
+            return bounds;
+        }
+
+        unsigned threadCount(unsigned threads)
+        {
+            return threads != 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        // Runs fn(k) for every k in [0, parts): the last on the calling thread
+        template <typename Fn>
+        void runParallel(size_t parts, Fn fn)
+        {
+            std::vector<std::thread> workers;
+            workers.reserve(parts - 1);
+            for (size_t k = 0; k + 1 < parts; ++k)
+            {
+                workers.emplace_back(fn, k);
+            }
+            fn(parts - 1);
+            for (std::thread &worker : workers)
+            {
+                worker.join();
+            }
+        }
+    }
+
+    // ============================================================================
+    // Searcher
+    // ============================================================================
+
+    Searcher::Searcher(const FSM &fsm)
+        : forward_(*minimize(fsm)), reverse_(*reverse(fsm)), scanner_(*unanchored(fsm))
+    {
+    }
+
+    size_t Searcher::firstEnd(std::string_view input, size_t from, size_t limit, StateIndex &state) const
+    {
+        if (state == CompiledFSM::DEAD_STATE)
+        {
+            return NO_POSITION;
+        }
+        if (scanner_.isAcceptingAtEnd(state))
+        {
+            return from;
+        }
+        return scanner_.withTable([&](const auto &table)
+                                  { return scanFirstEnd(scanner_, table, input, from, limit, state, NO_POSITION); });
+    }
+
+    Searcher::Match Searcher::widen(std::string_view input, size_t from, size_t end, Memo &memo) const
+    {
+        // A match ends at `end`, so the reversed machine accepts somewhere
+        // in [from, end].
+        const size_t begin = reverse_.withTable(
+            [&](const auto &table)
+            {
+                const size_t empty = reverse_.isAcceptingAtEnd(reverse_.getStartState()) ? end : NO_POSITION;
+                return scanBackward(reverse_, table, input, from, end, empty);
+            });
+
+        // And from `begin` the forward machine reaches at least `end`.
+        if (begin >= memo.horizon && !memo.dead_ends.empty())
+        {
+            memo.dead_ends.clear();
+        }
+        const size_t longest = forward_.withTable([&](const auto &table)
+                                                  { return scanLongest(forward_, table, input, begin, end, memo); });
+
+        return Match{begin, longest};
+    }
+
+    std::optional<Searcher::Match> Searcher::find(std::string_view input, size_t from) const
+    {
+        Memo memo;
+        return find(input, from, memo);
+    }
+
+    std::optional<Searcher::Match> Searcher::find(std::string_view input, size_t from, Memo &memo) const
+    {
+        if (from > input.size())
+        {
+            return std::nullopt;
+        }
+
+        StateIndex state = scanner_.getStartState();
+        const size_t end = firstEnd(input, from, input.size(), state);
+        if (end == NO_POSITION)
+        {
+            return std::nullopt;
+        }
+        return widen(input, from, end, memo);
+    }
+
+    std::vector<Searcher::Match> Searcher::findAll(std::string_view input) const
+    {
+        std::vector<Match> matches;
+        Memo memo;
+        for (std::optional<Match> match = find(input, 0, memo); match; match = find(input, resume(*match), memo))
+        {
+            matches.push_back(*match);
+        }
+        return matches;
+    }
+
+    bool Searcher::contains(std::string_view input) const
+    {
+        StateIndex state = scanner_.getStartState();
+        return firstEnd(input, 0, input.size(), state) != NO_POSITION;
+    }
+
+    size_t Searcher::count(std::string_view input) const
+    {
+        size_t total = 0;
+        Memo memo;
+        for (std::optional<Match> match = find(input, 0, memo); match; match = find(input, resume(*match), memo))
+        {
+            ++total;
+        }
+        return total;
+    }
+
+    // ============================================================================
+    // Parallel Counting
+    // ============================================================================
+
+    Searcher::Chunk Searcher::countChunk(std::string_view input, size_t from, size_t end,
+                                         const std::vector<Chunk> &tracks) const
+    {
+        // The last chunk also owns a match that is empty at the very end.
+        const size_t stop = end == input.size() ? end + 1 : end;
+
+        Chunk chunk;
+        chunk.first_end = NO_POSITION;
+        Memo memo;
+        for (;;)
+        {
+            for (const Chunk &track : tracks)
+            {
+                const auto start = std::lower_bound(track.starts.begin(), track.starts.end(), from);
+                if (start != track.starts.end() && *start == from)
+                {
+                    chunk.count += track.count - static_cast<size_t>(start - track.starts.begin());
+                    chunk.exit = track.exit;
+                    chunk.pending = track.pending;
+                    chunk.state = track.state;
+                    return chunk;
+                }
+            }
+
+            if (chunk.starts.size() < RESUME_LIMIT)
+            {
+                chunk.starts.push_back(from);
+            }
+
+            StateIndex state = scanner_.getStartState();
+            const size_t match_end = firstEnd(input, from, end, state);
+            if (match_end == NO_POSITION)
+            {
+                chunk.exit = from;
+                chunk.pending = true;
+                chunk.state = state;
+                return chunk;
+            }
+
+            if (chunk.count++ == 0)
+            {
+                chunk.first_end = match_end;
+            }
+            from = resume(widen(input, from, match_end, memo));
+            if (from >= stop)
+            {
+                chunk.exit = from;
+                return chunk;
+            }
+        }
+    }
+
+    size_t Searcher::countParallel(std::string_view input, unsigned threads) const
+    {
+        const size_t parts = std::min<size_t>(threadCount(threads), std::max<size_t>(input.size(), 1));
+        if (parts == 1)
+        {
+            return count(input);
+        }
+
+        // Every chunk is searched from each of its first TRACKS bytes. A
+        // track that restarts where an earlier one did takes over that one's
+        // tally, so on most input the extra tracks cost one match each.
+        const std::vector<size_t> bounds = splitEvenly(input.size(), parts);
+        std::vector<std::vector<Chunk>> chunks(parts);
+        runParallel(parts, [&](size_t k)
+                    {
+                        const size_t tracks = std::clamp<size_t>(bounds[k + 1] - bounds[k], 1, TRACKS);
+                        for (size_t t = 0; t < tracks; ++t)
+                        {
+                            chunks[k].push_back(countChunk(input, bounds[k] + t, bounds[k + 1], chunks[k]));
+                        }
+                    });
+
+        // Stitch in order. The true search arrives at each chunk either
+        // resolved (next search starts at `from`) or pending (a search from
+        // `from` has seen no match end yet and the scanner is in `state`).
+        size_t total = 0;
+        size_t from = 0;
+        bool pending = false;
+        StateIndex state = CompiledFSM::DEAD_STATE;
+        Memo memo;
+
+        for (size_t k = 0; k < parts; ++k)
+        {
+            const std::vector<Chunk> &tracks = chunks[k];
+            const Chunk &chunk = tracks.front();
+            const size_t begin = bounds[k];
+            const size_t end = bounds[k + 1];
+            const size_t stop = end == input.size() ? end + 1 : end;
+
+            if (pending)
+            {
+                // Step the true scanner next to the chunk's own until they
+                // agree; from there on the chunk saw the same match ends.
+                auto step = [&](StateIndex from_state, size_t at)
+                {
+                    return from_state == CompiledFSM::DEAD_STATE
+                               ? from_state
+                               : scanner_.next(from_state, static_cast<unsigned char>(input[at]));
+                };
+
+                StateIndex own = scanner_.getStartState();
+                size_t at = begin;
+                size_t match_end = NO_POSITION;
+                while (state != own)
+                {
+                    if (state != CompiledFSM::DEAD_STATE && scanner_.isAcceptingAtEnd(state))
+                    {
+                        match_end = at;
+                        break;
+                    }
+                    if (at == end)
+                    {
+                        break;
+                    }
+                    state = step(state, at);
+                    own = step(own, at);
+                    ++at;
+                }
+
+                if (match_end == NO_POSITION && state == own)
+                {
+                    if (chunk.count == 0)
+                    {
+                        state = chunk.state;
+                        continue;
+                    }
+                    match_end = chunk.first_end;
+                }
+                else if (match_end == NO_POSITION)
+                {
+                    continue;
+                }
+
+                ++total;
+                from = resume(widen(input, from, match_end, memo));
+                pending = false;
+            }
+
+            // Resolved: search on our own until a search start lines up with
+            // one a track recorded.
+            while (from < stop)
+            {
+                const Chunk *lined_up = nullptr;
+                size_t index = 0;
+                for (const Chunk &track : tracks)
+                {
+                    const auto start = std::lower_bound(track.starts.begin(), track.starts.end(), from);
+                    if (start != track.starts.end() && *start == from)
+                    {
+                        lined_up = &track;
+                        index = static_cast<size_t>(start - track.starts.begin());
+                        break;
+                    }
+                }
+                if (lined_up)
+                {
+                    total += lined_up->count - index;
+                    from = lined_up->exit;
+                    pending = lined_up->pending;
+                    state = lined_up->state;
+                    break;
+                }
+
+                state = scanner_.getStartState();
+                const size_t match_end = firstEnd(input, from, end, state);
+                if (match_end == NO_POSITION)
+                {
+                    pending = true;
+                    break;
+                }
+                ++total;
+                from = resume(widen(input, from, match_end, memo));
+            }
+        }
+        return total;
+    }
+
+    // ============================================================================
+    // Record Counting
+    // ============================================================================
+
+    RecordCounts &RecordCounts::operator+=(const RecordCounts &other)
+    {
+        records += other.records;
+        accepted += other.accepted;
+        by_state.resize(std::max(by_state.size(), other.by_state.size()));
+        for (size_t s = 0; s < other.by_state.size(); ++s)
+        {
+            by_state[s] += other.by_state[s];
+        }
+        return *this;
+    }
+
+    namespace
+    {
+        template <typename View>
+        void tallyRecords(const CompiledFSM &compiled, const View &table, std::string_view input, char separator,
+                          RecordCounts &counts)
+        {
+            using Cell = typename View::Cell;
+            const uint8_t *classes = compiled.getClassMap();
+            const StateIndex start = compiled.getStartState();
+
+            auto tally = [&](StateIndex state)
+            {
+                ++counts.records;
+                if (state != CompiledFSM::DEAD_STATE && compiled.isAcceptingAtEnd(state))
+                {
+                    ++counts.accepted;
+                    ++counts.by_state[compiled.getFinalState(state)];
+                }
+            };
+
+            const char *data = input.data();
+            const size_t size = input.size();
+            StateIndex state = start;
+            size_t i = 0;
+            while (i < size)
+            {
+                if (data[i] == separator)
+                {
+                    tally(state);
+                    state = start;
+                    ++i;
+                    continue;
+                }
+
+                const Cell next = state == CompiledFSM::DEAD_STATE
+                                      ? CompiledFSM::DEAD_CELL<Cell>
+                                      : table.cells[table.slot(state, classes[static_cast<unsigned char>(data[i])])];
+                if (next == CompiledFSM::DEAD_CELL<Cell>)
+                {
+                    // Rejected: nothing else in this record matters.
+                    const void *found = std::memchr(data + i, separator, size - i);
+                    state = CompiledFSM::DEAD_STATE;
+                    i = found ? static_cast<size_t>(static_cast<const char *>(found) - data) : size;
+                    continue;
+                }
+                state = next;
+                ++i;
+            }
+
+            if (size != 0 && data[size - 1] != separator)
+            {
+                tally(state);
+            }
+        }
+
+        RecordCounts countRange(const CompiledFSM &compiled, std::string_view input, char separator)
+        {
+            RecordCounts counts;
+            counts.by_state.assign(compiled.getStateCount(), 0);
+            compiled.withTable([&](const auto &table)
+                               { tallyRecords(compiled, table, input, separator, counts); });
+            return counts;
+        }
+    }
+
+    RecordCounts countRecords(const CompiledFSM &compiled, std::string_view input, char separator, unsigned threads)
+    {
+        const size_t parts = std::min<size_t>(threadCount(threads), std::max<size_t>(input.size(), 1));
+        if (parts == 1)
+        {
+            return countRange(compiled, input, separator);
+        }
+
+        // Move each boundary past the next separator.
+        std::vector<size_t> bounds = splitEvenly(input.size(), parts);
+        for (size_t k = 1; k < parts; ++k)
+        {
+            size_t &bound = bounds[k];
+            bound = std::max(bound, bounds[k - 1]);
+            const void *found = bound < input.size() ? std::memchr(input.data() + bound, separator,
+                                                                   input.size() - bound)
+                                                     : nullptr;
+            bound = found ? static_cast<size_t>(static_cast<const char *>(found) - input.data()) + 1 : input.size();
+        }
+
+        std::vector<RecordCounts> partial(parts);
+        runParallel(parts, [&](size_t k)
+                    { partial[k] = countRange(compiled, input.substr(bounds[k], bounds[k + 1] - bounds[k]),
+                                              separator); });
+
+        RecordCounts counts;
+        for (const RecordCounts &part : partial)
+        {
+            counts += part;
+        }
+        return counts;
+    }
+
+} // namespace fsm
@@ -0,0 +1,278 @@
+#include <fsm/tracing.hpp>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace fsm
+{
+    namespace
+    {
+        constexpr char TRACE_MAGIC[8] = {'F', 'S', 'M', 'T', 'R', 'A', 'C', 'E'};
+        constexpr uint32_t TRACE_VERSION = 1;
+
+        void pack(const TraceRecord &record, uint64_t (&words)[3])
+        {
+            words[0] = (static_cast<uint64_t>(record.validation) << 32) | record.step;
+            words[1] = (static_cast<uint64_t>(record.from) << 32) | record.to;
+            words[2] = (static_cast<uint64_t>(record.transition) << 32) |
+                       (static_cast<uint64_t>(record.byte) << 8) | record.flags;
+        }
+
+        TraceRecord unpack(const uint64_t (&words)[3])
+        {
+            TraceRecord record{};
+            record.validation = static_cast<uint32_t>(words[0] >> 32);
+            record.step = static_cast<uint32_t>(words[0]);
+            record.from = static_cast<uint32_t>(words[1] >> 32);
+            record.to = static_cast<uint32_t>(words[1]);
+            record.transition = static_cast<uint32_t>(words[2] >> 32);
+            record.byte = static_cast<uint8_t>(words[2] >> 8);
+            record.flags = static_cast<uint8_t>(words[2]);
+            return record;
+        }
+
+        std::string stateName(const std::unordered_map<uint32_t, std::string> &names, uint32_t id)
+        {
+            auto it = names.find(id);
+            return it != names.end() ? it->second : StateID(id).toString();
+        }
+
+        std::unordered_map<uint32_t, std::string> stateNames(const FSM *fsm)
+        {
+            std::unordered_map<uint32_t, std::string> names;
+            if (fsm)
+            {
+                for (const auto &id : fsm->getStates())
+                {
+                    names[id.id] = id.toString();
+                }
+            }
+            return names;
+        }
+    }
+
+    // ============================================================================
+    // RingTracer Implementation
+    // ============================================================================
+
+    RingTracer::RingTracer(size_t capacity, uint32_t sample_every)
+        : mask_(capacity - 1), sample_every_(sample_every)
+    {
+        if (capacity == 0 || (capacity & (capacity - 1)) != 0)
+        {
+            throw std::invalid_argument("RingTracer capacity must be a non-zero power of two");
+        }
+        if (sample_every == 0)
+        {
+            throw std::invalid_argument("RingTracer sample rate must be at least 1");
+        }
+
+        slots_.reset(new Slot[capacity]);
+    }
+
+    bool RingTracer::sample(uint32_t &validation) noexcept
+    {
+        validation = validations_.fetch_add(1, std::memory_order_relaxed);
+        return validation % sample_every_ == 0;
+    }
+
+    void RingTracer::record(const TraceRecord &record) noexcept
+    {
+        const uint64_t ticket = cursor_.fetch_add(1, std::memory_order_relaxed);
+        Slot &slot = slots_[ticket & mask_];
+
+        uint64_t words[3];
+        pack(record, words);
+
+        slot.sequence.store(2 * ticket + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < 3; ++i)
+        {
+            slot.words[i].store(words[i], std::memory_order_relaxed);
+        }
+        slot.sequence.store(2 * ticket + 2, std::memory_order_release);
+    }
+
+    std::vector<TraceRecord> RingTracer::snapshot() const
+    {
+        const uint64_t end = cursor_.load(std::memory_order_acquire);
+        const uint64_t begin = end > capacity() ? end - capacity() : 0;
+
+        std::vector<TraceRecord> records;
+        records.reserve(end - begin);
+
+        for (uint64_t ticket = begin; ticket < end; ++ticket)
+        {
+            const Slot &slot = slots_[ticket & mask_];
+
+            const uint64_t before = slot.sequence.load(std::memory_order_acquire);
+            uint64_t words[3];
+            for (size_t i = 0; i < 3; ++i)
+            {
+                words[i] = slot.words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            const uint64_t after = slot.sequence.load(std::memory_order_relaxed);
+
+            if (before == after && before == 2 * ticket + 2)
+            {
+                records.push_back(unpack(words));
+            }
+        }
+
+        return records;
+    }
+
+    void RingTracer::clear() noexcept
+    {
+        for (size_t i = 0; i <= mask_; ++i)
+        {
+            slots_[i].sequence.store(0, std::memory_order_relaxed);
+        }
+        cursor_.store(0, std::memory_order_release);
+    }
+
+    void RingTracer::write(std::ostream &os) const
+    {
+        const std::vector<TraceRecord> records = snapshot();
+        const uint64_t count = records.size();
+
+        os.write(TRACE_MAGIC, sizeof(TRACE_MAGIC));
+        os.write(reinterpret_cast<const char *>(&TRACE_VERSION), sizeof(TRACE_VERSION));
+        os.write(reinterpret_cast<const char *>(&count), sizeof(count));
+        os.write(reinterpret_cast<const char *>(records.data()),
+                 static_cast<std::streamsize>(records.size() * sizeof(TraceRecord)));
+    }
+
+    void RingTracer::save(const std::string &filename) const
+    {
+        std::ofstream file(filename, std::ios::binary);
+        if (!file.is_open())
+        {
+            throw std::runtime_error("Failed to open file for trace export: " + filename);
+        }
+
+        write(file);
+    }
+
+    // ============================================================================
+    // Trace Decoding
+    // ============================================================================
+
+    std::vector<TraceRecord> trace::read(std::istream &is)
+    {
+        char magic[sizeof(TRACE_MAGIC)];
+        uint32_t version = 0;
+        uint64_t count = 0;
+
+        is.read(magic, sizeof(magic));
+        is.read(reinterpret_cast<char *>(&version), sizeof(version));
+        is.read(reinterpret_cast<char *>(&count), sizeof(count));
+
+        if (!is || std::memcmp(magic, TRACE_MAGIC, sizeof(magic)) != 0)
+        {
+            throw std::runtime_error("Not an FSM trace file");
+        }
+        if (version != TRACE_VERSION)
+        {
+            throw std::runtime_error("Unsupported trace version " + std::to_string(version));
+        }
+
+        std::vector<TraceRecord> records;
+        TraceRecord record{};
+        for (uint64_t i = 0; i < count; ++i)
+        {
+            if (!is.read(reinterpret_cast<char *>(&record), sizeof(record)))
+            {
+                throw std::runtime_error("Truncated trace file");
+            }
+            records.push_back(record);
+        }
+
+        return records;
+    }
+
+    std::vector<TraceRecord> trace::load(const std::string &filename)
+    {
+        std::ifstream file(filename, std::ios::binary);
+        if (!file.is_open())
+        {
+            throw std::runtime_error("Failed to open trace: " + filename);
+        }
+
+        return read(file);
+    }
+
+    std::string trace::toText(const std::vector<TraceRecord> &records, const FSM *fsm)
+    {
+        const auto names = stateNames(fsm);
+        std::ostringstream oss;
+
+        for (const auto &record : records)
+        {
+            oss << "#" << record.validation << " Step " << record.step << ": "
+                << stateName(names, record.from) << " -> " << stateName(names, record.to);
+
+            if (record.isEpsilon())
+            {
+                oss << " on ε";
+            }
+            else
+            {
+                oss << " on '" << static_cast<char>(record.byte) << "'";
+            }
+
+            oss << " (transition #" << record.transition << ")\n";
+        }
+
+        return oss.str();
+    }
+
+    std::string trace::toDot(const std::vector<TraceRecord> &records, const FSM &fsm)
+    {
+        std::map<Transition::TransitionID, size_t> hits;
+        for (const auto &record : records)
+        {
+            hits[record.transition]++;
+        }
+
+        std::ostringstream oss;
+        oss << "digraph TRACE_" << fsm.getName() << " {\n";
+        oss << "    rankdir=LR;\n";
+        oss << "    node [shape=circle];\n\n";
+
+        for (const auto &id : fsm.getStates())
+        {
+            oss << "    " << id.id << " [";
+            if (fsm.isAcceptState(id))
+            {
+                oss << "shape=doublecircle, ";
+            }
+            oss << "label=\"" << id.toString() << "\"];\n";
+        }
+
+        oss << "\n";
+
+        for (const auto &trans : fsm.getTransitions())
+        {
+            oss << "    " << trans.from.id << " -> " << trans.to.id << " [label=\"#" << trans.id;
+
+            auto it = hits.find(trans.id);
+            if (it != hits.end())
+            {
+                oss << " x" << it->second << "\", color=red, penwidth=2];\n";
+            }
+            else
+            {
+                oss << "\", color=gray];\n";
+            }
+        }
+
+        oss << "}\n";
+        return oss.str();
+    }
+
+} // namespace fsm
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include <fsm/fsm.hpp>
+#include <fsm/matcher.hpp>
 #include <abnf/abnf.hpp>
 
 using namespace fsm;
@@ -231,4 +232,180 @@ TEST_F(CallbacksCapturesTest, ClearCaptures)
     fsm->clearCaptures();
 
     EXPECT_FALSE(fsm->hasCapture("data"));
-}
\ No newline at end of file
+}
+// ============================================================================
+// Typed Action Tests
+// ============================================================================
+
+namespace
+{
+    enum class KvAction : Transition::ActionID
+    {
+        KEY_CHAR = 1,
+        SEPARATOR,
+        VALUE_CHAR,
+        DONE
+    };
+
+    struct KvCounter
+    {
+        size_t key_chars = 0;
+        size_t value_chars = 0;
+        size_t separator_at = 0;
+        bool done = false;
+
+        void operator()(const ActionContext &ctx)
+        {
+            switch (ctx.as<KvAction>())
+            {
+            case KvAction::KEY_CHAR:
+                key_chars++;
+                break;
+            case KvAction::SEPARATOR:
+                separator_at = ctx.position;
+                break;
+            case KvAction::VALUE_CHAR:
+                value_chars++;
+                break;
+            case KvAction::DONE:
+                done = true;
+                break;
+            }
+        }
+    };
+
+    std::shared_ptr<FSM> buildKeyValue()
+    {
+        return FSM::Builder("key_value")
+            .addState("START", StateType::START)
+            .addState("KEY")
+            .addState("EQ")
+            .addState("VALUE")
+            .addState("ACCEPT", StateType::ACCEPT)
+            .setStartState("START")
+            .addAcceptState("ACCEPT")
+            .addTransition("START", "KEY", ABNF::alpha())
+            .withAction(KvAction::KEY_CHAR)
+            .addTransition("KEY", "KEY", ABNF::alpha())
+            .withAction(KvAction::KEY_CHAR)
+            .addTransition("KEY", "EQ", ABNF::literal('='))
+            .withAction(KvAction::SEPARATOR)
+            .addTransition("EQ", "VALUE", ABNF::digit())
+            .withAction(KvAction::VALUE_CHAR)
+            .addTransition("VALUE", "VALUE", ABNF::digit())
+            .withAction(KvAction::VALUE_CHAR)
+            .addEpsilonTransition("VALUE", "ACCEPT")
+            .withAction(KvAction::DONE)
+            .build();
+    }
+}
+
+TEST_F(CallbacksCapturesTest, TypedActionsDispatchBySwitch)
+{
+    auto fsm = buildKeyValue();
+    FastMatcher matcher(*fsm);
+
+    KvCounter counter;
+    EXPECT_TRUE(matcher.validate("port=8080", counter));
+
+    EXPECT_EQ(4, counter.key_chars);
+    EXPECT_EQ(4, counter.separator_at);
+    EXPECT_EQ(4, counter.value_chars);
+    EXPECT_TRUE(counter.done);
+}
+
+TEST_F(CallbacksCapturesTest, TypedActionsOnCombTable)
+{
+    auto fsm = buildKeyValue();
+    FastMatcher matcher(std::make_shared<const CompiledFSM>(*fsm, CompiledFSM::TableLayout::COMB));
+    ASSERT_EQ(CompiledFSM::TableLayout::COMB, matcher.getCompiled().getTableLayout());
+
+    KvCounter counter;
+    EXPECT_TRUE(matcher.validate("port=8080", counter));
+
+    EXPECT_EQ(4, counter.key_chars);
+    EXPECT_EQ(4, counter.separator_at);
+    EXPECT_EQ(4, counter.value_chars);
+    EXPECT_TRUE(counter.done);
+}
+
+TEST_F(CallbacksCapturesTest, TypedActionsWithLambdaAndStreaming)
+{
+    auto fsm = buildKeyValue();
+    FastMatcher matcher(*fsm);
+
+    std::vector<Transition::ActionID> seen;
+    auto handler = [&seen](const ActionContext &ctx)
+    { seen.push_back(ctx.action); };
+
+    matcher.feed("a=", handler);
+    matcher.feed("1", handler);
+    EXPECT_EQ(StreamState::COMPLETE, matcher.endOfStream(handler));
+
+    std::vector<Transition::ActionID> expected{1, 2, 3, 4};
+    EXPECT_EQ(expected, seen);
+}
+
+TEST_F(CallbacksCapturesTest, MachinesWithoutActionsSkipDispatch)
+{
+    auto fsm = FSM::Builder("plain")
+                   .addState("START", StateType::START)
+                   .addState("DIGITS", StateType::ACCEPT)
+                   .setStartState("START")
+                   .addAcceptState("DIGITS")
+                   .addTransition("START", "DIGITS", ABNF::digit())
+                   .addTransition("DIGITS", "DIGITS", ABNF::digit())
+                   .build();
+
+    FastMatcher matcher(*fsm);
+    EXPECT_FALSE(matcher.getCompiled().hasActions());
+
+    size_t calls = 0;
+    EXPECT_TRUE(matcher.validate("12345", [&calls](const ActionContext &)
+                                 { calls++; }));
+    EXPECT_EQ(0, calls);
+}
+
+TEST_F(CallbacksCapturesTest, SetTransitionAction)
+{
+    FSM fsm("manual");
+    auto start = fsm.addState("START", StateType::START);
+    auto accept = fsm.addState("ACCEPT", StateType::ACCEPT);
+    fsm.setStartState(start);
+    fsm.addAcceptState(accept);
+    auto id = fsm.addTransition(start, accept, ABNF::digit());
+
+    fsm.setTransitionAction(id, 7);
+    EXPECT_THROW(fsm.setTransitionAction(999, 7), std::invalid_argument);
+
+    FastMatcher matcher(fsm);
+    Transition::ActionID last = Transition::NO_ACTION;
+    EXPECT_TRUE(matcher.validate("3", [&last](const ActionContext &ctx)
+                                 { last = ctx.action; }));
+    EXPECT_EQ(7, last);
+}
+
+TEST_F(CallbacksCapturesTest, ZeroEnumActionIsRejected)
+{
+    enum class Step : Transition::ActionID
+    {
+        NONE,
+        DIGIT
+    };
+
+    FSM::Builder builder("zero");
+    builder.addState("START", StateType::START)
+        .addState("ACCEPT", StateType::ACCEPT)
+        .setStartState("START")
+        .addAcceptState("ACCEPT")
+        .addTransition("START", "ACCEPT", ABNF::digit());
+
+    EXPECT_THROW(builder.withAction(Step::NONE), std::invalid_argument);
+
+    auto fsm = builder.withAction(Step::DIGIT).build();
+    FastMatcher matcher(*fsm);
+    Transition::ActionID last = Transition::NO_ACTION;
+    EXPECT_TRUE(matcher.validate("3", [&last](const ActionContext &ctx)
+                                 { last = ctx.action; }));
+    EXPECT_EQ(Step::DIGIT, static_cast<Step>(last));
+}
@@ -0,0 +1,248 @@
+#include <gtest/gtest.h>
+#include <fsm/algebra.hpp>
+#include <fsm/fsm.hpp>
+#include <fsm/matcher.hpp>
+#include <abnf/abnf.hpp>
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace fsm;
+using namespace abnf;
+
+class AlgebraTest : public ::testing::Test
+{
+protected:
+    void SetUp() override {}
+    void TearDown() override {}
+
+    // 1*DIGIT
+    static std::shared_ptr<FSM> buildDigits()
+    {
+        return FSM::Builder("digits")
+            .addState("START", StateType::START)
+            .addState("DIGITS", StateType::ACCEPT)
+            .setStartState("START")
+            .addAcceptState("DIGITS")
+            .addTransition("START", "DIGITS", ABNF::digit())
+            .addTransition("DIGITS", "DIGITS", ABNF::digit())
+            .build();
+    }
+
+    // Any three bytes, accepted through an epsilon exit
+    static std::shared_ptr<FSM> buildThreeBytes()
+    {
+        return FSM::Builder("three")
+            .addState("S0", StateType::START)
+            .addState("S1")
+            .addState("S2")
+            .addState("S3")
+            .addState("END", StateType::ACCEPT)
+            .setStartState("S0")
+            .addAcceptState("END")
+            .addTransition("S0", "S1", ABNF::octet())
+            .addTransition("S1", "S2", ABNF::octet())
+            .addTransition("S2", "S3", ABNF::octet())
+            .addEpsilonTransition("S3", "END")
+            .build();
+    }
+
+    // Strings starting with "1", with "10" itself shadowed by priority
+    static std::shared_ptr<FSM> buildDenylist()
+    {
+        return FSM::Builder("denylist")
+            .addState("START", StateType::START)
+            .addState("ONE", StateType::ACCEPT)
+            .addState("TEN")
+            .addState("REST", StateType::ACCEPT)
+            .setStartState("START")
+            .addAcceptState("ONE")
+            .addAcceptState("REST")
+            .addTransition("START", "ONE", ABNF::literal('1'))
+            .addTransition("ONE", "TEN", ABNF::literal('0'), Transition::PRIORITY_HIGH)
+            .addTransition("ONE", "REST", ABNF::octet())
+            .addTransition("TEN", "REST", ABNF::octet())
+            .addTransition("REST", "REST", ABNF::octet())
+            .build();
+    }
+
+    // Every string over {0, 1, a} up to four bytes
+    static std::vector<std::string> probes()
+    {
+        std::vector<std::string> out{""};
+        for (size_t begin = 0, length = 0; length < 4; ++length)
+        {
+            const size_t end = out.size();
+            for (size_t i = begin; i < end; ++i)
+            {
+                for (char ch : {'0', '1', 'a'})
+                {
+                    out.push_back(out[i] + ch);
+                }
+            }
+            begin = end;
+        }
+        return out;
+    }
+
+    static void expectLanguage(FSM &result, const std::function<bool(const std::string &)> &expected)
+    {
+        FastMatcher matcher(result);
+        for (const std::string &probe : probes())
+        {
+            EXPECT_EQ(expected(probe), result.validate(probe)) << result.getName() << " on '" << probe << "'";
+            EXPECT_EQ(expected(probe), matcher.validate(probe)) << result.getName() << " on '" << probe << "'";
+        }
+    }
+};
+
+// ============================================================================
+// Product Construction Tests
+// ============================================================================
+
+TEST_F(AlgebraTest, IntersectAcceptsWhatBothAccept)
+{
+    auto digits = buildDigits();
+    auto three = buildThreeBytes();
+    auto both = intersect(*digits, *three);
+
+    EXPECT_EQ("(digits & three)", both->getName());
+    expectLanguage(*both, [&](const std::string &s)
+                   { return digits->validate(s) && three->validate(s); });
+
+    // Exactly three digits: a chain of four states.
+    EXPECT_EQ(4, both->getStateCount());
+    EXPECT_TRUE(both->validate("042"));
+}
+
+TEST_F(AlgebraTest, UniteAcceptsWhatEitherAccepts)
+{
+    auto digits = buildDigits();
+    auto three = buildThreeBytes();
+    auto either = unite(*digits, *three);
+
+    expectLanguage(*either, [&](const std::string &s)
+                   { return digits->validate(s) || three->validate(s); });
+}
+
+TEST_F(AlgebraTest, DifferenceHonorsPriorities)
+{
+    auto digits = buildDigits();
+    auto denylist = buildDenylist();
+    auto allowed = difference(*digits, *denylist);
+
+    // "10" is shadowed in the denylist, so it stays allowed.
+    EXPECT_FALSE(denylist->validate("10"));
+    EXPECT_TRUE(allowed->validate("10"));
+    EXPECT_FALSE(allowed->validate("11"));
+    expectLanguage(*allowed, [&](const std::string &s)
+                   { return digits->validate(s) && !denylist->validate(s); });
+}
+
+TEST_F(AlgebraTest, ComplementIsTotal)
+{
+    auto digits = buildDigits();
+    auto others = complement(*digits);
+
+    expectLanguage(*others, [&](const std::string &s)
+                   { return !digits->validate(s); });
+    EXPECT_TRUE(others->validate(std::string(1, '\xff')));
+    EXPECT_TRUE(others->validate(""));
+
+    // Double complement gives the original language back, minimized.
+    auto again = complement(*others);
+    EXPECT_EQ(2, again->getStateCount());
+    expectLanguage(*again, [&](const std::string &s)
+                   { return digits->validate(s); });
+}
+
+// ============================================================================
+// Minimization Tests
+// ============================================================================
+
+TEST_F(AlgebraTest, MinimizeMergesEquivalentStates)
+{
+    // "ab" / "cb" through separate but equivalent middle states
+    auto redundant = FSM::Builder("redundant")
+                         .addState("START", StateType::START)
+                         .addState("A")
+                         .addState("C")
+                         .addState("AB", StateType::ACCEPT)
+                         .addState("CB", StateType::ACCEPT)
+                         .addState("UNUSED")
+                         .setStartState("START")
+                         .addAcceptState("AB")
+                         .addAcceptState("CB")
+                         .addTransition("START", "A", ABNF::literal('a'))
+                         .addTransition("START", "C", ABNF::literal('c'))
+                         .addTransition("A", "AB", ABNF::literal('b'))
+                         .addTransition("C", "CB", ABNF::literal('b'))
+                         .addTransition("UNUSED", "AB", ABNF::literal('x'))
+                         .build();
+
+    auto minimal = minimize(*redundant);
+    EXPECT_EQ(3, minimal->getStateCount());
+    EXPECT_EQ(2, minimal->getTransitionCount());
+    EXPECT_TRUE(minimal->validate("ab"));
+    EXPECT_TRUE(minimal->validate("cb"));
+    EXPECT_FALSE(minimal->validate("xb"));
+    EXPECT_EQ(FSM::Engine::KEYWORDS, minimal->getSelectedEngine());
+
+    auto empty = intersect(*buildDigits(), *complement(*buildDigits()));
+    EXPECT_EQ(1, empty->getStateCount());
+    EXPECT_FALSE(empty->validate(""));
+    EXPECT_FALSE(empty->validate("1"));
+}
+
+// ============================================================================
+// Search Automata Tests
+// ============================================================================
+
+TEST_F(AlgebraTest, ReverseAcceptsReversedStrings)
+{
+    auto denylist = buildDenylist();
+    auto reversed = reverse(*denylist);
+
+    EXPECT_EQ("reverse(denylist)", reversed->getName());
+    expectLanguage(*reversed, [&](const std::string &s)
+                   { return denylist->validate(std::string(s.rbegin(), s.rend())); });
+
+    // Reversing twice gives the minimal machine back.
+    EXPECT_EQ(minimize(*denylist)->getStateCount(), reverse(*reversed)->getStateCount());
+}
+
+TEST_F(AlgebraTest, UnanchoredAcceptsWhereMatchesEnd)
+{
+    auto digits = buildDigits();
+    auto three = buildThreeBytes();
+    auto scanner = unanchored(*digits);
+
+    EXPECT_EQ(".*digits", scanner->getName());
+    expectLanguage(*scanner, [&](const std::string &s)
+                   { return !s.empty() && digits->validate(s.substr(s.size() - 1)); });
+    expectLanguage(*unanchored(*three), [&](const std::string &s)
+                   { return s.size() >= 3; });
+}
+
+TEST_F(AlgebraTest, RejectsMachinesWithoutATable)
+{
+    auto ambiguous = FSM::Builder("ambiguous")
+                         .addState("START", StateType::START)
+                         .addState("A", StateType::ACCEPT)
+                         .addState("B", StateType::ACCEPT)
+                         .setStartState("START")
+                         .addAcceptState("A")
+                         .addAcceptState("B")
+                         .addTransition("START", "A", ABNF::literal('x'))
+                         .addTransition("START", "B", ABNF::literal('x'))
+                         .build();
+    EXPECT_THROW((void)minimize(*ambiguous), std::invalid_argument);
+
+    auto caller = std::make_shared<FSM>("caller");
+    const StateID start = caller->addState("START", StateType::START);
+    const StateID end = caller->addState("END", StateType::ACCEPT);
+    caller->setStartState(start);
+    caller->addAcceptState(end);
+    caller->addSubMachineTransition(start, end, buildDigits());
+    EXPECT_THROW((void)intersect(*caller, *buildDigits()), std::invalid_argument);
+}
@@ -0,0 +1,266 @@
+#include <gtest/gtest.h>
+#include <fsm/fsm.hpp>
+#include <fsm/matcher.hpp>
+#include <fsm/memory.hpp>
+#include <abnf/abnf.hpp>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+using namespace fsm;
+using namespace abnf;
+
+// ============================================================================
+// Global Allocation Counter
+// ============================================================================
+//
+// Replacing the global operators catches every heap allocation, including the
+// ones that don't go through the FSM's memory resource.
+
+namespace
+{
+    std::atomic<uint64_t> heap_allocations{0};
+}
+
+void *operator new(size_t size)
+{
+    heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    std::free(p);
+}
+
+class AllocationTest : public ::testing::Test
+{
+protected:
+    void SetUp() override {}
+    void TearDown() override {}
+
+    static uint64_t heapAllocations()
+    {
+        return heap_allocations.load(std::memory_order_relaxed);
+    }
+
+    // State names longer than the small-string buffer, plus an epsilon exit.
+    static std::shared_ptr<FSM> buildIdentifier()
+    {
+        return FSM::Builder("identifier")
+            .addState("IDENTIFIER_START", StateType::START)
+            .addState("IDENTIFIER_CONTINUE")
+            .addState("IDENTIFIER_ACCEPTED", StateType::ACCEPT)
+            .setStartState("IDENTIFIER_START")
+            .addAcceptState("IDENTIFIER_ACCEPTED")
+            .addTransition("IDENTIFIER_START", "IDENTIFIER_CONTINUE", ABNF::alpha())
+            .addTransition("IDENTIFIER_CONTINUE", "IDENTIFIER_CONTINUE", ABNF::alpha())
+            .addTransition("IDENTIFIER_CONTINUE", "IDENTIFIER_CONTINUE", ABNF::digit())
+            .addEpsilonTransition("IDENTIFIER_CONTINUE", "IDENTIFIER_ACCEPTED")
+            .build();
+    }
+};
+
+// ============================================================================
+// CountingResource
+// ============================================================================
+
+TEST_F(AllocationTest, CountingResourceTracksUpstream)
+{
+    CountingResource counter;
+
+    {
+        std::pmr::vector<int> values(&counter);
+        values.reserve(16);
+        EXPECT_EQ(1, counter.getAllocations());
+        EXPECT_EQ(16 * sizeof(int), counter.getBytesInUse());
+    }
+
+    EXPECT_EQ(1, counter.getDeallocations());
+    EXPECT_EQ(0, counter.getBytesInUse());
+
+    counter.reset();
+    EXPECT_EQ(0, counter.getAllocations());
+    EXPECT_THROW(CountingResource(nullptr), std::invalid_argument);
+}
+
+TEST_F(AllocationTest, MetricsReportAllocationsPerValidate)
+{
+    auto fsm = buildIdentifier();
+    fsm->getDebugConfig().enable(DebugFlags::COLLECT_METRICS);
+
+    CountingResource counter;
+    fsm->setMemoryResource(&counter);
+    EXPECT_EQ(&counter, fsm->getMemoryResource());
+
+    const std::string input(256, 'x');
+
+    EXPECT_TRUE(fsm->validate(input));
+    EXPECT_GT(fsm->getMetrics().allocations, 0u);
+
+    EXPECT_TRUE(fsm->validate(input));
+    EXPECT_EQ(0, fsm->getMetrics().allocations);
+
+    fsm->setMemoryResource(nullptr);
+    EXPECT_EQ(std::pmr::get_default_resource(), fsm->getMemoryResource());
+    EXPECT_TRUE(fsm->validate(input));
+}
+
+// ============================================================================
+// Zero-Allocation Steady State
+// ============================================================================
+
+TEST_F(AllocationTest, WarmValidateDoesNotAllocate)
+{
+    auto fsm = buildIdentifier();
+    const std::string accepted = "identifier" + std::string(200, '7');
+    const std::string rejected = "identifier-7";
+
+    fsm->validate(accepted);
+    fsm->validate(rejected);
+
+    const uint64_t before = heapAllocations();
+    for (int i = 0; i < 100; ++i)
+    {
+        EXPECT_TRUE(fsm->validate(accepted));
+        EXPECT_FALSE(fsm->validate(rejected));
+        EXPECT_EQ(FSM::ErrorType::NO_MATCHING_TRANSITION, fsm->getErrorType());
+    }
+    EXPECT_EQ(before, heapAllocations());
+}
+
+TEST_F(AllocationTest, WarmFeedDoesNotAllocate)
+{
+    auto fsm = buildIdentifier();
+
+    auto stream = [&fsm]()
+    {
+        fsm->reset();
+        fsm->feed("ident");
+        fsm->feed("ifier42");
+        return fsm->endOfStream();
+    };
+
+    EXPECT_EQ(StreamState::COMPLETE, stream());
+
+    const uint64_t before = heapAllocations();
+    for (int i = 0; i < 100; ++i)
+    {
+        EXPECT_EQ(StreamState::COMPLETE, stream());
+    }
+    EXPECT_EQ(before, heapAllocations());
+}
+
+TEST_F(AllocationTest, CompiledMatcherDoesNotAllocate)
+{
+    auto fsm = buildIdentifier();
+    FastMatcher matcher(*fsm);
+    const std::string input = "identifier" + std::string(200, '7');
+
+    const uint64_t before = heapAllocations();
+    for (int i = 0; i < 100; ++i)
+    {
+        EXPECT_TRUE(matcher.validate(input));
+        EXPECT_FALSE(matcher.validate("7identifier"));
+
+        matcher.reset();
+        matcher.feed("ident");
+        matcher.feed("ifier42");
+        EXPECT_EQ(StreamState::COMPLETE, matcher.endOfStream());
+    }
+    EXPECT_EQ(before, heapAllocations());
+}
+
+// ============================================================================
+// Per-Request Arenas
+// ============================================================================
+
+namespace
+{
+    // 1*"a" "b" with a capture around the run of a's. The first 'a' is
+    // ambiguous, so backtracking records a choice point.
+    std::shared_ptr<FSM> buildCapturingChoice()
+    {
+        auto fsm = FSM::Builder("choice")
+                       .addState("S", StateType::START)
+                       .addState("A")
+                       .addState("B")
+                       .addState("END", StateType::ACCEPT)
+                       .setStartState("S")
+                       .addAcceptState("END")
+                       .onStateEntry("A", [](const StateContext &ctx)
+                                     { static_cast<FSM *>(ctx.user_data)->beginCapture("run"); })
+                       .onStateExit("A", [](const StateContext &ctx)
+                                    { static_cast<FSM *>(ctx.user_data)->endCapture("run"); })
+                       .addTransition("S", "A", ABNF::literal('a'))
+                       .addTransition("S", "B", ABNF::literal('a'))
+                       .addTransition("A", "A", ABNF::literal('a'))
+                       .addTransition("A", "END", ABNF::literal('b'))
+                       .build();
+        fsm->setUserData(fsm.get());
+        return fsm;
+    }
+}
+
+TEST_F(AllocationTest, ArenaServesAllRunState)
+{
+    auto fsm = buildCapturingChoice();
+    fsm->validate("aaab");
+
+    alignas(std::max_align_t) static char buffer[64 << 10];
+    std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer), std::pmr::null_memory_resource());
+    CountingResource counter(&arena);
+
+    const uint64_t before = heapAllocations();
+    {
+        ScopedMemoryResource scope(*fsm, &counter);
+
+        EXPECT_TRUE(fsm->validate("aaab"));
+        EXPECT_EQ("aaa", fsm->getCapture("run")->value);
+
+        EXPECT_TRUE(fsm->validateWithBacktracking("aab"));
+        EXPECT_GT(fsm->getBacktrackingStats().choice_points_created, 0u);
+        EXPECT_EQ("aa", fsm->getCapture("run")->value);
+    }
+    EXPECT_EQ(before, heapAllocations());
+    EXPECT_GT(counter.getAllocations(), 0u);
+
+    arena.release();
+}
+
+TEST_F(AllocationTest, ScopeRestoresPreviousResource)
+{
+    auto fsm = buildCapturingChoice();
+    CountingResource outer;
+    fsm->setMemoryResource(&outer);
+
+    std::pmr::monotonic_buffer_resource arena;
+    {
+        ScopedMemoryResource scope(*fsm, &arena);
+        EXPECT_EQ(&arena, fsm->getMemoryResource());
+        EXPECT_EQ(&arena, fsm->getTraceView().get_allocator().resource());
+        EXPECT_TRUE(fsm->validate("ab"));
+        EXPECT_TRUE(fsm->hasCapture("run"));
+    }
+    arena.release();
+
+    EXPECT_EQ(&outer, fsm->getMemoryResource());
+    EXPECT_EQ(&outer, fsm->getTraceView().get_allocator().resource());
+    EXPECT_FALSE(fsm->hasCapture("run"));
+    EXPECT_TRUE(fsm->getAllCaptures().empty());
+
+    EXPECT_TRUE(fsm->validate("aab"));
+    ASSERT_EQ(1, fsm->getAllCaptures().size());
+    EXPECT_EQ("aa", fsm->getAllCaptures()[0].value);
+    EXPECT_EQ(0, fsm->getAllCaptures()[0].start_position);
+}
@@ -89,6 +89,42 @@ TEST_F(BacktrackingTest, MultipleAmbiguousTransitions)
     EXPECT_GT(stats.paths_explored, 1);
 }
 
+TEST_F(BacktrackingTest, AmbiguityAutoSelectsBacktracking)
+{
+    // 'a' then 'b' only works through the second of two equal-priority edges.
+    auto fsm = FSM::Builder("ambiguous")
+                   .addState("START", StateType::START)
+                   .addState("LEFT")
+                   .addState("RIGHT")
+                   .addState("END", StateType::ACCEPT)
+                   .setStartState("START")
+                   .addAcceptState("END")
+                   .addTransition("START", "LEFT", ABNF::literal('a'))
+                   .addTransition("START", "RIGHT", ABNF::literal('a'))
+                   .addTransition("LEFT", "END", ABNF::literal('c'))
+                   .addTransition("RIGHT", "END", ABNF::literal('b'))
+                   .build();
+
+    EXPECT_FALSE(fsm->isDeterministic());
+    const auto ambiguities = fsm->getAmbiguities();
+    ASSERT_EQ(1, ambiguities.size());
+    EXPECT_EQ("START", ambiguities[0].state.name);
+    EXPECT_FALSE(ambiguities[0].resolved_by_priority);
+
+    EXPECT_EQ(FSM::Engine::BACKTRACKING, fsm->getSelectedEngine());
+    EXPECT_TRUE(fsm->validate("ab"));
+    EXPECT_TRUE(fsm->validate("ac"));
+    EXPECT_GT(fsm->getBacktrackingStats().choice_points_created, 0u);
+
+    fsm->setEngine(FSM::Engine::INTERPRETER);
+    EXPECT_FALSE(fsm->validate("ab"));
+
+    fsm->setEngine(FSM::Engine::TABLE);
+    EXPECT_FALSE(fsm->validate("ac"));
+    EXPECT_EQ(FSM::ErrorType::AMBIGUOUS_TRANSITION, fsm->getErrorType());
+    EXPECT_NE(std::string::npos, fsm->getLastError()->message.find("START"));
+}
+
 // ============================================================================
 // User-Defined Choice Points (Option C)
 // ============================================================================
@@ -480,4 +516,48 @@ TEST_F(BacktrackingTest, CompareValidateMethods)
 
     fsm->reset();
     EXPECT_TRUE(fsm->validateWithBacktracking("xz"));
-}
\ No newline at end of file
+}
+
+// ============================================================================
+// Reuse Across Runs
+// ============================================================================
+
+TEST_F(BacktrackingTest, ChoicePointsDoNotLeakBetweenRuns)
+{
+    auto fsm = FSM::Builder("reuse")
+                   .addState("START", StateType::START)
+                   .addState("A")
+                   .addState("B")
+                   .addState("ACCEPT", StateType::ACCEPT)
+                   .setStartState("START")
+                   .addAcceptState("ACCEPT")
+                   .onStateEntry("A", [](const StateContext &ctx)
+                                 { static_cast<FSM *>(ctx.user_data)->beginCapture("path"); })
+                   .onStateExit("A", [](const StateContext &ctx)
+                                { static_cast<FSM *>(ctx.user_data)->endCapture("path"); })
+                   .addTransition("START", "A", ABNF::literal('x'))
+                   .addTransition("START", "B", ABNF::literal('x'))
+                   .addTransition("A", "A", ABNF::literal('x'))
+                   .addTransition("A", "ACCEPT", ABNF::literal('y'))
+                   .addTransition("B", "ACCEPT", ABNF::literal('z'))
+                   .build();
+    fsm->setUserData(fsm.get());
+
+    // Choice point slots and capture storage are reused between runs; nothing
+    // from the previous run may be visible in the next one.
+    for (int i = 0; i < 3; ++i)
+    {
+        EXPECT_TRUE(fsm->validateWithBacktracking("xxxy"));
+        EXPECT_EQ(0, fsm->getBacktrackingStats().backtracks_performed);
+        ASSERT_TRUE(fsm->hasCapture("path"));
+        EXPECT_EQ("xxx", fsm->getCapture("path")->value);
+
+        EXPECT_TRUE(fsm->validateWithBacktracking("xz"));
+        EXPECT_EQ(1, fsm->getBacktrackingStats().backtracks_performed);
+        EXPECT_FALSE(fsm->hasCapture("path"));
+        EXPECT_TRUE(fsm->getAllCaptures().empty());
+
+        EXPECT_FALSE(fsm->validateWithBacktracking("xq"));
+        EXPECT_FALSE(fsm->hasCapture("path"));
+    }
+}
@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+#include <fsm/dawg.hpp>
+#include <algorithm>
+#include <cstring>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace fsm;
+
+class DawgTest : public ::testing::Test
+{
+protected:
+    void SetUp() override {}
+    void TearDown() override {}
+
+    static Dawg buildFrom(const std::vector<std::string> &words)
+    {
+        Dawg::Builder builder;
+        for (const std::string &word : words)
+        {
+            builder.add(word);
+        }
+        return builder.build();
+    }
+
+    // Stems crossed with suffixes share both prefixes and suffixes.
+    static std::vector<std::string> inflectedWords()
+    {
+        std::set<std::string> words;
+        for (const char *stem : {"walk", "talk", "jump", "play", "stay", "pray", "work", "mark", "park", "bark"})
+        {
+            for (const char *suffix : {"", "s", "ed", "er", "ers", "ing", "ings"})
+            {
+                words.insert(std::string(stem) + suffix);
+            }
+        }
+        return std::vector<std::string>(words.begin(), words.end());
+    }
+
+    static std::string serialize(const Dawg &dawg)
+    {
+        std::ostringstream out;
+        out << dawg;
+        return out.str();
+    }
+};
+
+// ============================================================================
+// Construction Tests
+// ============================================================================
+
+TEST_F(DawgTest, SharesPrefixesAndSuffixes)
+{
+    const Dawg dawg = buildFrom({"tap", "taps", "top", "tops"});
+
+    // root -t-> . -a,o-> . -p-> (accept) -s-> (accept); a trie needs 8 states.
+    EXPECT_EQ(4, dawg.getWordCount());
+    EXPECT_EQ(5, dawg.getStateCount());
+    EXPECT_EQ(5, dawg.getEdgeCount());
+    EXPECT_EQ((std::vector<std::string>{"tap", "taps", "top", "tops"}), dawg.getWords());
+}
+
+TEST_F(DawgTest, ValidateMatchesWordList)
+{
+    const std::vector<std::string> words = inflectedWords();
+    const Dawg dawg = buildFrom(words);
+    const std::set<std::string> expected(words.begin(), words.end());
+
+    EXPECT_EQ(words.size(), dawg.getWordCount());
+    EXPECT_EQ(words, dawg.getWords());
+    // Ten stems, one shared suffix tree.
+    EXPECT_LT(dawg.getStateCount(), 40u);
+
+    std::vector<std::string> probes = words;
+    for (const std::string &word : words)
+    {
+        probes.push_back(word.substr(0, word.size() - 1));
+        probes.push_back(word + "x");
+        probes.push_back("x" + word);
+    }
+    probes.push_back("");
+
+    for (const std::string &probe : probes)
+    {
+        EXPECT_EQ(expected.count(probe) != 0, dawg.validate(probe)) << probe;
+    }
+}
+
+TEST_F(DawgTest, EmptyWordAndEmptyList)
+{
+    const Dawg with_empty = buildFrom({"", "a", "ab"});
+    EXPECT_TRUE(with_empty.validate(""));
+    EXPECT_TRUE(with_empty.validate("ab"));
+    EXPECT_FALSE(with_empty.validate("b"));
+    EXPECT_EQ((std::vector<std::string>{"", "a", "ab"}), with_empty.getWords());
+
+    const Dawg nothing = Dawg::Builder().build();
+    EXPECT_FALSE(nothing.validate(""));
+    EXPECT_TRUE(nothing.getWords().empty());
+
+    const Dawg unbuilt;
+    EXPECT_FALSE(unbuilt.validate(""));
+}
+
+TEST_F(DawgTest, RejectsUnsortedInput)
+{
+    Dawg::Builder builder;
+    builder.add("b");
+    EXPECT_THROW(builder.add("a"), std::invalid_argument);
+    EXPECT_THROW(builder.add("b"), std::invalid_argument);
+    builder.add("c");
+    EXPECT_EQ((std::vector<std::string>{"b", "c"}), builder.build().getWords());
+}
+
+TEST_F(DawgTest, WideFanOutUsesBinarySearch)
+{
+    std::vector<std::string> words;
+    for (int byte = 1; byte < 256; byte += 3)
+    {
+        words.push_back(std::string(1, static_cast<char>(byte)) + "z");
+    }
+    std::sort(words.begin(), words.end());
+    const Dawg dawg = buildFrom(words);
+
+    for (int byte = 0; byte < 256; ++byte)
+    {
+        EXPECT_EQ(byte % 3 == 1, dawg.validate(std::string(1, static_cast<char>(byte)) + "z")) << byte;
+    }
+}
+
+// ============================================================================
+// Serialization Tests
+// ============================================================================
+
+TEST_F(DawgTest, SaveLoadRoundTrip)
+{
+    const Dawg dawg = buildFrom(inflectedWords());
+    const std::string bytes = serialize(dawg);
+    EXPECT_EQ(dawg.getBytes(), bytes.size());
+
+    std::istringstream in(bytes);
+    const Dawg loaded = Dawg::load(in);
+    EXPECT_FALSE(loaded.isView());
+    EXPECT_EQ(dawg.getWords(), loaded.getWords());
+    EXPECT_EQ(dawg.getStateCount(), loaded.getStateCount());
+    EXPECT_TRUE(loaded.validate("workings"));
+}
+
+TEST_F(DawgTest, ViewUsesBytesInPlace)
+{
+    const Dawg dawg = buildFrom(inflectedWords());
+    const std::string bytes = serialize(dawg);
+
+    // Stand-in for an mmap()ed file: aligned, read in place.
+    std::vector<uint32_t> mapped(bytes.size() / sizeof(uint32_t));
+    std::memcpy(mapped.data(), bytes.data(), bytes.size());
+
+    const Dawg view = Dawg::view(mapped.data(), bytes.size());
+    EXPECT_TRUE(view.isView());
+    EXPECT_EQ(dawg.getWords(), view.getWords());
+    EXPECT_TRUE(view.validate("parkers"));
+    EXPECT_FALSE(view.validate("parkerss"));
+
+    const Dawg copy = view;
+    EXPECT_TRUE(copy.isView());
+    EXPECT_TRUE(copy.validate("played"));
+    EXPECT_NE(std::string::npos, view.toString().find("view"));
+}
+
+TEST_F(DawgTest, RejectsCorruptData)
+{
+    const std::string bytes = serialize(buildFrom({"tap", "taps", "top", "tops"}));
+    std::vector<uint32_t> mapped(bytes.size() / sizeof(uint32_t));
+    std::memcpy(mapped.data(), bytes.data(), bytes.size());
+
+    EXPECT_THROW((void)Dawg::view(mapped.data(), bytes.size() - 4), std::invalid_argument);
+    EXPECT_THROW((void)Dawg::view(reinterpret_cast<const char *>(mapped.data()) + 1, bytes.size() - 1),
+                 std::invalid_argument);
+
+    std::vector<uint32_t> bad_magic = mapped;
+    bad_magic[0] ^= 1;
+    EXPECT_THROW((void)Dawg::view(bad_magic.data(), bytes.size()), std::invalid_argument);
+
+    // Point the root's edge (after the 32-byte header and its count cell)
+    // back at the root.
+    std::vector<uint32_t> cycle = mapped;
+    cycle[8 + 1] &= 0xff800000u;
+    EXPECT_THROW((void)Dawg::view(cycle.data(), bytes.size()), std::invalid_argument);
+
+    std::istringstream truncated(bytes.substr(0, bytes.size() - 2));
+    EXPECT_THROW((void)Dawg::load(truncated), std::invalid_argument);
+}
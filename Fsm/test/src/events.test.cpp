@@ -0,0 +1,241 @@
+#include <gtest/gtest.h>
+#include <fsm/fsm.hpp>
+#include <fsm/events.hpp>
+#include <abnf/abnf.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace fsm;
+using namespace abnf;
+
+class EventsTest : public ::testing::Test
+{
+protected:
+    void SetUp() override {}
+    void TearDown() override {}
+
+    enum Tag : Transition::ActionID
+    {
+        KEY = 1,
+        SEPARATOR,
+        VALUE,
+        DONE
+    };
+
+    static std::shared_ptr<FSM> buildKeyValue()
+    {
+        return FSM::Builder("key_value")
+            .addState("START", StateType::START)
+            .addState("KEY")
+            .addState("EQ")
+            .addState("VALUE")
+            .addState("ACCEPT", StateType::ACCEPT)
+            .setStartState("START")
+            .addAcceptState("ACCEPT")
+            .addTransition("START", "KEY", ABNF::alpha())
+            .addTransition("KEY", "KEY", ABNF::alpha())
+            .addTransition("KEY", "EQ", ABNF::literal('='))
+            .withAction(SEPARATOR)
+            .addTransition("EQ", "VALUE", ABNF::digit())
+            .withAction(VALUE)
+            .addTransition("VALUE", "VALUE", ABNF::digit())
+            .withAction(VALUE)
+            .addEpsilonTransition("VALUE", "ACCEPT")
+            .withAction(DONE)
+            .build();
+    }
+};
+
+// ============================================================================
+// EventRing Tests
+// ============================================================================
+
+TEST_F(EventsTest, RingRequiresPowerOfTwoCapacity)
+{
+    std::vector<Event> storage(6);
+    EXPECT_THROW(EventRing(storage.data(), 6), std::invalid_argument);
+    EXPECT_THROW(EventRing(storage.data(), 0), std::invalid_argument);
+    EXPECT_NO_THROW(EventRing(storage.data(), 4));
+}
+
+TEST_F(EventsTest, RingPushPopWrapsAround)
+{
+    std::vector<Event> storage(4);
+    EventRing ring(storage.data(), storage.size());
+
+    for (uint32_t round = 0; round < 3; ++round)
+    {
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            EXPECT_TRUE(ring.push(Event{i, round, 0}));
+        }
+        EXPECT_TRUE(ring.full());
+        EXPECT_FALSE(ring.push(Event{}));
+
+        Event event{};
+        ASSERT_TRUE(ring.pop(event));
+        EXPECT_EQ(0, event.position);
+        EXPECT_EQ(3, ring.drain([round](const Event &e)
+                                { EXPECT_EQ(round, e.id); }));
+        EXPECT_TRUE(ring.empty());
+    }
+}
+
+// ============================================================================
+// EventScanner Tests
+// ============================================================================
+
+TEST_F(EventsTest, ActionEventsInInputOrder)
+{
+    auto fsm = buildKeyValue();
+    EventScanner scanner(*fsm);
+
+    std::vector<Event> storage(16);
+    EventRing ring(storage.data(), storage.size());
+
+    ScanResult result = scanner.scan("key=42", ring);
+    EXPECT_EQ(ScanStatus::CHUNK_CONSUMED, result.status);
+    EXPECT_EQ(6, result.consumed);
+    EXPECT_EQ(ScanStatus::ACCEPTED, scanner.finish(ring).status);
+
+    std::vector<std::pair<uint32_t, uint64_t>> events;
+    ring.drain([&events](const Event &e)
+               { events.emplace_back(e.id, e.position); });
+
+    std::vector<std::pair<uint32_t, uint64_t>> expected = {
+        {SEPARATOR, 3}, {VALUE, 4}, {VALUE, 5}, {DONE, 6}};
+    EXPECT_EQ(expected, events);
+}
+
+TEST_F(EventsTest, BufferFullResumesWithRemainder)
+{
+    auto fsm = buildKeyValue();
+    EventScanner scanner(*fsm);
+
+    std::vector<Event> storage(2);
+    EventRing ring(storage.data(), storage.size());
+
+    std::string_view input = "k=12345";
+    std::vector<uint64_t> positions;
+    size_t batches = 0;
+
+    while (!input.empty())
+    {
+        ScanResult result = scanner.scan(input, ring);
+        ASSERT_NE(ScanStatus::REJECTED, result.status);
+        input.remove_prefix(result.consumed);
+        ring.drain([&positions](const Event &e)
+                   { positions.push_back(e.position); });
+        batches++;
+    }
+
+    EXPECT_EQ(ScanStatus::ACCEPTED, scanner.finish(ring).status);
+    ring.drain([&positions](const Event &e)
+               { positions.push_back(e.position); });
+
+    EXPECT_EQ((std::vector<uint64_t>{1, 2, 3, 4, 5, 6, 7}), positions);
+    EXPECT_EQ(3, batches);
+    EXPECT_EQ(7, scanner.getPosition());
+}
+
+TEST_F(EventsTest, TransitionModeEmitsEveryStep)
+{
+    auto fsm = buildKeyValue();
+    EventScanner scanner(*fsm, EventMode::TRANSITIONS);
+
+    std::vector<Event> storage(8);
+    EventRing ring(storage.data(), storage.size());
+
+    EXPECT_EQ(ScanStatus::CHUNK_CONSUMED, scanner.scan("ab=1", ring).status);
+    EXPECT_EQ(ScanStatus::ACCEPTED, scanner.finish(ring).status);
+    EXPECT_EQ(5, ring.size());
+
+    const CompiledFSM &compiled = scanner.getCompiled();
+    std::vector<std::string> states;
+    ring.drain([&](const Event &e)
+               {
+                   EXPECT_GT(e.id, 0u);
+                   states.push_back(compiled.getStateID(e.state).name); });
+
+    EXPECT_EQ((std::vector<std::string>{"KEY", "KEY", "EQ", "VALUE", "ACCEPT"}), states);
+}
+
+TEST_F(EventsTest, RejectionStopsScanning)
+{
+    auto fsm = buildKeyValue();
+    EventScanner scanner(*fsm);
+
+    std::vector<Event> storage(8);
+    EventRing ring(storage.data(), storage.size());
+
+    ScanResult result = scanner.scan("key=4x2", ring);
+    EXPECT_EQ(ScanStatus::REJECTED, result.status);
+    EXPECT_EQ(5, result.consumed);
+    EXPECT_EQ(2, ring.size());
+    EXPECT_EQ(ScanStatus::REJECTED, scanner.scan("2", ring).status);
+    EXPECT_EQ(ScanStatus::REJECTED, scanner.finish(ring).status);
+
+    scanner.reset();
+    ring.drain([](const Event &) {});
+    EXPECT_EQ(ScanStatus::CHUNK_CONSUMED, scanner.scan("key=", ring).status);
+    EXPECT_EQ(ScanStatus::REJECTED, scanner.finish(ring).status);
+}
+
+TEST_F(EventsTest, ConcurrentConsumer)
+{
+    auto fsm = buildKeyValue();
+    EventScanner scanner(*fsm);
+
+    std::vector<Event> storage(64);
+    EventRing ring(storage.data(), storage.size());
+
+    const std::string input = "key=" + std::string(10000, '7');
+    std::atomic<bool> done{false};
+    uint64_t value_events = 0;
+    uint64_t last_position = 0;
+    bool ordered = true;
+
+    std::thread consumer([&]()
+                         {
+                             auto consume = [&](const Event &e)
+                             {
+                                 ordered = ordered && e.position > last_position;
+                                 last_position = e.position;
+                                 if (e.id == VALUE)
+                                 {
+                                     value_events++;
+                                 }
+                             };
+                             while (!done.load(std::memory_order_acquire))
+                             {
+                                 if (ring.drain(consume) == 0)
+                                 {
+                                     std::this_thread::yield();
+                                 }
+                             }
+                             ring.drain(consume); });
+
+    std::string_view rest = input;
+    while (!rest.empty())
+    {
+        ScanResult result = scanner.scan(rest, ring);
+        ASSERT_NE(ScanStatus::REJECTED, result.status);
+        rest.remove_prefix(result.consumed);
+        if (result.status == ScanStatus::BUFFER_FULL)
+        {
+            std::this_thread::yield();
+        }
+    }
+    while (scanner.finish(ring).status == ScanStatus::BUFFER_FULL)
+    {
+        std::this_thread::yield();
+    }
+
+    done.store(true, std::memory_order_release);
+    consumer.join();
+
+    EXPECT_TRUE(ordered);
+    EXPECT_EQ(10000, value_events);
+    EXPECT_EQ(input.size(), last_position);
+}
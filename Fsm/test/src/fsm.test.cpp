@@ -1,4 +1,5 @@
 #include <gtest/gtest.h>
+#include <sstream>
 #include <fsm/fsm.hpp>
 #include <abnf/abnf.hpp>
 
@@ -194,6 +195,45 @@ TEST_F(FsmTest, HexdigitTransition)
     EXPECT_FALSE(fsm->validate("z"));
 }
 
+TEST_F(FsmTest, SharedRulesAndHighBytes)
+{
+    // Both states use the same digit rule; the runtime keeps one copy of it.
+    auto fsm = FSM::Builder("shared")
+                   .addState("START", StateType::START)
+                   .addState("MID")
+                   .addState("ACCEPT", StateType::ACCEPT)
+                   .setStartState("START")
+                   .addAcceptState("ACCEPT")
+                   .addTransition("START", "MID", ABNF::digit())
+                   .addTransition("MID", "MID", ABNF::digit())
+                   .addTransition("MID", "ACCEPT", ABNF::literal('\xE9'))
+                   .build();
+
+    EXPECT_TRUE(fsm->validate("12\xE9"));
+    EXPECT_FALSE(fsm->validate("12\xE8"));
+    EXPECT_FALSE(fsm->validate("\xE9"));
+}
+
+TEST_F(FsmTest, CallbackSetAfterFirstRun)
+{
+    auto fsm = FSM::Builder("late_callback")
+                   .addState("START", StateType::START)
+                   .addState("ACCEPT", StateType::ACCEPT)
+                   .setStartState("START")
+                   .addAcceptState("ACCEPT")
+                   .addTransition("START", "ACCEPT", ABNF::digit())
+                   .build();
+
+    EXPECT_TRUE(fsm->validate("5"));
+
+    int calls = 0;
+    fsm->setTransitionCallback(fsm->getTransitions()[0].id, [&calls](const TransitionContext &)
+                               { calls++; });
+
+    EXPECT_TRUE(fsm->validate("7"));
+    EXPECT_EQ(1, calls);
+}
+
 // ============================================================================
 // Multi-State Validation Tests
 // ============================================================================
@@ -368,16 +408,115 @@ TEST_F(FsmTest, NotInAcceptState)
                    .setStartState("START")
                    .addAcceptState("ACCEPT")
                    .addTransition("START", "D1", ABNF::digit())
+                   .addTransition("D1", "D1", ABNF::sp())
                    .addTransition("D1", "ACCEPT", ABNF::digit())
                    .build();
 
-    EXPECT_FALSE(fsm->validate("1")); // Only one digit
+    EXPECT_FALSE(fsm->validate("1 ")); // Only one digit
 
     auto error = fsm->getLastError();
     ASSERT_TRUE(error.has_value());
     EXPECT_EQ(FSM::ErrorType::NOT_IN_ACCEPT_STATE, error->type);
 }
 
+TEST_F(FsmTest, LengthBoundsRejectBeforeScanning)
+{
+    auto uuid_like = FSM::Builder("fixed")
+                         .addState("START", StateType::START)
+                         .addState("D1")
+                         .addState("D2")
+                         .addState("ACCEPT", StateType::ACCEPT)
+                         .setStartState("START")
+                         .addAcceptState("ACCEPT")
+                         .addTransition("START", "D1", ABNF::digit())
+                         .addTransition("D1", "D2", ABNF::digit())
+                         .addTransition("D1", "ACCEPT", ABNF::literal('-'))
+                         .addTransition("D2", "ACCEPT", ABNF::digit())
+                         .build();
+
+    const auto bounds = uuid_like->getLengthBounds();
+    EXPECT_EQ(2, bounds.min);
+    EXPECT_EQ(3, bounds.max);
+    EXPECT_TRUE(bounds.finite);
+    EXPECT_FALSE(bounds.empty);
+    EXPECT_EQ("[2, 3]", bounds.toString());
+
+    EXPECT_TRUE(uuid_like->validate("1-"));
+    EXPECT_TRUE(uuid_like->validate("123"));
+
+    EXPECT_FALSE(uuid_like->validate("1"));
+    EXPECT_EQ(FSM::ErrorType::LENGTH_OUT_OF_RANGE, uuid_like->getErrorType());
+    EXPECT_EQ(1, uuid_like->getErrorPosition());
+
+    EXPECT_FALSE(uuid_like->validate(std::string(1 << 16, '7')));
+    EXPECT_EQ(FSM::ErrorType::LENGTH_OUT_OF_RANGE, uuid_like->getErrorType());
+    EXPECT_EQ(3, uuid_like->getErrorPosition());
+    EXPECT_EQ("Input longer than accepted range [2, 3]", uuid_like->getLastError()->message);
+
+    // Callbacks put validate() on the interpreter, which reads the input so
+    // they still fire.
+    int digits = 0;
+    uuid_like->setTransitionCallback(uuid_like->getTransitions()[0].id, [&digits](const TransitionContext &)
+                                     { ++digits; });
+    ASSERT_EQ(FSM::Engine::INTERPRETER, uuid_like->getSelectedEngine());
+    EXPECT_FALSE(uuid_like->validate("1"));
+    EXPECT_EQ(FSM::ErrorType::NOT_IN_ACCEPT_STATE, uuid_like->getErrorType());
+    EXPECT_EQ(1, digits);
+
+    uuid_like->reset();
+    EXPECT_EQ(StreamState::ERROR, uuid_like->feed("1234"));
+    EXPECT_EQ(FSM::ErrorType::LENGTH_OUT_OF_RANGE, uuid_like->getErrorType());
+    EXPECT_EQ(3, uuid_like->getErrorPosition());
+
+    // Loops and epsilon exits
+    auto identifier = FSM::Builder("identifier")
+                          .addState("START", StateType::START)
+                          .addState("BODY")
+                          .addState("DONE", StateType::ACCEPT)
+                          .setStartState("START")
+                          .addAcceptState("DONE")
+                          .addTransition("START", "BODY", ABNF::alpha())
+                          .addTransition("BODY", "BODY", ABNF::alpha())
+                          .addEpsilonTransition("BODY", "DONE")
+                          .build();
+
+    const auto open = identifier->getLengthBounds();
+    EXPECT_EQ(1, open.min);
+    EXPECT_EQ(FSM::LengthBounds::UNBOUNDED, open.max);
+    EXPECT_FALSE(open.finite);
+    EXPECT_TRUE(identifier->validate(std::string(4096, 'q')));
+    EXPECT_FALSE(open.admits(0));
+}
+
+TEST_F(FsmTest, ErrorCodesWithoutRendering)
+{
+    auto fsm = FSM::Builder("digits")
+                   .addState("START", StateType::START)
+                   .addState("DIGITS", StateType::ACCEPT)
+                   .setStartState("START")
+                   .addAcceptState("DIGITS")
+                   .addTransition("START", "DIGITS", ABNF::digit())
+                   .addTransition("DIGITS", "DIGITS", ABNF::digit())
+                   .build();
+
+    EXPECT_FALSE(fsm->validate("123x5"));
+    EXPECT_TRUE(fsm->hasError());
+    EXPECT_EQ(FSM::ErrorType::NO_MATCHING_TRANSITION, fsm->getErrorType());
+    EXPECT_EQ(3, fsm->getErrorPosition());
+    EXPECT_EQ('x', fsm->getErrorRecord().character);
+    EXPECT_STREQ("NO_MATCHING_TRANSITION", FSM::errorTypeToString(fsm->getErrorType()));
+
+    auto error = fsm->getLastError();
+    ASSERT_TRUE(error.has_value());
+    EXPECT_EQ("DIGITS", error->current_state.name);
+    EXPECT_EQ("No transition found from DIGITS for character 'x'", error->message);
+    EXPECT_EQ("123x5", error->input_context);
+
+    EXPECT_TRUE(fsm->validate("12"));
+    EXPECT_FALSE(fsm->hasError());
+    EXPECT_FALSE(fsm->getLastError().has_value());
+}
+
 TEST_F(FsmTest, BuilderErrorNoStartState)
 {
     EXPECT_THROW({ auto fsm = FSM::Builder("bad")
@@ -394,6 +533,255 @@ TEST_F(FsmTest, BuilderErrorNoAcceptState)
                                   .build(); }, std::logic_error);
 }
 
+// ============================================================================
+// Static Analysis Tests
+// ============================================================================
+
+namespace
+{
+    // TRAP can never reach ACCEPT; ORPHAN is never reached from START.
+    std::shared_ptr<FSM> buildWithTrap()
+    {
+        return FSM::Builder("trap")
+            .addState("START", StateType::START)
+            .addState("DIGITS")
+            .addState("ACCEPT", StateType::ACCEPT)
+            .addState("TRAP")
+            .addState("ORPHAN")
+            .setStartState("START")
+            .addAcceptState("ACCEPT")
+            .addTransition("START", "DIGITS", ABNF::digit())
+            .addTransition("START", "TRAP", ABNF::alpha())
+            .addTransition("DIGITS", "DIGITS", ABNF::digit())
+            .addTransition("DIGITS", "ACCEPT", ABNF::literal(';'))
+            .addTransition("TRAP", "TRAP", ABNF::alpha())
+            .addTransition("ORPHAN", "ACCEPT", ABNF::digit())
+            .build();
+    }
+}
+
+TEST_F(FsmTest, ReachabilityAnalysis)
+{
+    auto fsm = buildWithTrap();
+
+    const auto unreachable = fsm->getUnreachableStates();
+    ASSERT_EQ(1, unreachable.size());
+    EXPECT_EQ("ORPHAN", unreachable[0].name);
+
+    const auto dead = fsm->getDeadStates();
+    ASSERT_EQ(1, dead.size());
+    EXPECT_EQ("TRAP", dead[0].name);
+    EXPECT_TRUE(fsm->isDeadState(dead[0]));
+    EXPECT_FALSE(fsm->isDeadState(fsm->getStartState()));
+
+    // Unreachable states are only reported by the analysis, not as errors.
+    EXPECT_TRUE(fsm->isValid());
+
+    EXPECT_EQ(1, fsm->pruneUnreachableStates());
+    EXPECT_EQ(4, fsm->getStateCount());
+    EXPECT_TRUE(fsm->getUnreachableStates().empty());
+    EXPECT_TRUE(fsm->validate("42;"));
+}
+
+TEST_F(FsmTest, DeadStateRejectsEarly)
+{
+    auto fsm = buildWithTrap();
+    const std::string payload = "x" + std::string(1 << 16, 'y');
+
+    EXPECT_FALSE(fsm->validate(payload));
+    EXPECT_EQ(FSM::ErrorType::NO_MATCHING_TRANSITION, fsm->getErrorType());
+    EXPECT_EQ(0, fsm->getErrorPosition());
+    EXPECT_NE(std::string::npos, fsm->getLastError()->message.find("dead state TRAP"));
+
+    fsm->reset();
+    EXPECT_EQ(StreamState::ERROR, fsm->feed(payload));
+    EXPECT_EQ(0, fsm->getErrorPosition());
+
+    EXPECT_TRUE(fsm->validate("12;"));
+}
+
+namespace
+{
+    // "GIF8" then anything: BODY accepts every byte and never leaves.
+    std::shared_ptr<FSM> buildPrefix()
+    {
+        return FSM::Builder("prefix")
+            .addState("S0", StateType::START)
+            .addState("S1")
+            .addState("S2")
+            .addState("S3")
+            .addState("BODY", StateType::ACCEPT)
+            .setStartState("S0")
+            .addAcceptState("BODY")
+            .addTransition("S0", "S1", ABNF::literal('G'))
+            .addTransition("S1", "S2", ABNF::literal('I'))
+            .addTransition("S2", "S3", ABNF::literal('F'))
+            .addTransition("S3", "BODY", ABNF::literal('8'))
+            .addTransition("BODY", "BODY", ABNF::octet())
+            .build();
+    }
+}
+
+TEST_F(FsmTest, AcceptSinkStopsScanning)
+{
+    auto fsm = buildPrefix();
+    fsm->getDebugConfig().enable(DebugFlags::COLLECT_METRICS);
+
+    const auto sinks = fsm->getAcceptSinkStates();
+    ASSERT_EQ(1, sinks.size());
+    EXPECT_EQ("BODY", sinks[0].name);
+    EXPECT_FALSE(fsm->isAcceptSink(fsm->getStartState()));
+
+    const std::string payload = "GIF8" + std::string(1 << 20, '\xff');
+    EXPECT_TRUE(fsm->validate(payload));
+    EXPECT_EQ(4, fsm->getMetrics().characters_processed);
+    EXPECT_FALSE(fsm->validate("GIF7" + payload));
+
+    fsm->reset();
+    EXPECT_EQ(StreamState::WAITING_FOR_INPUT, fsm->feed("GI"));
+    EXPECT_EQ(StreamState::ACCEPTED, fsm->feed("F8 and the rest"));
+    EXPECT_TRUE(fsm->isStreamComplete());
+    EXPECT_EQ(StreamState::ACCEPTED, fsm->feed(payload));
+    EXPECT_EQ(StreamState::COMPLETE, fsm->endOfStream());
+    EXPECT_EQ("ACCEPTED", FSM::streamStateToString(StreamState::ACCEPTED));
+}
+
+TEST_F(FsmTest, CallbacksOrPartialCoverageAreNotSinks)
+{
+    auto partial = FSM::Builder("partial")
+                       .addState("S", StateType::START)
+                       .addState("A", StateType::ACCEPT)
+                       .setStartState("S")
+                       .addAcceptState("A")
+                       .addTransition("S", "A", ABNF::digit())
+                       .addTransition("A", "A", ABNF::vchar())
+                       .build();
+    EXPECT_TRUE(partial->getAcceptSinkStates().empty());
+    EXPECT_FALSE(partial->validate("1abc\x01"));
+
+    int loops = 0;
+    auto observed = FSM::Builder("observed")
+                        .addState("S", StateType::START)
+                        .addState("A", StateType::ACCEPT)
+                        .setStartState("S")
+                        .addAcceptState("A")
+                        .addTransition("S", "A", ABNF::digit())
+                        .addTransition("A", "A", ABNF::octet())
+                        .build();
+    observed->setTransitionCallback(observed->getTransitions()[1].id, [&loops](const TransitionContext &)
+                                    { ++loops; });
+    EXPECT_TRUE(observed->getAcceptSinkStates().empty());
+    EXPECT_TRUE(observed->validate("1abc"));
+    EXPECT_EQ(3, loops);
+}
+
+TEST_F(FsmTest, DeterministicMachineRunsOnTable)
+{
+    auto fsm = buildWithTrap();
+    EXPECT_TRUE(fsm->isDeterministic());
+    EXPECT_TRUE(fsm->getAmbiguities().empty());
+    EXPECT_EQ(FSM::Engine::AUTO, fsm->getEngine());
+    EXPECT_EQ(FSM::Engine::TABLE, fsm->getSelectedEngine());
+
+    auto reference = buildWithTrap();
+    reference->setEngine(FSM::Engine::INTERPRETER);
+
+    for (const char *input : {"42;", "", "4", "x", "4x", "42;7", "xyz"})
+    {
+        EXPECT_EQ(reference->validate(input), fsm->validate(input)) << input;
+        EXPECT_EQ(reference->getCurrentState(), fsm->getCurrentState()) << input;
+        ASSERT_EQ(reference->hasError(), fsm->hasError()) << input;
+        if (reference->hasError())
+        {
+            EXPECT_EQ(reference->getErrorType(), fsm->getErrorType()) << input;
+            EXPECT_EQ(reference->getErrorPosition(), fsm->getErrorPosition()) << input;
+            EXPECT_EQ(reference->getLastError()->message, fsm->getLastError()->message) << input;
+        }
+    }
+
+    int entries = 0;
+    fsm->setStateEntryCallback(fsm->getStartState(), [&entries](const StateContext &)
+                               { ++entries; });
+    EXPECT_EQ(FSM::Engine::INTERPRETER, fsm->getSelectedEngine());
+}
+
+TEST_F(FsmTest, EpsilonOverlapIsDeterministic)
+{
+    // M -> A and M -> B are both epsilon edges; only B accepts.
+    auto build = []
+    {
+        return FSM::Builder("epsilon")
+            .addState("S", StateType::START)
+            .addState("M")
+            .addState("A")
+            .addState("B", StateType::ACCEPT)
+            .setStartState("S")
+            .addAcceptState("B")
+            .addTransition("S", "M", ABNF::literal('x'))
+            .addEpsilonTransition("M", "A")
+            .addEpsilonTransition("M", "B")
+            .build();
+    };
+
+    auto fsm = build();
+    const auto ambiguities = fsm->getAmbiguities();
+    ASSERT_EQ(1, ambiguities.size());
+    EXPECT_EQ(TransitionType::EPSILON, ambiguities[0].type);
+    EXPECT_FALSE(ambiguities[0].resolved_by_priority);
+
+    // isDeterministic() and engine selection agree, and every engine takes
+    // the first epsilon edge.
+    EXPECT_TRUE(fsm->isDeterministic());
+    EXPECT_NE(FSM::Engine::BACKTRACKING, fsm->getSelectedEngine());
+    EXPECT_FALSE(fsm->validate("x"));
+    EXPECT_EQ("A", fsm->getCurrentState().name);
+
+    for (FSM::Engine engine : {FSM::Engine::TABLE, FSM::Engine::INTERPRETER, FSM::Engine::BACKTRACKING,
+                               FSM::Engine::KEYWORDS})
+    {
+        auto forced = build();
+        forced->setEngine(engine);
+        EXPECT_FALSE(forced->validate("x")) << FSM::engineToString(engine);
+        EXPECT_EQ("A", forced->getCurrentState().name) << FSM::engineToString(engine);
+        EXPECT_EQ(FSM::ErrorType::NOT_IN_ACCEPT_STATE, forced->getErrorType()) << FSM::engineToString(engine);
+    }
+}
+
+TEST_F(FsmTest, PriorityResolvedOverlapIsReported)
+{
+    std::ostringstream log;
+    auto fsm = FSM::Builder("keyword")
+                   .addState("START", StateType::START)
+                   .addState("KEYWORD", StateType::ACCEPT)
+                   .addState("NAME", StateType::ACCEPT)
+                   .setStartState("START")
+                   .addAcceptState("KEYWORD")
+                   .addAcceptState("NAME")
+                   .addTransition("START", "KEYWORD", ABNF::literal('x'), Transition::PRIORITY_HIGH)
+                   .addTransition("START", "NAME", ABNF::alpha())
+                   .addTransition("START", "KEYWORD", ABNF::range('a', 'c'), Transition::PRIORITY_LOW)
+                   .enableDebugFlag(DebugFlags::VERBOSE_ERRORS)
+                   .withDebugOutput(log)
+                   .build();
+
+    const auto ambiguities = fsm->getAmbiguities();
+    ASSERT_EQ(2, ambiguities.size());
+    EXPECT_EQ(TransitionType::ABNF_RULE, ambiguities[0].type);
+    EXPECT_EQ(1, ambiguities[0].shared_bytes);
+    EXPECT_TRUE(ambiguities[0].resolved_by_priority);
+    EXPECT_FALSE(ambiguities[0].shadowed);
+    EXPECT_EQ(3, ambiguities[1].shared_bytes);
+    EXPECT_TRUE(ambiguities[1].shadowed);
+
+    EXPECT_TRUE(fsm->isDeterministic());
+    EXPECT_EQ(FSM::Engine::KEYWORDS, fsm->getSelectedEngine()); // 52 one-letter strings
+    EXPECT_NE(std::string::npos, log.str().find("Warning: priority order hides overlap in START"));
+
+    EXPECT_TRUE(fsm->validate("x"));
+    EXPECT_EQ("KEYWORD", fsm->getCurrentState().name);
+    EXPECT_STREQ("TABLE", FSM::engineToString(FSM::Engine::TABLE));
+}
+
 // ============================================================================
 // Reset Tests
 // ============================================================================
@@ -514,6 +902,30 @@ TEST_F(FsmTest, DebugFlags)
     EXPECT_EQ(1, metrics.characters_processed);
 }
 
+TEST_F(FsmTest, ResetDropsTrace)
+{
+    auto fsm = FSM::Builder("trace_reset")
+                   .setDebugFlags(DebugFlags::TRACE_TRANSITIONS)
+                   .addState("START", StateType::START)
+                   .addState("ACCEPT", StateType::ACCEPT)
+                   .setStartState("START")
+                   .addAcceptState("ACCEPT")
+                   .addTransition("START", "ACCEPT", ABNF::digit())
+                   .addTransition("ACCEPT", "ACCEPT", ABNF::digit())
+                   .build();
+
+    fsm->validate("123");
+    EXPECT_EQ(3, fsm->getTrace().size());
+
+    fsm->reset();
+    EXPECT_TRUE(fsm->getTrace().empty());
+
+    fsm->validate("45");
+    ASSERT_EQ(2, fsm->getTrace().size());
+    EXPECT_EQ(0, fsm->getTrace()[0].step);
+    EXPECT_EQ(1, fsm->getTrace()[1].step);
+}
+
 TEST_F(FsmTest, DOTExport)
 {
     auto fsm = FSM::Builder("dot_test")
@@ -0,0 +1,354 @@
+#include <gtest/gtest.h>
+#include <fsm/fsm.hpp>
+#include <fsm/instrumentation.hpp>
+#include <fsm/matcher.hpp>
+#include <abnf/abnf.hpp>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace fsm;
+using namespace abnf;
+
+class InstrumentationTest : public ::testing::Test
+{
+protected:
+    void SetUp() override {}
+    void TearDown() override {}
+
+    static std::shared_ptr<FSM> buildNumber()
+    {
+        return FSM::Builder("number")
+            .addState("START", StateType::START)
+            .addState("DIGITS", StateType::ACCEPT)
+            .setStartState("START")
+            .addAcceptState("DIGITS")
+            .addTransition("START", "DIGITS", ABNF::digit())
+            .addTransition("DIGITS", "DIGITS", ABNF::digit())
+            .build();
+    }
+
+    static StateID stateNamed(const FSM &fsm, const std::string &name)
+    {
+        for (const auto &id : fsm.getStates())
+        {
+            if (id.name == name)
+            {
+                return id;
+            }
+        }
+        return StateID();
+    }
+};
+
+// ============================================================================
+// FSM Integration
+// ============================================================================
+
+TEST_F(InstrumentationTest, CountsValidationsAndRejects)
+{
+    auto fsm = buildNumber();
+    auto registry = std::make_shared<MetricsRegistry>(*fsm);
+    fsm->setMetricsRegistry(registry);
+
+    EXPECT_TRUE(fsm->validate("123"));
+    EXPECT_TRUE(fsm->validate("4"));
+    EXPECT_FALSE(fsm->validate("12a"));
+    EXPECT_FALSE(fsm->validate(""));
+
+    auto snapshot = registry->snapshot();
+    EXPECT_EQ(4, snapshot.validations);
+    EXPECT_EQ(2, snapshot.getAccepted());
+    EXPECT_EQ(7, snapshot.bytes);
+    EXPECT_EQ(1, snapshot.getRejects(FSM::ErrorType::NO_MATCHING_TRANSITION));
+    EXPECT_EQ(1, snapshot.getRejects(FSM::ErrorType::LENGTH_OUT_OF_RANGE)); // shorter than any match
+    EXPECT_EQ(1, snapshot.shard_count);
+}
+
+TEST_F(InstrumentationTest, PerStateAndPerTransitionHits)
+{
+    auto fsm = buildNumber();
+    auto registry = std::make_shared<MetricsRegistry>(*fsm);
+    fsm->setMetricsRegistry(registry);
+
+    fsm->validate("1234");
+
+    auto transitions = fsm->getTransitions();
+    const Transition *first = nullptr;
+    const Transition *loop = nullptr;
+    for (const auto &trans : transitions)
+    {
+        (trans.from == trans.to ? loop : first) = &trans;
+    }
+    ASSERT_NE(nullptr, first);
+    ASSERT_NE(nullptr, loop);
+
+    auto snapshot = registry->snapshot();
+    EXPECT_EQ(1, snapshot.transition_hits[first->id]);
+    EXPECT_EQ(3, snapshot.transition_hits[loop->id]);
+    EXPECT_EQ(4, snapshot.state_visits[stateNamed(*fsm, "DIGITS").id]);
+    EXPECT_EQ(0, snapshot.state_visits[stateNamed(*fsm, "START").id]);
+
+    registry->reset();
+    EXPECT_EQ(0, registry->snapshot().validations);
+}
+
+TEST_F(InstrumentationTest, StreamingOutcomes)
+{
+    auto fsm = buildNumber();
+    auto registry = std::make_shared<MetricsRegistry>(*fsm);
+    fsm->setMetricsRegistry(registry);
+
+    fsm->reset();
+    fsm->feed("12");
+    fsm->feed("3");
+    EXPECT_EQ(StreamState::COMPLETE, fsm->endOfStream());
+
+    fsm->reset();
+    EXPECT_EQ(StreamState::ERROR, fsm->feed("1x"));
+
+    // End of stream without a feed is not a run.
+    fsm->reset();
+    EXPECT_EQ(StreamState::ERROR, fsm->endOfStream());
+    InstrumentedMatcher matcher(*fsm);
+    EXPECT_EQ(StreamState::ERROR, matcher.endOfStream());
+    EXPECT_EQ(FSM::ErrorType::UNEXPECTED_END_OF_INPUT, matcher.getErrorType());
+
+    auto snapshot = registry->snapshot();
+    EXPECT_EQ(2, snapshot.validations);
+    EXPECT_EQ(1, snapshot.getRejects());
+}
+
+TEST_F(InstrumentationTest, MatcherAgreesWithInterpreter)
+{
+    auto fsm = buildNumber();
+    auto registry = std::make_shared<MetricsRegistry>(*fsm);
+    fsm->setMetricsRegistry(registry);
+
+    fsm->validate("987");
+    fsm->validate("9x");
+    auto expected = registry->snapshot();
+    registry->reset();
+
+    InstrumentedMatcher matcher(*fsm);
+    matcher.validate("987");
+    matcher.validate("9x");
+    auto actual = registry->snapshot();
+
+    EXPECT_EQ(expected.validations, actual.validations);
+    EXPECT_EQ(expected.bytes, actual.bytes);
+    EXPECT_EQ(expected.rejects, actual.rejects);
+    EXPECT_EQ(expected.state_visits, actual.state_visits);
+    EXPECT_EQ(expected.transition_hits, actual.transition_hits);
+
+    FastMatcher fast(*fsm);
+    fast.validate("987");
+    EXPECT_EQ(actual.validations, registry->snapshot().validations);
+}
+
+// ============================================================================
+// Sharding
+// ============================================================================
+
+TEST_F(InstrumentationTest, ThreadCacheForgetsDestroyedRegistries)
+{
+    const size_t before = MetricsRegistry::getThreadCacheSize();
+    MetricsRegistry kept(1, 1);
+    kept.local().recordValidation(1);
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        MetricsRegistry short_lived(1, 1);
+        short_lived.local().recordValidation(1);
+    }
+
+    // The kept registry and at most the last short-lived one
+    EXPECT_LE(MetricsRegistry::getThreadCacheSize(), before + 2);
+    kept.local().recordValidation(1);
+    EXPECT_EQ(2, kept.snapshot().validations);
+    EXPECT_EQ(1, kept.getShardCount());
+}
+
+TEST_F(InstrumentationTest, ThreadsMergeIntoOneSnapshot)
+{
+    auto prototype = buildNumber();
+    auto registry = std::make_shared<MetricsRegistry>(*prototype);
+    auto compiled = std::make_shared<const CompiledFSM>(*prototype);
+
+    constexpr size_t THREADS = 4;
+    constexpr size_t RUNS = 1000;
+
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < THREADS; ++t)
+    {
+        workers.emplace_back([&]()
+                             {
+                                 InstrumentedMatcher matcher(compiled);
+                                 matcher.setMetricsRegistry(registry);
+                                 for (size_t i = 0; i < RUNS; ++i)
+                                 {
+                                     matcher.validate(i % 10 == 0 ? "1a" : "12");
+                                 } });
+    }
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+
+    auto snapshot = registry->snapshot();
+    EXPECT_EQ(THREADS, snapshot.shard_count);
+    EXPECT_EQ(THREADS * RUNS, snapshot.validations);
+    EXPECT_EQ(THREADS * RUNS / 10, snapshot.getRejects(FSM::ErrorType::NO_MATCHING_TRANSITION));
+    EXPECT_EQ(THREADS * RUNS * 2, snapshot.bytes);
+    EXPECT_NE(std::string::npos, snapshot.toString().find("NO_MATCHING_TRANSITION=400"));
+}
+
+// ============================================================================
+// Profile-Guided Ordering
+// ============================================================================
+
+namespace
+{
+    // START -> A|B|C on disjoint literals; WORD (ALPHA) outranks the overlapping "x".
+    std::shared_ptr<FSM> buildDispatch()
+    {
+        return FSM::Builder("dispatch")
+            .addState("START", StateType::START)
+            .addState("A", StateType::ACCEPT)
+            .addState("B", StateType::ACCEPT)
+            .addState("C", StateType::ACCEPT)
+            .addState("WORD", StateType::ACCEPT)
+            .addState("X", StateType::ACCEPT)
+            .setStartState("START")
+            .addAcceptState("A")
+            .addAcceptState("B")
+            .addAcceptState("C")
+            .addAcceptState("WORD")
+            .addAcceptState("X")
+            .addTransition("START", "A", ABNF::literal('1'))
+            .addTransition("START", "B", ABNF::literal('2'))
+            .addTransition("START", "C", ABNF::literal('3'))
+            .addTransition("START", "WORD", ABNF::alpha(), Transition::PRIORITY_LOW)
+            .addTransition("START", "X", ABNF::literal('x'), Transition::PRIORITY_LOWEST)
+            .addTransition("C", "C", ABNF::digit())
+            .build();
+    }
+}
+
+TEST_F(InstrumentationTest, ProfileReordersDisjointTransitions)
+{
+    auto fsm = buildDispatch();
+    auto registry = std::make_shared<MetricsRegistry>(*fsm);
+    fsm->setMetricsRegistry(registry);
+
+    for (int i = 0; i < 10; ++i)
+    {
+        fsm->validate("3333");
+        fsm->validate("x");
+    }
+    fsm->validate("1");
+
+    const StateID start = stateNamed(*fsm, "START");
+    auto before = fsm->getTransitionsFrom(start);
+    EXPECT_EQ("A", before.front()->to.name);
+
+    fsm->applyProfile(Profile::fromSnapshot(fsm->getName(), registry->snapshot()));
+    ASSERT_TRUE(fsm->hasProfile());
+
+    auto after = fsm->getTransitionsFrom(start);
+    ASSERT_EQ(before.size(), after.size());
+    EXPECT_EQ("C", after[0]->to.name);
+
+    // "x" matches ALPHA too, so the hotter low-priority edge stays behind it.
+    size_t word = 0;
+    size_t x = 0;
+    for (size_t i = 0; i < after.size(); ++i)
+    {
+        word = after[i]->to.name == "WORD" ? i : word;
+        x = after[i]->to.name == "X" ? i : x;
+    }
+    EXPECT_LT(word, x);
+
+    EXPECT_TRUE(fsm->validate("x"));
+    EXPECT_EQ("WORD", fsm->getCurrentState().name);
+    EXPECT_TRUE(fsm->validate("2"));
+    EXPECT_EQ("B", fsm->getCurrentState().name);
+
+    CompiledFSM compiled(*fsm);
+    EXPECT_EQ("C", compiled.getStateID(0).name);
+
+    FastMatcher matcher(std::make_shared<const CompiledFSM>(*fsm));
+    for (const char *input : {"1", "2", "3", "3456", "x", "q", "12", ""})
+    {
+        EXPECT_EQ(fsm->validate(input), matcher.validate(input)) << input;
+        EXPECT_EQ(fsm->getCurrentState(), matcher.getCurrentState()) << input;
+    }
+
+    fsm->clearProfile();
+    EXPECT_EQ("A", fsm->getTransitionsFrom(start).front()->to.name);
+}
+
+TEST_F(InstrumentationTest, ProfileKeepsCallsBehindOverlappingRules)
+{
+    auto sub = FSM::Builder("ac")
+                   .addState("START", StateType::START)
+                   .addState("A")
+                   .addState("AC", StateType::ACCEPT)
+                   .setStartState("START")
+                   .addAcceptState("AC")
+                   .addTransition("START", "A", ABNF::literal('a'))
+                   .addTransition("A", "AC", ABNF::literal('c'))
+                   .build();
+
+    auto caller = std::make_shared<FSM>("caller");
+    const StateID start = caller->addState("START", StateType::START);
+    const StateID a = caller->addState("A");
+    const StateID end = caller->addState("END", StateType::ACCEPT);
+    caller->setStartState(start);
+    caller->addAcceptState(end);
+    const auto rule = caller->addTransition(start, a, ABNF::literal('a'));
+    caller->addTransition(a, end, ABNF::literal('b'));
+    const auto call = caller->addSubMachineTransition(start, end, sub);
+    EXPECT_TRUE(caller->validate("ab"));
+    EXPECT_FALSE(caller->validate("ac"));
+
+    // The call is entered on 'a' too, so however hot it is it must not be
+    // tried before the rule.
+    Profile profile{"caller", {}, std::vector<uint64_t>(call + 1, 0)};
+    profile.transition_hits[call] = 1000;
+    caller->applyProfile(profile);
+
+    const auto from_start = caller->getTransitionsFrom(start);
+    ASSERT_EQ(2u, from_start.size());
+    EXPECT_EQ(rule, from_start.front()->id);
+    EXPECT_TRUE(caller->validate("ab"));
+    EXPECT_FALSE(caller->validate("ac"));
+}
+
+TEST_F(InstrumentationTest, ProfileRoundTrip)
+{
+    Profile profile{"dispatch", {0, 5, 0, 7}, {0, 0, 3}};
+    std::stringstream buffer;
+    profile.write(buffer);
+
+    Profile loaded = Profile::read(buffer);
+    EXPECT_EQ("dispatch", loaded.machine);
+    EXPECT_EQ(profile.state_visits, loaded.state_visits);
+    EXPECT_EQ(profile.transition_hits, loaded.transition_hits);
+
+    loaded.merge(profile);
+    EXPECT_EQ(14, loaded.state_visits[3]);
+    EXPECT_THROW(loaded.merge(Profile{"other", {}, {}}), std::invalid_argument);
+
+    std::stringstream bad("fsm-profile 1\nstate 1\n");
+    EXPECT_THROW(Profile::read(bad), std::runtime_error);
+
+    // A corrupt id must not size the count vectors.
+    std::stringstream huge("fsm-profile 1\ntransition 4000000000 1\n");
+    EXPECT_THROW(Profile::read(huge), std::runtime_error);
+    std::stringstream above_machine("fsm-profile 1\nstate 9 1\n");
+    EXPECT_THROW(Profile::read(above_machine, 8), std::runtime_error);
+
+    auto fsm = buildNumber();
+    EXPECT_THROW(fsm->applyProfile(profile), std::invalid_argument);
+}
@@ -0,0 +1,205 @@
+#include <gtest/gtest.h>
+#include <fsm/fsm.hpp>
+#include <fsm/keywords.hpp>
+#include <abnf/abnf.hpp>
+#include <string>
+#include <vector>
+
+using namespace fsm;
+using namespace abnf;
+
+class KeywordSetTest : public ::testing::Test
+{
+protected:
+    void SetUp() override {}
+    void TearDown() override {}
+
+    // Example 2 from the README, plus an epsilon exit after HEAD.
+    static std::shared_ptr<FSM> buildHttpMethod()
+    {
+        return FSM::Builder("http_method")
+            .addState("START", StateType::START)
+            .addState("G")
+            .addState("GE")
+            .addState("P")
+            .addState("PO")
+            .addState("POS")
+            .addState("H")
+            .addState("HE")
+            .addState("HEA")
+            .addState("HEAD")
+            .addState("GET", StateType::ACCEPT)
+            .addState("POST", StateType::ACCEPT)
+            .addState("DONE", StateType::ACCEPT)
+            .setStartState("START")
+            .addAcceptState("GET")
+            .addAcceptState("POST")
+            .addAcceptState("DONE")
+            .addTransition("START", "G", ABNF::literal('G'))
+            .addTransition("G", "GE", ABNF::literal('E'))
+            .addTransition("GE", "GET", ABNF::literal('T'))
+            .addTransition("START", "P", ABNF::literal('P'))
+            .addTransition("P", "PO", ABNF::literal('O'))
+            .addTransition("PO", "POS", ABNF::literal('S'))
+            .addTransition("POS", "POST", ABNF::literal('T'))
+            .addTransition("START", "H", ABNF::literal('H'))
+            .addTransition("H", "HE", ABNF::literal('E'))
+            .addTransition("HE", "HEA", ABNF::literal('A'))
+            .addTransition("HEA", "HEAD", ABNF::literal('D'))
+            .addEpsilonTransition("HEAD", "DONE")
+            .build();
+    }
+};
+
+// ============================================================================
+// Lookup Tests
+// ============================================================================
+
+TEST_F(KeywordSetTest, FindsEveryKeywordAndNothingElse)
+{
+    const std::vector<std::string> methods = {"GET", "HEAD", "POST", "PUT", "DELETE",
+                                              "CONNECT", "OPTIONS", "TRACE", "PATCH", ""};
+    KeywordSet::Builder builder;
+    for (const std::string &method : methods)
+    {
+        builder.add(method);
+    }
+    const KeywordSet set = builder.build();
+
+    ASSERT_EQ(methods.size(), set.size());
+    for (KeywordSet::KeywordID id = 0; id < methods.size(); ++id)
+    {
+        EXPECT_EQ(id, set.find(methods[id])) << methods[id];
+        EXPECT_EQ(methods[id], set.getKeyword(id));
+    }
+
+    for (const char *miss : {"GETS", "get", "PUTT", "PU", "POSX", "OPTIONZ", "X", "DELETED"})
+    {
+        EXPECT_EQ(KeywordSet::NO_KEYWORD, set.find(miss)) << miss;
+    }
+    EXPECT_FALSE(set.contains(std::string(300, 'G')));
+
+    // Length plus a handful of bytes is enough to tell the methods apart.
+    EXPECT_FALSE(set.getKeyPositions().empty());
+    EXPECT_LE(set.getKeyPositions().size(), 3u);
+    EXPECT_GE(set.getSlotCount(), set.size());
+    EXPECT_NE(std::string::npos, set.toString().find("10 keywords"));
+}
+
+TEST_F(KeywordSetTest, LargeSetsStayCollisionFree)
+{
+    std::vector<std::string> keywords;
+    for (int i = 0; i < 2000; ++i)
+    {
+        keywords.push_back("header-" + std::to_string(i * 7919));
+    }
+    const KeywordSet set(keywords);
+
+    for (KeywordSet::KeywordID id = 0; id < keywords.size(); ++id)
+    {
+        ASSERT_EQ(id, set.find(keywords[id])) << keywords[id];
+    }
+    EXPECT_EQ(KeywordSet::NO_KEYWORD, set.find("header-1"));
+    EXPECT_EQ(KeywordSet::NO_KEYWORD, set.find("header-7918"));
+}
+
+TEST_F(KeywordSetTest, RejectsInvalidKeywords)
+{
+    EXPECT_THROW(KeywordSet::Builder().add("GET").add("GET").build(), std::invalid_argument);
+    EXPECT_THROW(KeywordSet(std::vector<std::string>{std::string(KeywordSet::MAX_LENGTH + 1, 'a')}),
+                 std::invalid_argument);
+
+    const KeywordSet empty(std::vector<std::string>{});
+    EXPECT_TRUE(empty.empty());
+    EXPECT_FALSE(empty.contains(""));
+    EXPECT_THROW((void)empty.getKeyword(0), std::out_of_range);
+    EXPECT_THROW((void)empty.getFinalState(0), std::logic_error);
+}
+
+// ============================================================================
+// FSM Front End
+// ============================================================================
+
+TEST_F(KeywordSetTest, CompilesFiniteFSM)
+{
+    auto fsm = buildHttpMethod();
+    const KeywordSet set(*fsm);
+
+    EXPECT_EQ((std::vector<std::string>{"GET", "HEAD", "POST"}), set.getKeywords());
+    EXPECT_EQ(1, set.find("HEAD"));
+    EXPECT_EQ("DONE", set.getFinalState(set.find("HEAD")).name);
+    EXPECT_EQ("GET", set.getFinalState(set.find("GET")).name);
+
+    EXPECT_THROW(KeywordSet(*fsm, 2), std::invalid_argument);
+
+    auto digits = FSM::Builder("digits")
+                      .addState("START", StateType::START)
+                      .addState("DIGITS", StateType::ACCEPT)
+                      .setStartState("START")
+                      .addAcceptState("DIGITS")
+                      .addTransition("START", "DIGITS", ABNF::digit())
+                      .addTransition("DIGITS", "DIGITS", ABNF::digit())
+                      .build();
+    EXPECT_THROW(KeywordSet{*digits}, std::invalid_argument);
+}
+
+TEST_F(KeywordSetTest, PrioritiesDecideTheLanguage)
+{
+    // "ab" is shadowed: the high-priority 'a' edge leads to a state that
+    // only accepts end of input.
+    auto fsm = FSM::Builder("shadow")
+                   .addState("START", StateType::START)
+                   .addState("A", StateType::ACCEPT)
+                   .addState("B")
+                   .addState("AB", StateType::ACCEPT)
+                   .setStartState("START")
+                   .addAcceptState("A")
+                   .addAcceptState("AB")
+                   .addTransition("START", "A", ABNF::literal('a'), Transition::PRIORITY_HIGH)
+                   .addTransition("START", "B", ABNF::literal('a'))
+                   .addTransition("B", "AB", ABNF::literal('b'))
+                   .build();
+
+    EXPECT_EQ((std::vector<std::string>{"a"}), KeywordSet(*fsm).getKeywords());
+    EXPECT_EQ(fsm->validate("a"), KeywordSet(*fsm).contains("a"));
+    EXPECT_EQ(fsm->validate("ab"), KeywordSet(*fsm).contains("ab"));
+}
+
+TEST_F(KeywordSetTest, EngineMatchesInterpreter)
+{
+    auto fsm = buildHttpMethod();
+    EXPECT_EQ(FSM::Engine::KEYWORDS, fsm->getSelectedEngine());
+    EXPECT_STREQ("KEYWORDS", FSM::engineToString(FSM::Engine::KEYWORDS));
+
+    auto reference = buildHttpMethod();
+    reference->setEngine(FSM::Engine::INTERPRETER);
+
+    for (const char *input : {"GET", "HEAD", "POST", "", "G", "GETX", "PUT", "HEAE", "POSTS"})
+    {
+        EXPECT_EQ(reference->validate(input), fsm->validate(input)) << input;
+        EXPECT_EQ(reference->getCurrentState(), fsm->getCurrentState()) << input;
+        EXPECT_EQ(reference->isInAcceptState(), fsm->isInAcceptState()) << input;
+        ASSERT_EQ(reference->hasError(), fsm->hasError()) << input;
+        if (reference->hasError())
+        {
+            EXPECT_EQ(reference->getErrorType(), fsm->getErrorType()) << input;
+            EXPECT_EQ(reference->getErrorPosition(), fsm->getErrorPosition()) << input;
+        }
+    }
+
+    // Editing the machine recompiles the set.
+    StateID p;
+    for (const StateID &id : fsm->getStates())
+    {
+        p = id.name == "P" ? id : p;
+    }
+    const StateID pu = fsm->addState("PU");
+    const StateID put = fsm->addState("PUT", StateType::ACCEPT);
+    fsm->addAcceptState(put);
+    fsm->addTransition(p, pu, ABNF::literal('U'));
+    fsm->addTransition(pu, put, ABNF::literal('T'));
+
+    EXPECT_EQ(FSM::Engine::KEYWORDS, fsm->getSelectedEngine());
+    EXPECT_TRUE(fsm->validate("PUT"));
+    EXPECT_EQ(put, fsm->getCurrentState());
+}
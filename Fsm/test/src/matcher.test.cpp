@@ -0,0 +1,427 @@
+#include <gtest/gtest.h>
+#include <fsm/fsm.hpp>
+#include <fsm/matcher.hpp>
+#include <abnf/abnf.hpp>
+#include <sstream>
+
+using namespace fsm;
+using namespace abnf;
+
+class MatcherTest : public ::testing::Test
+{
+protected:
+    void SetUp() override {}
+    void TearDown() override {}
+
+    static std::shared_ptr<FSM> buildEmail(DebugFlags flags = DebugFlags::NONE)
+    {
+        return FSM::Builder("simple_email")
+            .setDebugFlags(flags)
+            .addState("START", StateType::START)
+            .addState("LOCAL")
+            .addState("AT")
+            .addState("DOMAIN", StateType::ACCEPT)
+            .setStartState("START")
+            .addAcceptState("DOMAIN")
+            .addTransition("START", "LOCAL", ABNF::alpha())
+            .addTransition("LOCAL", "LOCAL", ABNF::alpha())
+            .addTransition("LOCAL", "AT", ABNF::literal('@'))
+            .addTransition("AT", "DOMAIN", ABNF::alpha())
+            .addTransition("DOMAIN", "DOMAIN", ABNF::alpha())
+            .build();
+    }
+};
+
+// ============================================================================
+// Compilation Tests
+// ============================================================================
+
+TEST_F(MatcherTest, ByteClassesMergeEquivalentBytes)
+{
+    auto fsm = FSM::Builder("digits")
+                   .addState("START", StateType::START)
+                   .addState("DIGITS", StateType::ACCEPT)
+                   .setStartState("START")
+                   .addAcceptState("DIGITS")
+                   .addTransition("START", "DIGITS", ABNF::digit())
+                   .addTransition("DIGITS", "DIGITS", ABNF::digit())
+                   .build();
+
+    CompiledFSM compiled(*fsm);
+
+    EXPECT_EQ(2, compiled.getStateCount());
+    EXPECT_EQ(2, compiled.getClassCount());
+    EXPECT_EQ(compiled.getByteClass('0'), compiled.getByteClass('9'));
+    EXPECT_NE(compiled.getByteClass('0'), compiled.getByteClass('a'));
+}
+
+TEST_F(MatcherTest, TableWidthFollowsStateCount)
+{
+    CompiledFSM small(*buildEmail());
+    EXPECT_EQ(CompiledFSM::TableWidth::BITS_8, small.getTableWidth());
+    EXPECT_NE(nullptr, small.getTable<uint8_t>());
+    EXPECT_EQ(nullptr, small.getTable<uint16_t>());
+
+    // A 300-state chain of digits needs 16-bit cells.
+    FSM::Builder builder("long_chain");
+    builder.addState("S0", StateType::START).setStartState("S0");
+    for (int i = 1; i < 300; ++i)
+    {
+        builder.addState("S" + std::to_string(i))
+            .addTransition("S" + std::to_string(i - 1), "S" + std::to_string(i), ABNF::digit());
+    }
+    builder.addAcceptState("S299");
+    auto fsm = builder.build();
+
+    CompiledFSM large(*fsm);
+    EXPECT_EQ(CompiledFSM::TableWidth::BITS_16, large.getTableWidth());
+    EXPECT_EQ(CompiledFSM::TableWidth::BITS_16, large.getEdgeWidth());
+    EXPECT_EQ(CompiledFSM::TableWidth::BITS_8, small.getEdgeWidth());
+
+    // 16-bit next cells plus 16-bit edges for every slot
+    EXPECT_EQ(large.getClassCount() * large.getStateCount() * (2 + 2) + 256, large.getTableBytes());
+    EXPECT_EQ(CompiledFSM::DEAD_STATE, large.next(large.getStartState(), 'x'));
+    EXPECT_EQ(CompiledFSM::NO_EDGE, large.edge(large.getStartState(), 'x'));
+    EXPECT_EQ(large.next(large.getStartState(), '7'), large.getTarget(large.edge(large.getStartState(), '7')));
+
+    FastMatcher matcher(*fsm);
+    EXPECT_TRUE(matcher.validate(std::string(299, '7')));
+    EXPECT_FALSE(matcher.validate(std::string(298, '7')));
+    EXPECT_FALSE(matcher.validate(std::string(300, '7')));
+    EXPECT_EQ(299, matcher.getErrorPosition());
+}
+
+TEST_F(MatcherTest, CombLayoutAgreesWithDense)
+{
+    // A keyword chain: every state has one live class out of 27.
+    const std::string keyword = "thequickbrownfoxjumpsoverthelazydog";
+    FSM::Builder builder("keyword");
+    builder.addState("S0", StateType::START).setStartState("S0");
+    for (size_t i = 1; i <= keyword.size(); ++i)
+    {
+        builder.addState("S" + std::to_string(i))
+            .addTransition("S" + std::to_string(i - 1), "S" + std::to_string(i), ABNF::literal(keyword[i - 1]));
+    }
+    builder.addAcceptState("S" + std::to_string(keyword.size()));
+    auto fsm = builder.build();
+
+    CompiledFSM dense(*fsm, CompiledFSM::TableLayout::DENSE);
+    CompiledFSM comb(*fsm, CompiledFSM::TableLayout::COMB);
+    EXPECT_EQ(CompiledFSM::TableLayout::DENSE, CompiledFSM(*fsm).getTableLayout());
+    EXPECT_EQ(CompiledFSM::TableLayout::COMB, comb.getTableLayout());
+    EXPECT_EQ(nullptr, comb.getTable<uint8_t>());
+    EXPECT_LT(comb.getTableBytes(), dense.getTableBytes());
+
+    for (CompiledFSM::StateIndex state = 0; state < dense.getStateCount(); ++state)
+    {
+        const CompiledFSM::StateIndex mapped = comb.indexOf(dense.getStateID(state));
+        for (int byte = 0; byte < 256; ++byte)
+        {
+            const auto d = dense.next(state, static_cast<unsigned char>(byte));
+            const auto c = comb.next(mapped, static_cast<unsigned char>(byte));
+            ASSERT_EQ(d == CompiledFSM::DEAD_STATE, c == CompiledFSM::DEAD_STATE);
+            if (d != CompiledFSM::DEAD_STATE)
+            {
+                EXPECT_EQ(dense.getStateID(d), comb.getStateID(c));
+            }
+        }
+    }
+
+    FastMatcher matcher(std::make_shared<const CompiledFSM>(*fsm, CompiledFSM::TableLayout::COMB));
+    EXPECT_TRUE(matcher.validate(keyword));
+    EXPECT_FALSE(matcher.validate("thequickbrownfoxjumpsoverthelazycat"));
+    EXPECT_EQ(32, matcher.getErrorPosition());
+}
+
+TEST_F(MatcherTest, CompilerDropsUnreachableAndDeadEdges)
+{
+    auto fsm = FSM::Builder("trap")
+                   .addState("START", StateType::START)
+                   .addState("DIGITS", StateType::ACCEPT)
+                   .addState("TRAP")
+                   .addState("ORPHAN")
+                   .setStartState("START")
+                   .addAcceptState("DIGITS")
+                   .addTransition("START", "DIGITS", ABNF::digit())
+                   .addTransition("START", "TRAP", ABNF::alpha())
+                   .addTransition("DIGITS", "DIGITS", ABNF::digit())
+                   .addTransition("TRAP", "TRAP", ABNF::alpha())
+                   .addTransition("ORPHAN", "DIGITS", ABNF::digit())
+                   .build();
+
+    CompiledFSM compiled(*fsm);
+    EXPECT_EQ(3, compiled.getStateCount());
+    for (const StateID &id : fsm->getStates())
+    {
+        EXPECT_EQ(id.name == "ORPHAN", compiled.indexOf(id) == CompiledFSM::DEAD_STATE);
+    }
+    EXPECT_EQ(CompiledFSM::DEAD_STATE, compiled.next(compiled.getStartState(), 'a'));
+
+    FastMatcher matcher(*fsm);
+    EXPECT_FALSE(matcher.validate("a" + std::string(1024, 'b')));
+    EXPECT_EQ(0, matcher.getErrorPosition());
+    EXPECT_TRUE(matcher.validate("123"));
+}
+
+TEST_F(MatcherTest, AcceptSinkEndsScanEarly)
+{
+    auto fsm = FSM::Builder("prefix")
+                   .addState("S", StateType::START)
+                   .addState("P")
+                   .addState("BODY", StateType::ACCEPT)
+                   .setStartState("S")
+                   .addAcceptState("BODY")
+                   .addTransition("S", "P", ABNF::literal('%'))
+                   .addTransition("P", "BODY", ABNF::literal('!'))
+                   .addTransition("BODY", "BODY", ABNF::octet())
+                   .build();
+
+    auto compiled = std::make_shared<const CompiledFSM>(*fsm);
+    ASSERT_TRUE(compiled->hasAcceptSinks());
+    EXPECT_TRUE(compiled->isAcceptSink(compiled->indexOf(*fsm->getAcceptStates().begin())));
+    EXPECT_FALSE(compiled->isAcceptSink(compiled->getStartState()));
+
+    FastMatcher matcher(compiled);
+    const std::string body(1 << 20, '\0');
+    EXPECT_TRUE(matcher.validate("%!" + body));
+    EXPECT_FALSE(matcher.validate("%?" + body));
+
+    matcher.reset();
+    EXPECT_EQ(StreamState::ACCEPTED, matcher.feed("%!x"));
+    EXPECT_EQ(StreamState::ACCEPTED, matcher.feed(body));
+    EXPECT_EQ(StreamState::COMPLETE, matcher.endOfStream());
+
+    DebugMatcher debug(*fsm);
+    EXPECT_TRUE(debug.validate("%!" + body));
+}
+
+TEST_F(MatcherTest, LengthBoundsRejectUpFront)
+{
+    auto fsm = FSM::Builder("pair")
+                   .addState("S", StateType::START)
+                   .addState("D")
+                   .addState("END", StateType::ACCEPT)
+                   .setStartState("S")
+                   .addAcceptState("END")
+                   .addTransition("S", "D", ABNF::digit())
+                   .addTransition("D", "END", ABNF::digit())
+                   .build();
+
+    FastMatcher matcher(*fsm);
+    EXPECT_EQ(2, matcher.getCompiled().getLengthBounds().max);
+    EXPECT_TRUE(matcher.validate("42"));
+
+    EXPECT_FALSE(matcher.validate(std::string(4096, '4')));
+    EXPECT_EQ(FSM::ErrorType::LENGTH_OUT_OF_RANGE, matcher.getErrorType());
+    EXPECT_EQ(2, matcher.getErrorPosition());
+
+    matcher.reset();
+    EXPECT_EQ(StreamState::WAITING_FOR_INPUT, matcher.feed("4"));
+    EXPECT_EQ(StreamState::ERROR, matcher.feed("x" + std::string(4096, '4')));
+    EXPECT_EQ(FSM::ErrorType::NO_MATCHING_TRANSITION, matcher.getErrorType());
+
+    matcher.reset();
+    EXPECT_EQ(StreamState::ERROR, matcher.feed("4242"));
+    EXPECT_EQ(FSM::ErrorType::LENGTH_OUT_OF_RANGE, matcher.getErrorType());
+    EXPECT_EQ(2, matcher.getErrorPosition());
+}
+
+TEST_F(MatcherTest, LengthBoundsKeepCallbacksFiring)
+{
+    std::vector<size_t> positions;
+
+    auto fsm = FSM::Builder("pair")
+                   .addState("S", StateType::START)
+                   .addState("D")
+                   .addState("END", StateType::ACCEPT)
+                   .setStartState("S")
+                   .addAcceptState("END")
+                   .addTransition("S", "D", ABNF::digit())
+                   .onTransition([&positions](const TransitionContext &ctx)
+                                 { positions.push_back(ctx.position); })
+                   .addTransition("D", "END", ABNF::digit())
+                   .build();
+
+    // Callbacks see the bytes before the reject, as FSM::validate() does.
+    EXPECT_FALSE(fsm->validate("444"));
+    const std::vector<size_t> expected = positions;
+    ASSERT_FALSE(expected.empty());
+
+    positions.clear();
+    DebugMatcher debug(*fsm);
+    EXPECT_FALSE(debug.validate("444"));
+    EXPECT_EQ(FSM::ErrorType::NO_MATCHING_TRANSITION, debug.getErrorType());
+    EXPECT_EQ(2, debug.getErrorPosition());
+    EXPECT_EQ(expected, positions);
+
+    // Without callback dispatch the length alone rejects.
+    positions.clear();
+    FastMatcher fast(*fsm);
+    EXPECT_FALSE(fast.validate("444"));
+    EXPECT_EQ(FSM::ErrorType::LENGTH_OUT_OF_RANGE, fast.getErrorType());
+    EXPECT_TRUE(positions.empty());
+}
+
+// ============================================================================
+// Production Policy Tests
+// ============================================================================
+
+TEST_F(MatcherTest, FastMatcherAgreesWithFSM)
+{
+    auto fsm = buildEmail();
+    FastMatcher matcher(*fsm);
+
+    for (const char *input : {"user@domain", "a@b", "@domain", "user@", "userdomain", ""})
+    {
+        EXPECT_EQ(fsm->validate(input), matcher.validate(input)) << input;
+        EXPECT_EQ(fsm->getCurrentState(), matcher.getCurrentState()) << input;
+    }
+}
+
+TEST_F(MatcherTest, PriorityOrderIsPreserved)
+{
+    auto fsm = FSM::Builder("priority")
+                   .addState("START", StateType::START)
+                   .addState("A")
+                   .addState("B")
+                   .addState("ACCEPT", StateType::ACCEPT)
+                   .setStartState("START")
+                   .addAcceptState("ACCEPT")
+                   .addTransition("START", "A", ABNF::literal('x'), Transition::PRIORITY_HIGH)
+                   .addTransition("START", "B", ABNF::literal('x'), Transition::PRIORITY_LOW)
+                   .addTransition("A", "ACCEPT", ABNF::literal('y'))
+                   .addTransition("B", "ACCEPT", ABNF::literal('z'))
+                   .build();
+
+    FastMatcher matcher(*fsm);
+
+    EXPECT_TRUE(matcher.validate("xy"));
+    EXPECT_FALSE(matcher.validate("xz"));
+}
+
+TEST_F(MatcherTest, EpsilonTransitionsAtEndOfInput)
+{
+    auto fsm = FSM::Builder("digits_then_accept")
+                   .addState("START", StateType::START)
+                   .addState("DIGITS")
+                   .addState("ACCEPT", StateType::ACCEPT)
+                   .setStartState("START")
+                   .addAcceptState("ACCEPT")
+                   .addTransition("START", "DIGITS", ABNF::digit())
+                   .addTransition("DIGITS", "DIGITS", ABNF::digit())
+                   .addEpsilonTransition("DIGITS", "ACCEPT")
+                   .build();
+
+    FastMatcher matcher(*fsm);
+
+    EXPECT_TRUE(matcher.validate("12345"));
+    EXPECT_EQ("ACCEPT", matcher.getCurrentState().name);
+    EXPECT_FALSE(matcher.validate(""));
+}
+
+TEST_F(MatcherTest, ProductionIgnoresDebugFlags)
+{
+    auto fsm = buildEmail(DebugFlags::TRACE_TRANSITIONS | DebugFlags::COLLECT_METRICS);
+    FastMatcher matcher(*fsm);
+
+    EXPECT_TRUE(matcher.validate("user@domain"));
+    EXPECT_TRUE(matcher.getTrace().empty());
+    EXPECT_EQ(0, matcher.getMetrics().transitions_taken);
+}
+
+TEST_F(MatcherTest, ErrorsAreRenderedOnDemand)
+{
+    auto fsm = buildEmail();
+    FastMatcher matcher(*fsm);
+
+    EXPECT_FALSE(matcher.validate("us3r@domain"));
+
+    auto error = matcher.getLastError();
+    ASSERT_TRUE(error.has_value());
+    EXPECT_EQ(FSM::ErrorType::NO_MATCHING_TRANSITION, error->type);
+    EXPECT_EQ(2, error->position);
+    EXPECT_EQ('3', error->character);
+    EXPECT_EQ("LOCAL", error->current_state.name);
+    EXPECT_NE(std::string::npos, error->message.find("LOCAL"));
+
+    EXPECT_TRUE(matcher.validate("user@domain"));
+    EXPECT_FALSE(matcher.getLastError().has_value());
+}
+
+TEST_F(MatcherTest, StreamingChunks)
+{
+    auto fsm = buildEmail();
+    FastMatcher matcher(*fsm);
+
+    EXPECT_EQ(StreamState::WAITING_FOR_INPUT, matcher.feed("user"));
+    EXPECT_EQ(StreamState::WAITING_FOR_INPUT, matcher.feed('@'));
+    EXPECT_EQ(StreamState::COMPLETE, matcher.feed("domain"));
+    EXPECT_EQ(StreamState::COMPLETE, matcher.endOfStream());
+
+    matcher.reset();
+    EXPECT_EQ(StreamState::WAITING_FOR_INPUT, matcher.feed("user"));
+    EXPECT_EQ(StreamState::ERROR, matcher.feed("!x"));
+    EXPECT_EQ(4, matcher.getLastError()->position);
+}
+
+// ============================================================================
+// Debug Policy Tests
+// ============================================================================
+
+TEST_F(MatcherTest, DebugMatcherTracesAndCollectsMetrics)
+{
+    std::ostringstream log;
+    auto fsm = buildEmail(DebugFlags::TRACE_TRANSITIONS | DebugFlags::COLLECT_METRICS);
+    fsm->getDebugConfig().log_stream = &log;
+
+    DebugMatcher matcher(*fsm);
+
+    EXPECT_TRUE(fsm->validate("ab@cd"));
+    EXPECT_TRUE(matcher.validate("ab@cd"));
+
+    ASSERT_EQ(fsm->getTrace().size(), matcher.getTrace().size());
+    for (size_t i = 0; i < matcher.getTrace().size(); ++i)
+    {
+        EXPECT_EQ(fsm->getTrace()[i].toString(), matcher.getTrace()[i].toString());
+    }
+
+    EXPECT_EQ(fsm->getMetrics().transitions_taken, matcher.getMetrics().transitions_taken);
+    EXPECT_EQ(fsm->getMetrics().states_visited, matcher.getMetrics().states_visited);
+    EXPECT_EQ(fsm->getMetrics().characters_processed, matcher.getMetrics().characters_processed);
+    EXPECT_NE(std::string::npos, log.str().find("[FSM:simple_email]"));
+}
+
+TEST_F(MatcherTest, DebugMatcherDispatchesCallbacksInOrder)
+{
+    std::vector<std::string> events;
+
+    auto fsm = FSM::Builder("callbacks")
+                   .addState("START", StateType::START)
+                   .addState("DIGITS")
+                   .addState("ACCEPT", StateType::ACCEPT)
+                   .setStartState("START")
+                   .addAcceptState("ACCEPT")
+                   .onStateEntry("DIGITS", [&events](const StateContext &ctx)
+                                 { events.push_back("enter@" + std::to_string(ctx.position)); })
+                   .onStateExit("DIGITS", [&events](const StateContext &ctx)
+                                { events.push_back("exit@" + std::to_string(ctx.position)); })
+                   .addTransition("START", "DIGITS", ABNF::digit())
+                   .onTransition([&events](const TransitionContext &ctx)
+                                 { events.push_back(std::string("first:") + ctx.input_char); })
+                   .addTransition("DIGITS", "DIGITS", ABNF::digit())
+                   .addEpsilonTransition("DIGITS", "ACCEPT")
+                   .build();
+
+    fsm->validate("12");
+    std::vector<std::string> expected = events;
+    events.clear();
+
+    DebugMatcher debug_matcher(*fsm);
+    EXPECT_TRUE(debug_matcher.validate("12"));
+    EXPECT_EQ(expected, events);
+
+    events.clear();
+    FastMatcher fast_matcher(*fsm);
+    EXPECT_TRUE(fast_matcher.validate("12"));
+    EXPECT_TRUE(events.empty());
+}
@@ -0,0 +1,239 @@
+#include <gtest/gtest.h>
+#include <fsm/fsm.hpp>
+#include <abnf/abnf.hpp>
+
+using namespace fsm;
+using namespace abnf;
+
+class PushdownTest : public ::testing::Test
+{
+protected:
+    void SetUp() override {}
+    void TearDown() override {}
+
+    // P = *( "(" P ")" )
+    static std::shared_ptr<FSM> buildParens()
+    {
+        return FSM::Builder("parens")
+            .addState("START", StateType::START)
+            .addState("OPEN")
+            .addState("INNER")
+            .setStartState("START")
+            .addAcceptState("START")
+            .addTransition("START", "OPEN", ABNF::literal('('))
+            .callSelf("OPEN", "INNER")
+            .addTransition("INNER", "START", ABNF::literal(')'))
+            .build();
+    }
+
+    // value = 1*DIGIT / "[" [ value *( "," value ) ] "]"
+    static std::shared_ptr<FSM> buildNestedArrays()
+    {
+        return FSM::Builder("value")
+            .addState("START", StateType::START)
+            .addState("NUMBER", StateType::ACCEPT)
+            .addState("OPEN")
+            .addState("ITEM")
+            .addState("COMMA")
+            .addState("DONE", StateType::ACCEPT)
+            .setStartState("START")
+            .addAcceptState("NUMBER")
+            .addAcceptState("DONE")
+            .addTransition("START", "NUMBER", ABNF::digit())
+            .addTransition("NUMBER", "NUMBER", ABNF::digit())
+            .addTransition("START", "OPEN", ABNF::literal('['))
+            .addTransition("OPEN", "DONE", ABNF::literal(']'))
+            .callSelf("OPEN", "ITEM")
+            .addTransition("ITEM", "COMMA", ABNF::literal(','))
+            .callSelf("COMMA", "ITEM")
+            .addTransition("ITEM", "DONE", ABNF::literal(']'))
+            .build();
+    }
+};
+
+// ============================================================================
+// Recursive Grammars
+// ============================================================================
+
+TEST_F(PushdownTest, BalancedParentheses)
+{
+    auto fsm = buildParens();
+
+    EXPECT_TRUE(fsm->validatePushdown(""));
+    EXPECT_TRUE(fsm->validatePushdown("()"));
+    EXPECT_TRUE(fsm->validatePushdown("(())"));
+    EXPECT_TRUE(fsm->validatePushdown("(()())"));
+    EXPECT_TRUE(fsm->validatePushdown("(())()"));
+    EXPECT_TRUE(fsm->validatePushdown("((()(())))"));
+    EXPECT_EQ(0, fsm->getCallDepth());
+}
+
+TEST_F(PushdownTest, UnbalancedParenthesesRejected)
+{
+    auto fsm = buildParens();
+
+    EXPECT_FALSE(fsm->validatePushdown("(()"));
+    ASSERT_TRUE(fsm->getLastError().has_value());
+    EXPECT_EQ(FSM::ErrorType::NOT_IN_ACCEPT_STATE, fsm->getLastError()->type);
+
+    EXPECT_FALSE(fsm->validatePushdown("())"));
+    ASSERT_TRUE(fsm->getLastError().has_value());
+    EXPECT_EQ(FSM::ErrorType::NO_MATCHING_TRANSITION, fsm->getLastError()->type);
+    EXPECT_EQ(2, fsm->getLastError()->position);
+}
+
+TEST_F(PushdownTest, NestedArrays)
+{
+    auto fsm = buildNestedArrays();
+
+    EXPECT_TRUE(fsm->validatePushdown("42"));
+    EXPECT_TRUE(fsm->validatePushdown("[]"));
+    EXPECT_TRUE(fsm->validatePushdown("[1,[2,3],[]]"));
+    EXPECT_TRUE(fsm->validatePushdown("[[[[7]]]]"));
+
+    EXPECT_FALSE(fsm->validatePushdown("[1,]"));
+    EXPECT_FALSE(fsm->validatePushdown("[[1]"));
+    EXPECT_FALSE(fsm->validatePushdown("[1]]"));
+}
+
+TEST_F(PushdownTest, CallDepthLimit)
+{
+    auto fsm = buildParens();
+    fsm->setMaxCallDepth(4);
+
+    EXPECT_EQ(4, fsm->getMaxCallDepth());
+    EXPECT_TRUE(fsm->validatePushdown("(((())))"));
+    EXPECT_FALSE(fsm->validatePushdown("((((((()))))))"));
+
+    ASSERT_TRUE(fsm->getLastError().has_value());
+    EXPECT_EQ(FSM::ErrorType::EMBEDDED_FSM_FAILED, fsm->getLastError()->type);
+}
+
+TEST_F(PushdownTest, CallToNullableMachineIsSkipped)
+{
+    // A = *"y" "x", with *"y" as a sub-machine
+    auto ys = FSM::Builder("ys")
+                  .addState("START", StateType::START)
+                  .setStartState("START")
+                  .addAcceptState("START")
+                  .addTransition("START", "START", ABNF::literal('y'))
+                  .build();
+
+    auto fsm = FSM::Builder("a")
+                   .addState("A", StateType::START)
+                   .setStartState("A")
+                   .callSubMachine("A", "C", ys)
+                   .addTransition("C", "D", ABNF::literal('x'))
+                   .addAcceptState("D")
+                   .build();
+
+    EXPECT_TRUE(fsm->validatePushdown("yx"));
+    EXPECT_TRUE(fsm->validatePushdown("yyyx"));
+    EXPECT_TRUE(fsm->validatePushdown("x"));
+    EXPECT_FALSE(fsm->validatePushdown(""));
+    EXPECT_FALSE(fsm->validatePushdown("yy"));
+
+    // At end of input the call is skipped on the way to an accept state.
+    auto optional = FSM::Builder("b")
+                        .addState("A", StateType::START)
+                        .setStartState("A")
+                        .callSubMachine("A", "C", ys)
+                        .addAcceptState("C")
+                        .build();
+
+    EXPECT_TRUE(optional->validatePushdown(""));
+    EXPECT_TRUE(optional->validatePushdown("yy"));
+}
+
+// ============================================================================
+// Shared Sub-machines
+// ============================================================================
+
+TEST_F(PushdownTest, SharedSubMachineIsNotCopied)
+{
+    auto number = FSM::Builder("number")
+                      .addState("START", StateType::START)
+                      .addState("DIGITS", StateType::ACCEPT)
+                      .setStartState("START")
+                      .addAcceptState("DIGITS")
+                      .addTransition("START", "DIGITS", ABNF::digit())
+                      .addTransition("DIGITS", "DIGITS", ABNF::digit())
+                      .build();
+
+    // "n.n.n.n"
+    auto dotted = FSM::Builder("dotted")
+                      .addState("S0", StateType::START)
+                      .setStartState("S0")
+                      .callSubMachine("S0", "N1", number)
+                      .addTransition("N1", "D1", ABNF::literal('.'))
+                      .callSubMachine("D1", "N2", number)
+                      .addTransition("N2", "D2", ABNF::literal('.'))
+                      .callSubMachine("D2", "N3", number)
+                      .addTransition("N3", "D3", ABNF::literal('.'))
+                      .callSubMachine("D3", "N4", number)
+                      .addAcceptState("N4")
+                      .build();
+
+    EXPECT_EQ(8, dotted->getStateCount());
+    EXPECT_EQ(7, dotted->getTransitionCount());
+
+    EXPECT_TRUE(dotted->validatePushdown("192.168.0.1"));
+    EXPECT_FALSE(dotted->validatePushdown("192.168..1"));
+    EXPECT_FALSE(dotted->validatePushdown("192.168.0"));
+}
+
+TEST_F(PushdownTest, SubMachineWithEpsilonExit)
+{
+    auto word = FSM::Builder("word")
+                    .addState("START", StateType::START)
+                    .addState("LETTERS")
+                    .addState("END", StateType::ACCEPT)
+                    .setStartState("START")
+                    .addAcceptState("END")
+                    .addTransition("START", "LETTERS", ABNF::alpha())
+                    .addTransition("LETTERS", "LETTERS", ABNF::alpha())
+                    .addEpsilonTransition("LETTERS", "END")
+                    .build();
+
+    auto pair = FSM::Builder("pair")
+                    .addState("START", StateType::START)
+                    .setStartState("START")
+                    .callSubMachine("START", "KEY", word)
+                    .addTransition("KEY", "EQ", ABNF::literal('='))
+                    .callSubMachine("EQ", "VALUE", word)
+                    .addAcceptState("VALUE")
+                    .build();
+
+    EXPECT_TRUE(pair->validatePushdown("key=value"));
+    EXPECT_FALSE(pair->validatePushdown("key="));
+    EXPECT_FALSE(pair->validatePushdown("=value"));
+}
+
+TEST_F(PushdownTest, RecursiveTransitionSurvivesMerge)
+{
+    // G = "(" *G ")"
+    auto group = FSM::Builder("group")
+                     .addState("START", StateType::START)
+                     .addState("OPEN")
+                     .addState("END", StateType::ACCEPT)
+                     .setStartState("START")
+                     .addAcceptState("END")
+                     .addTransition("START", "OPEN", ABNF::literal('('))
+                     .callSelf("OPEN", "OPEN")
+                     .addTransition("OPEN", "END", ABNF::literal(')'))
+                     .build();
+
+    auto wrapped = FSM::Builder("wrapped")
+                       .addState("START", StateType::START)
+                       .addState("BODY")
+                       .addState("ACCEPT", StateType::ACCEPT)
+                       .setStartState("START")
+                       .addAcceptState("ACCEPT")
+                       .addTransition("START", "BODY", ABNF::literal('<'))
+                       .addTransition("BODY", "ACCEPT", group)
+                       .build();
+
+    EXPECT_TRUE(wrapped->validatePushdown("<()"));
+    EXPECT_TRUE(wrapped->validatePushdown("<(()(()))"));
+    EXPECT_FALSE(wrapped->validatePushdown("<(()"));
+}
@@ -0,0 +1,381 @@
+#include <gtest/gtest.h>
+#include <fsm/search.hpp>
+#include <fsm/fsm.hpp>
+#include <abnf/abnf.hpp>
+#include <map>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace fsm;
+using namespace abnf;
+
+class SearchTest : public ::testing::Test
+{
+protected:
+    void SetUp() override {}
+    void TearDown() override {}
+
+    // 1*DIGIT
+    static std::shared_ptr<FSM> buildDigits()
+    {
+        return FSM::Builder("digits")
+            .addState("START", StateType::START)
+            .addState("DIGITS", StateType::ACCEPT)
+            .setStartState("START")
+            .addAcceptState("DIGITS")
+            .addTransition("START", "DIGITS", ABNF::digit())
+            .addTransition("DIGITS", "DIGITS", ABNF::digit())
+            .build();
+    }
+
+    // "ab" / "b" / "abcd" / "c"
+    static std::shared_ptr<FSM> buildWords()
+    {
+        return FSM::Builder("words")
+            .addState("START", StateType::START)
+            .addState("A")
+            .addState("AB", StateType::ACCEPT)
+            .addState("ABC")
+            .addState("ABCD", StateType::ACCEPT)
+            .addState("B", StateType::ACCEPT)
+            .addState("C", StateType::ACCEPT)
+            .setStartState("START")
+            .addAcceptState("AB")
+            .addAcceptState("ABCD")
+            .addAcceptState("B")
+            .addAcceptState("C")
+            .addTransition("START", "A", ABNF::literal('a'))
+            .addTransition("START", "B", ABNF::literal('b'))
+            .addTransition("START", "C", ABNF::literal('c'))
+            .addTransition("A", "AB", ABNF::literal('b'))
+            .addTransition("AB", "ABC", ABNF::literal('c'))
+            .addTransition("ABC", "ABCD", ABNF::literal('d'))
+            .build();
+    }
+
+    // *"x": accepts the empty string
+    static std::shared_ptr<FSM> buildXs()
+    {
+        return FSM::Builder("xs")
+            .addState("XS", StateType::START)
+            .setStartState("XS")
+            .addAcceptState("XS")
+            .addTransition("XS", "XS", ABNF::literal('x'))
+            .build();
+    }
+
+    // DQUOTE *(not DQUOTE) DQUOTE: long matches that straddle chunk bounds
+    static std::shared_ptr<FSM> buildQuoted()
+    {
+        const ABNF not_quote = ABNF(uint8_t{0x00}, uint8_t{0x21}) | ABNF(uint8_t{0x23}, uint8_t{0xFF});
+        return FSM::Builder("quoted")
+            .addState("START", StateType::START)
+            .addState("OPEN")
+            .addState("CLOSED", StateType::ACCEPT)
+            .setStartState("START")
+            .addAcceptState("CLOSED")
+            .addTransition("START", "OPEN", ABNF::literal('"'))
+            .addTransition("OPEN", "OPEN", not_quote)
+            .addTransition("OPEN", "CLOSED", ABNF::literal('"'))
+            .build();
+    }
+
+    // "GET" or "POST", each with its own accept state
+    static std::shared_ptr<FSM> buildMethods()
+    {
+        return FSM::Builder("methods")
+            .addState("START", StateType::START)
+            .addState("G")
+            .addState("GE")
+            .addState("GET", StateType::ACCEPT)
+            .addState("P")
+            .addState("PO")
+            .addState("POS")
+            .addState("POST", StateType::ACCEPT)
+            .setStartState("START")
+            .addAcceptState("GET")
+            .addAcceptState("POST")
+            .addTransition("START", "G", ABNF::literal('G'))
+            .addTransition("G", "GE", ABNF::literal('E'))
+            .addTransition("GE", "GET", ABNF::literal('T'))
+            .addTransition("START", "P", ABNF::literal('P'))
+            .addTransition("P", "PO", ABNF::literal('O'))
+            .addTransition("PO", "POS", ABNF::literal('S'))
+            .addTransition("POS", "POST", ABNF::literal('T'))
+            .build();
+    }
+
+    // "aa": over a run of a's, a search started at an odd offset pairs
+    // them the other way round and never restarts where the true one does
+    static std::shared_ptr<FSM> buildPairs()
+    {
+        return FSM::Builder("pairs")
+            .addState("START", StateType::START)
+            .addState("A")
+            .addState("AA", StateType::ACCEPT)
+            .setStartState("START")
+            .addAcceptState("AA")
+            .addTransition("START", "A", ABNF::literal('a'))
+            .addTransition("A", "AA", ABNF::literal('a'))
+            .build();
+    }
+
+    // "a" / 1*"a" "b": after each "a" the longest-match scan runs on to the
+    // end of a run of a's, looking for the "b"
+    static std::shared_ptr<FSM> buildRunThenB()
+    {
+        return FSM::Builder("run_then_b")
+            .addState("S", StateType::START)
+            .addState("A", StateType::ACCEPT)
+            .addState("L")
+            .addState("E", StateType::ACCEPT)
+            .setStartState("S")
+            .addAcceptState("A")
+            .addAcceptState("E")
+            .addTransition("S", "A", ABNF::literal('a'))
+            .addTransition("A", "L", ABNF::literal('a'))
+            .addTransition("A", "E", ABNF::literal('b'))
+            .addTransition("L", "L", ABNF::literal('a'))
+            .addTransition("L", "E", ABNF::literal('b'))
+            .build();
+    }
+
+    static std::string randomText(std::mt19937 &rng, const std::string &alphabet, size_t max_size)
+    {
+        std::string input(rng() % (max_size + 1), ' ');
+        for (char &ch : input)
+        {
+            ch = alphabet[rng() % alphabet.size()];
+        }
+        return input;
+    }
+
+    // The documented rule, by brute force: the earliest end, then the
+    // leftmost start for that end, then the longest match from there.
+    static std::optional<Searcher::Match> expectedFind(FSM &fsm, const std::string &input, size_t from)
+    {
+        for (size_t end = from; end <= input.size(); ++end)
+        {
+            for (size_t begin = from; begin <= end; ++begin)
+            {
+                if (fsm.validate(input.substr(begin, end - begin)))
+                {
+                    size_t longest = end;
+                    for (size_t e = end; e <= input.size(); ++e)
+                    {
+                        if (fsm.validate(input.substr(begin, e - begin)))
+                        {
+                            longest = e;
+                        }
+                    }
+                    return Searcher::Match{begin, longest};
+                }
+            }
+        }
+        return std::nullopt;
+    }
+};
+
+// ============================================================================
+// Span Tests
+// ============================================================================
+
+TEST_F(SearchTest, FindsExactSpans)
+{
+    Searcher numbers(*buildDigits());
+    const std::string text = "ab 123 c45 6";
+
+    auto first = numbers.find(text);
+    ASSERT_TRUE(first.has_value());
+    EXPECT_EQ((Searcher::Match{3, 6}), *first);
+    EXPECT_EQ("123", first->in(text));
+
+    const std::vector<Searcher::Match> all = numbers.findAll(text);
+    ASSERT_EQ(3u, all.size());
+    EXPECT_EQ("123", all[0].in(text));
+    EXPECT_EQ("45", all[1].in(text));
+    EXPECT_EQ("6", all[2].in(text));
+
+    EXPECT_EQ((Searcher::Match{4, 6}), *numbers.find(text, 4));
+    EXPECT_FALSE(numbers.find(text, 12).has_value());
+    EXPECT_FALSE(numbers.find(text, 99).has_value());
+    EXPECT_FALSE(numbers.contains("no digits here"));
+    EXPECT_TRUE(numbers.contains("x9"));
+}
+
+TEST_F(SearchTest, StartIsLeftmostForTheFirstEnd)
+{
+    Searcher words(*buildWords());
+
+    // "ab" and "b" both end at 2; the reverse scan widens to "ab".
+    EXPECT_EQ((Searcher::Match{1, 3}), *words.find("xab"));
+    // "ab" ends first, then the forward scan extends it to "abcd"...
+    EXPECT_EQ((Searcher::Match{0, 4}), *words.find("abcd"));
+    // ...but without the "d" it stops at "ab", and "c" follows.
+    EXPECT_EQ((std::vector<Searcher::Match>{{0, 2}, {2, 3}}), words.findAll("abcx"));
+}
+
+TEST_F(SearchTest, EmptyMatchesAdvance)
+{
+    Searcher xs(*buildXs());
+    const std::string text = "axxb";
+
+    EXPECT_EQ((std::vector<Searcher::Match>{{0, 0}, {1, 3}, {3, 3}, {4, 4}}), xs.findAll(text));
+    EXPECT_TRUE(xs.contains(""));
+}
+
+TEST_F(SearchTest, AgreesWithBruteForce)
+{
+    auto digits = buildDigits();
+    auto words = buildWords();
+    Searcher digit_search(*digits);
+    Searcher word_search(*words);
+
+    std::mt19937 rng(7);
+    for (int round = 0; round < 200; ++round)
+    {
+        const std::string input = randomText(rng, "abcd01 ", 11);
+        for (size_t from = 0; from <= input.size(); ++from)
+        {
+            EXPECT_EQ(expectedFind(*digits, input, from), digit_search.find(input, from)) << input << " @" << from;
+            EXPECT_EQ(expectedFind(*words, input, from), word_search.find(input, from)) << input << " @" << from;
+        }
+    }
+}
+
+TEST_F(SearchTest, LongestMatchScansEachRunOnce)
+{
+    auto run = buildRunThenB();
+    Searcher searcher(*run);
+
+    std::mt19937 rng(3);
+    for (int round = 0; round < 200; ++round)
+    {
+        const std::string input = randomText(rng, "aab", 12);
+        for (size_t from = 0; from <= input.size(); ++from)
+        {
+            EXPECT_EQ(expectedFind(*run, input, from), searcher.find(input, from)) << input << " @" << from;
+        }
+        EXPECT_EQ(searcher.findAll(input).size(), searcher.count(input)) << input;
+    }
+
+    // Every "a" is its own match, and each would otherwise rescan the rest
+    // of the run: quadratic, minutes at this size.
+    const std::string run_of_a(1 << 20, 'a');
+    EXPECT_EQ(run_of_a.size(), searcher.count(run_of_a));
+    EXPECT_EQ(run_of_a.size(), searcher.countParallel(run_of_a, 4));
+    EXPECT_EQ(1u, searcher.count(run_of_a + "b"));
+}
+
+// ============================================================================
+// Counting Tests
+// ============================================================================
+
+TEST_F(SearchTest, CountAgreesWithFindAll)
+{
+    Searcher numbers(*buildDigits());
+    Searcher xs(*buildXs());
+
+    EXPECT_EQ(3u, numbers.count("ab 123 c45 6"));
+    EXPECT_EQ(0u, numbers.count(""));
+    EXPECT_EQ(xs.findAll("axxb").size(), xs.count("axxb"));
+}
+
+TEST_F(SearchTest, ParallelCountStitchesChunks)
+{
+    const std::vector<std::shared_ptr<FSM>> machines{buildDigits(), buildWords(), buildXs(), buildQuoted()};
+    std::mt19937 rng(11);
+
+    for (const auto &machine : machines)
+    {
+        Searcher searcher(*machine);
+        for (int round = 0; round < 100; ++round)
+        {
+            const std::string input = randomText(rng, "abcdx01\" ", 64);
+            const size_t expected = searcher.count(input);
+            for (unsigned threads = 2; threads <= 9; ++threads)
+            {
+                EXPECT_EQ(expected, searcher.countParallel(input, threads))
+                    << machine->getName() << " '" << input << "' on " << threads;
+            }
+        }
+    }
+
+    // One match spanning every chunk
+    Searcher quoted(*buildQuoted());
+    const std::string spanning = "\"" + std::string(1000, 'a') + "\"";
+    EXPECT_EQ(1u, quoted.countParallel(spanning, 8));
+    EXPECT_EQ(0u, quoted.countParallel(std::string(1000, 'a'), 8));
+
+    // Chunks entered at odd offsets line up with their second track.
+    Searcher pairs(*buildPairs());
+    for (size_t size : {999u, 1000u, 1001u, 1003u})
+    {
+        const std::string run(size, 'a');
+        for (unsigned threads = 2; threads <= 9; ++threads)
+        {
+            EXPECT_EQ(size / 2, pairs.countParallel(run, threads)) << size << " on " << threads;
+        }
+    }
+}
+
+TEST_F(SearchTest, CountsRecordsByAcceptState)
+{
+    auto methods = buildMethods();
+    const CompiledFSM compiled(*methods);
+    const std::string lines = "GET\nPOST\nPUT\n\nGETS\nPOST\nGET";
+
+    const RecordCounts counts = countRecords(compiled, lines);
+    EXPECT_EQ(7u, counts.records);
+    EXPECT_EQ(4u, counts.accepted);
+
+    std::map<std::string, size_t> by_name;
+    for (size_t s = 0; s < counts.by_state.size(); ++s)
+    {
+        if (counts.by_state[s] != 0)
+        {
+            by_name[compiled.getStateID(static_cast<CompiledFSM::StateIndex>(s)).name] = counts.by_state[s];
+        }
+    }
+    EXPECT_EQ((std::map<std::string, size_t>{{"GET", 2}, {"POST", 2}}), by_name);
+
+    // A trailing separator ends the last record rather than adding one.
+    EXPECT_EQ(7u, countRecords(compiled, lines + "\n").records);
+    EXPECT_EQ(0u, countRecords(compiled, "").records);
+}
+
+TEST_F(SearchTest, ParallelRecordCountsMatch)
+{
+    const CompiledFSM compiled(*buildMethods());
+    std::mt19937 rng(5);
+
+    for (int round = 0; round < 200; ++round)
+    {
+        const std::string input = randomText(rng, "GETPOS\n", 40);
+        const RecordCounts expected = countRecords(compiled, input);
+        for (unsigned threads = 2; threads <= 7; ++threads)
+        {
+            const RecordCounts counts = countRecords(compiled, input, '\n', threads);
+            EXPECT_EQ(expected.records, counts.records) << input;
+            EXPECT_EQ(expected.accepted, counts.accepted) << input;
+            EXPECT_EQ(expected.by_state, counts.by_state) << input;
+        }
+    }
+}
+
+TEST_F(SearchTest, RejectsMachinesWithoutATable)
+{
+    auto ambiguous = FSM::Builder("ambiguous")
+                         .addState("START", StateType::START)
+                         .addState("A", StateType::ACCEPT)
+                         .addState("B", StateType::ACCEPT)
+                         .setStartState("START")
+                         .addAcceptState("A")
+                         .addAcceptState("B")
+                         .addTransition("START", "A", ABNF::literal('x'))
+                         .addTransition("START", "B", ABNF::literal('x'))
+                         .build();
+    EXPECT_THROW(Searcher{*ambiguous}, std::invalid_argument);
+}
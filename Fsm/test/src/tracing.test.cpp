@@ -0,0 +1,178 @@
+#include <gtest/gtest.h>
+#include <fsm/fsm.hpp>
+#include <fsm/matcher.hpp>
+#include <fsm/tracing.hpp>
+#include <abnf/abnf.hpp>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace fsm;
+using namespace abnf;
+
+class TracingTest : public ::testing::Test
+{
+protected:
+    void SetUp() override {}
+    void TearDown() override {}
+
+    static std::shared_ptr<FSM> buildDigits()
+    {
+        return FSM::Builder("digits")
+            .addState("START", StateType::START)
+            .addState("DIGITS")
+            .addState("ACCEPT", StateType::ACCEPT)
+            .setStartState("START")
+            .addAcceptState("ACCEPT")
+            .addTransition("START", "DIGITS", ABNF::digit())
+            .addTransition("DIGITS", "DIGITS", ABNF::digit())
+            .addEpsilonTransition("DIGITS", "ACCEPT")
+            .build();
+    }
+};
+
+// ============================================================================
+// RingTracer Tests
+// ============================================================================
+
+TEST_F(TracingTest, CapacityMustBePowerOfTwo)
+{
+    EXPECT_THROW(RingTracer(100), std::invalid_argument);
+    EXPECT_THROW(RingTracer(64, 0), std::invalid_argument);
+    EXPECT_NO_THROW(RingTracer(64));
+}
+
+TEST_F(TracingTest, RingKeepsNewestRecords)
+{
+    RingTracer tracer(4);
+    for (uint32_t i = 0; i < 10; ++i)
+    {
+        tracer.record(TraceRecord{0, i, 1, 2, 3, 'a', 0});
+    }
+
+    auto records = tracer.snapshot();
+    ASSERT_EQ(4, records.size());
+    EXPECT_EQ(6, records.front().step);
+    EXPECT_EQ(9, records.back().step);
+    EXPECT_EQ(10, tracer.getRecorded());
+
+    tracer.clear();
+    EXPECT_TRUE(tracer.snapshot().empty());
+}
+
+TEST_F(TracingTest, ConcurrentWritersProduceIntactRecords)
+{
+    RingTracer tracer(256);
+    std::vector<std::thread> writers;
+
+    for (uint32_t t = 0; t < 4; ++t)
+    {
+        writers.emplace_back([&tracer, t]()
+                             {
+                                 for (uint32_t i = 0; i < 10000; ++i)
+                                 {
+                                     tracer.record(TraceRecord{t, i, t, t, t, static_cast<uint8_t>(t), 0});
+                                 } });
+    }
+    for (auto &writer : writers)
+    {
+        writer.join();
+    }
+
+    for (const auto &record : tracer.snapshot())
+    {
+        EXPECT_EQ(record.validation, record.from);
+        EXPECT_EQ(record.validation, record.transition);
+        EXPECT_EQ(record.validation, record.byte);
+    }
+}
+
+// ============================================================================
+// FSM Integration
+// ============================================================================
+
+TEST_F(TracingTest, FSMRecordsSteps)
+{
+    auto fsm = buildDigits();
+    auto tracer = std::make_shared<RingTracer>(64);
+    fsm->setTracer(tracer);
+
+    EXPECT_TRUE(fsm->validate("42"));
+
+    auto records = tracer->snapshot();
+    ASSERT_EQ(3, records.size());
+    EXPECT_EQ('4', records[0].byte);
+    EXPECT_EQ(1, records[1].step);
+    EXPECT_TRUE(records[2].isEpsilon());
+
+    std::string text = trace::toText(records, fsm.get());
+    EXPECT_NE(std::string::npos, text.find("START -> DIGITS on '4'"));
+    EXPECT_NE(std::string::npos, text.find("DIGITS -> ACCEPT on ε"));
+
+    std::string dot = trace::toDot(records, *fsm);
+    EXPECT_NE(std::string::npos, dot.find("x1\", color=red"));
+    EXPECT_NE(std::string::npos, dot.find("digraph TRACE_digits"));
+}
+
+TEST_F(TracingTest, SamplingTracesOneInN)
+{
+    auto fsm = buildDigits();
+    auto tracer = std::make_shared<RingTracer>(1024, 4);
+    fsm->setTracer(tracer);
+
+    for (int i = 0; i < 8; ++i)
+    {
+        fsm->validate("123");
+    }
+
+    // setTracer() takes sequence number 0, so validations 4 and 8 are traced.
+    auto records = tracer->snapshot();
+    EXPECT_EQ(8, records.size());
+    EXPECT_EQ(4, records.front().validation);
+    EXPECT_EQ(8, records.back().validation);
+}
+
+TEST_F(TracingTest, MatcherMatchesInterpreterTrace)
+{
+    auto fsm = buildDigits();
+    auto fsm_tracer = std::make_shared<RingTracer>(64);
+    fsm->setTracer(fsm_tracer);
+    fsm->validate("123");
+
+    auto matcher_tracer = std::make_shared<RingTracer>(64);
+    InstrumentedMatcher matcher(*fsm);
+    matcher.setTracer(matcher_tracer);
+    matcher.validate("123");
+
+    auto expected = fsm_tracer->snapshot();
+    auto actual = matcher_tracer->snapshot();
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+        EXPECT_EQ(expected[i].from, actual[i].from);
+        EXPECT_EQ(expected[i].to, actual[i].to);
+        EXPECT_EQ(expected[i].transition, actual[i].transition);
+        EXPECT_EQ(expected[i].flags, actual[i].flags);
+    }
+}
+
+// ============================================================================
+// Binary Format
+// ============================================================================
+
+TEST_F(TracingTest, BinaryRoundTrip)
+{
+    auto fsm = buildDigits();
+    auto tracer = std::make_shared<RingTracer>(64);
+    fsm->setTracer(tracer);
+    fsm->validate("7");
+
+    std::stringstream buffer;
+    tracer->write(buffer);
+
+    auto records = trace::read(buffer);
+    EXPECT_EQ(trace::toText(tracer->snapshot(), fsm.get()), trace::toText(records, fsm.get()));
+
+    std::stringstream bad("NOTATRACE");
+    EXPECT_THROW(trace::read(bad), std::runtime_error);
+}